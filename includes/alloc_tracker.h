@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Counts every allocation made through the global operator new (replaced in
+// alloc_tracker.cpp) and through ImGui, which main.cpp routes here. Each
+// allocation is charged to the tag of the innermost Scope on its thread:
+//
+//   AllocTracker::Scope scope(AllocTracker::Physics);
+//
+// main.cpp closes a frame with endFrame(); the per-frame counts of the frame
+// before are then read with lastFrame(). Counting is a few relaxed atomic
+// adds per allocation, and each block carries a 16-byte header with its
+// size and tag, so frees are charged to the tag that allocated.
+//
+// HotRegion marks steady-state code that must not allocate once warmed up:
+// a plain physics step, the per-frame uploads, recording the draws and
+// submitting them. Event handling (UI, a landed shot, a rebuild) stays
+// outside, and what is left inside has its buffers reserved beforehand.
+// Allocations inside one are counted; in strict mode, after the warm-up
+// frames, any allocation inside one aborts the run with its size and tag,
+// which is how the allocation-free loops are kept that way. Tasks started
+// from inside a region run inside one too, on whichever thread takes
+// them. ImGui manages its own buffers, so its allocations are exempt.
+class AllocTracker {
+public:
+    enum Tag : uint8_t {
+        Other,
+        Physics,
+        Render,         // simulation render() and vertex building
+        Gui,            // ImGui
+        Shaders,        // shader loading
+        TagCount
+    };
+
+    struct Stats {
+        uint64_t allocations = 0;       // in the frame
+        uint64_t frees = 0;
+        uint64_t bytes = 0;             // allocated in the frame
+        uint64_t liveBytes = 0;         // now, and the most ever
+        uint64_t peakLiveBytes = 0;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(Tag tag);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Tag previous;
+    };
+
+    class HotRegion {
+    public:
+        HotRegion();
+        ~HotRegion();
+        HotRegion(const HotRegion&) = delete;
+        HotRegion& operator=(const HotRegion&) = delete;
+    };
+
+    // Puts this thread in or out of a hot region until destroyed; the job
+    // system runs each task in the state of the code that started it
+    class HotState {
+    public:
+        explicit HotState(bool hot);
+        ~HotState();
+        HotState(const HotState&) = delete;
+        HotState& operator=(const HotState&) = delete;
+
+    private:
+        int previous;
+    };
+    static bool inHotRegion();
+
+    static const char* tagName(Tag tag);
+
+    static void endFrame();
+    static uint64_t getFrameCount();
+    static Stats lastFrame(Tag tag);
+    // Over all tags
+    static Stats lastFrameTotal();
+
+    static void setStrict(bool strict, uint64_t warmupFrames);
+    static bool isStrict();
+    // Allocations inside hot regions so far, and in the last frame
+    static uint64_t getHotAllocations();
+    static uint64_t getLastFrameHotAllocations();
+
+    // The tracked allocator behind operator new, for callers outside C++'s
+    // new (ImGui). release(nullptr) does nothing.
+    static void* allocate(size_t bytes);
+    static void release(void* pointer);
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+// How a cannonball flies when it is not the interactive simulation: used by
+// the offline tools and the range tables. Drag is quadratic in the speed
+// relative to the air, so wind only acts through it.
+struct BallisticsModel {
+    float gravity = 9.81f;
+    float drag = 0.0f;      // per metre: acceleration = -drag * |v - wind| * (v - wind)
+    float wind = 0.0f;      // horizontal, m/s
+};
+
+struct Flight {
+    float range = 0.0f;     // where it comes back down to launch height
+    float apex = 0.0f;      // highest point above the launch height
+    float time = 0.0f;
+    bool landed = true;     // false if still in the air when the step cap ran out
+};
+
+// Launched from and landing on flat ground. Closed form without drag,
+// otherwise RK4 with a step scaled to the drag-free flight time. A flight
+// that has not landed after the step cap comes back with landed unset and
+// range and time where it had got to.
+Flight flyToGround(const BallisticsModel& model, float angleDegrees, float speed);
@@ -0,0 +1,32 @@
+#pragma once
+#include "scenario.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Outcome of one scenario; only the fields of its simulation are set
+struct ScenarioResult {
+    // Projectile, over flat ground from the cannon
+    float range = 0.0f;
+    float apex = 0.0f;              // highest point above the cannon
+    float flightTime = 0.0f;
+    float targetMiss = 0.0f;        // landing point to target
+    bool hit = false;
+
+    // Refraction at a single flat interface
+    float refractionAngle = 0.0f;   // degrees, 0 under total internal reflection
+    float reflectance = 0.0f;       // for the scenario's polarization
+    bool totalInternalReflection = false;
+};
+
+// Runs every scenario on the job system. Each run writes only its own
+// slot, so results[i] belongs to scenarios[i] however the runs were spread.
+std::vector<ScenarioResult> runScenarios(const std::vector<Scenario>& scenarios);
+
+// One CSV row per scenario, in scenario order
+void writeResults(FILE* out, const std::vector<Scenario>& scenarios,
+                  const std::vector<ScenarioResult>& results);
+
+// Headless entry point for --batch: loads the scenarios, runs them and
+// writes the CSV to outputPath ("-" for stdout). Returns the exit code.
+int runBatch(const std::string& scenarioPath, const std::string& outputPath);
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Two circles that overlap; a < b
+struct BodyPair {
+    uint32_t a, b;
+};
+
+// Finds the overlapping pairs among a set of circles without testing all
+// n^2 of them. Bodies come in as plain arrays (structure of arrays) so any
+// simulation can feed its own storage. Rebuilt from scratch every step.
+class Broadphase {
+public:
+    virtual ~Broadphase() = default;
+    virtual const char* name() const = 0;
+
+    virtual void build(const float* x, const float* y, const float* radius, size_t count) = 0;
+
+    // Replaces pairs with every overlapping pair, in a deterministic order
+    virtual void findPairs(std::vector<BodyPair>& pairs) = 0;
+
+    // Room for count bodies averaging PAIRS_PER_BODY pairs each (a packed
+    // circle touches six others, so three pairs, plus slack), so steps at
+    // that size allocate nothing
+    static constexpr size_t PAIRS_PER_BODY = 4;
+    virtual void reserve(size_t count);
+
+protected:
+    // Pair search is split into a fixed number of chunks, each with its own
+    // output list, so threads never share a vector and the result does not
+    // depend on how many threads ran
+    static constexpr size_t PAIR_CHUNKS = 64;
+    std::vector<std::vector<BodyPair>> chunkPairs{PAIR_CHUNKS};
+
+    void gatherPairs(std::vector<BodyPair>& pairs) const;
+};
+
+// Uniform grid hashed into a table twice the body count. Each body goes in
+// the cell holding its centre; cells are at least one diameter wide, so
+// overlaps only happen between neighbouring cells. Bodies are counting-
+// sorted by bucket into contiguous arrays, so a cell's bodies are adjacent
+// in memory when the 3x3 neighbourhood is scanned.
+class SpatialHashGrid : public Broadphase {
+public:
+    const char* name() const override { return "Spatial Hash"; }
+    void build(const float* x, const float* y, const float* radius, size_t count) override;
+    void findPairs(std::vector<BodyPair>& pairs) override;
+    void reserve(size_t count) override;
+
+    // Smallest cell size to use; raised to the largest diameter if needed
+    void setCellSize(float size) { minCellSize = size; }
+    float getCellSize() const { return cellSize; }
+
+private:
+    float minCellSize = 0.0f;
+    float cellSize = 1.0f;
+    uint32_t tableMask = 0;
+    std::vector<uint32_t> bucketOf;     // per body
+    std::vector<uint32_t> bucketStart;  // tableSize + 1 offsets into the sorted arrays
+    std::vector<uint32_t> sortedBody;   // original body index, by sorted position
+    std::vector<float> sortedX, sortedY, sortedRadius;
+
+    uint32_t rowStride = 1;
+
+    static uint32_t tableSizeFor(size_t count);
+
+    // Row-major with wrap-around rather than a scrambling hash: cells next
+    // to each other land in neighbouring buckets, so the sorted arrays keep
+    // the spatial layout and the 3x3 scan stays in cache
+    uint32_t bucket(int cellX, int cellY) const {
+        return (static_cast<uint32_t>(cellX) + static_cast<uint32_t>(cellY) * rowStride) & tableMask;
+    }
+};
+
+// Bodies sorted by the left edge of their bounding box; each body is only
+// tested against the ones that start before it ends. The order is kept
+// between steps and repaired with an insertion sort, which is nearly linear
+// while bodies move a little per step.
+class SweepAndPrune : public Broadphase {
+public:
+    const char* name() const override { return "Sweep and Prune"; }
+    void build(const float* x, const float* y, const float* radius, size_t count) override;
+    void findPairs(std::vector<BodyPair>& pairs) override;
+    void reserve(size_t count) override;
+
+private:
+    std::vector<uint32_t> order;        // body index, by sorted position
+    std::vector<float> minX;            // per body
+    std::vector<float> sortedMinX, sortedMaxX, sortedX, sortedY, sortedRadius;
+};
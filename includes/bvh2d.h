@@ -0,0 +1,216 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Axis aligned bounding box in the simulation plane
+struct Aabb2D {
+    glm::vec2 min = glm::vec2(1e30f);
+    glm::vec2 max = glm::vec2(-1e30f);
+
+    void grow(const glm::vec2& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    void grow(const Aabb2D& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+    glm::vec2 center() const { return (min + max) * 0.5f; }
+    // 2D "surface area" is the perimeter, which is what the SAH needs here
+    float perimeter() const {
+        glm::vec2 e = max - min;
+        return (e.x < 0.0f || e.y < 0.0f) ? 0.0f : 2.0f * (e.x + e.y);
+    }
+};
+
+// Flat BVH over arbitrary 2D primitives, built with a binned SAH.
+// The tree only knows about bounding boxes; callers supply the exact
+// primitive test while traversing.
+class Bvh2D {
+public:
+    struct Node {
+        Aabb2D bounds;
+        int leftFirst;  // left child index for interior nodes, first primitive for leaves
+        int count;      // 0 for interior nodes
+    };
+
+    void build(const std::vector<Aabb2D>& primitiveBounds);
+    void clear() { nodes.clear(); primitiveIndices.clear(); }
+
+    const std::vector<Node>& getNodes() const { return nodes; }
+    const std::vector<int>& getPrimitiveIndices() const { return primitiveIndices; }
+    bool empty() const { return nodes.empty(); }
+
+    // Walks every leaf the ray can reach before tMax, nearest first.
+    // hitFn(primitiveIndex, tMax) tests one primitive and shrinks tMax on a hit.
+    template <typename HitFn>
+    void intersect(const glm::vec2& origin, const glm::vec2& direction,
+                   float& tMax, HitFn&& hitFn) const;
+
+    // Packet version of intersect(): one traversal for Lanes rays at once.
+    // A node is entered when any active lane reaches it. hitFn(primitiveIndex,
+    // tMax) tests every lane against one primitive and shrinks tMax per lane.
+    template <int Lanes, typename HitFn>
+    void intersectPacket(const float* originX, const float* originY,
+                         const float* directionX, const float* directionY,
+                         float* tMax, unsigned activeMask, HitFn&& hitFn) const;
+
+    // Visits every primitive whose box overlaps the query box
+    template <typename VisitFn>
+    void query(const Aabb2D& box, VisitFn&& visitFn) const;
+
+private:
+    static constexpr int BIN_COUNT = 16;
+    static constexpr int MAX_LEAF_SIZE = 4;
+    static constexpr float TRAVERSAL_COST = 1.0f;
+    static constexpr int STACK_SIZE = 64;
+
+    std::vector<Node> nodes;
+    std::vector<int> primitiveIndices;
+    std::vector<glm::vec2> centroids;
+
+    void subdivide(int nodeIndex, const std::vector<Aabb2D>& primitiveBounds);
+
+    static float slabTest(const Aabb2D& box, const glm::vec2& origin,
+                          const glm::vec2& invDirection, float tMax) {
+        glm::vec2 t0 = (box.min - origin) * invDirection;
+        glm::vec2 t1 = (box.max - origin) * invDirection;
+        glm::vec2 tNear = glm::min(t0, t1);
+        glm::vec2 tFar = glm::max(t0, t1);
+        float tEnter = glm::max(tNear.x, tNear.y);
+        float tExit = glm::min(tFar.x, tFar.y);
+        if (tExit >= glm::max(tEnter, 0.0f) && tEnter < tMax) return tEnter;
+        return 1e30f;
+    }
+};
+
+template <typename HitFn>
+void Bvh2D::intersect(const glm::vec2& origin, const glm::vec2& direction,
+                      float& tMax, HitFn&& hitFn) const {
+    if (nodes.empty()) return;
+
+    glm::vec2 invDirection(1.0f / direction.x, 1.0f / direction.y);
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    int nodeIndex = 0;
+    if (slabTest(nodes[0].bounds, origin, invDirection, tMax) >= 1e30f) return;
+
+    while (true) {
+        const Node& node = nodes[nodeIndex];
+        if (node.count > 0) {
+            for (int i = 0; i < node.count; i++) {
+                hitFn(primitiveIndices[node.leftFirst + i], tMax);
+            }
+        } else {
+            int nearChild = node.leftFirst;
+            int farChild = node.leftFirst + 1;
+            float tNear = slabTest(nodes[nearChild].bounds, origin, invDirection, tMax);
+            float tFar = slabTest(nodes[farChild].bounds, origin, invDirection, tMax);
+            if (tFar < tNear) {
+                std::swap(tNear, tFar);
+                std::swap(nearChild, farChild);
+            }
+            if (tNear < 1e30f) {
+                if (tFar < 1e30f && stackSize < STACK_SIZE) stack[stackSize++] = farChild;
+                nodeIndex = nearChild;
+                continue;
+            }
+        }
+
+        // Pop until we find a node that is still closer than the current hit
+        bool found = false;
+        while (stackSize > 0) {
+            nodeIndex = stack[--stackSize];
+            if (slabTest(nodes[nodeIndex].bounds, origin, invDirection, tMax) < 1e30f) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) return;
+    }
+}
+
+template <int Lanes, typename HitFn>
+void Bvh2D::intersectPacket(const float* originX, const float* originY,
+                            const float* directionX, const float* directionY,
+                            float* tMax, unsigned activeMask, HitFn&& hitFn) const {
+    if (nodes.empty() || activeMask == 0) return;
+
+    // Inactive lanes get a negative tMax so they never pass a slab test
+    float invX[Lanes], invY[Lanes], laneMax[Lanes];
+    for (int l = 0; l < Lanes; l++) {
+        invX[l] = 1.0f / directionX[l];
+        invY[l] = 1.0f / directionY[l];
+    }
+
+    int firstLane = 0;
+    while (!((activeMask >> firstLane) & 1u)) firstLane++;
+
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        // Branch-free lane loop so the compiler can keep it in vector registers
+        for (int l = 0; l < Lanes; l++) {
+            laneMax[l] = ((activeMask >> l) & 1u) ? tMax[l] : -1.0f;
+        }
+        int anyHit = 0;
+        for (int l = 0; l < Lanes; l++) {
+            float tx0 = (node.bounds.min.x - originX[l]) * invX[l];
+            float tx1 = (node.bounds.max.x - originX[l]) * invX[l];
+            float ty0 = (node.bounds.min.y - originY[l]) * invY[l];
+            float ty1 = (node.bounds.max.y - originY[l]) * invY[l];
+            float tEnter = std::max(std::min(tx0, tx1), std::min(ty0, ty1));
+            float tExit = std::min(std::max(tx0, tx1), std::max(ty0, ty1));
+            anyHit |= (tExit >= std::max(tEnter, 0.0f)) & (tEnter < laneMax[l]);
+        }
+        if (!anyHit) continue;
+
+        if (node.count > 0) {
+            for (int i = 0; i < node.count; i++) {
+                hitFn(primitiveIndices[node.leftFirst + i], tMax);
+            }
+        } else if (stackSize + 2 <= STACK_SIZE) {
+            // Visit the child nearer along the first lane's ray first so tMax
+            // shrinks early; lanes of a packet usually travel together
+            int nearChild = node.leftFirst;
+            int farChild = node.leftFirst + 1;
+            glm::vec2 toNear = nodes[nearChild].bounds.center() - glm::vec2(originX[firstLane], originY[firstLane]);
+            glm::vec2 toFar = nodes[farChild].bounds.center() - glm::vec2(originX[firstLane], originY[firstLane]);
+            glm::vec2 firstDirection(directionX[firstLane], directionY[firstLane]);
+            if (glm::dot(toFar, firstDirection) < glm::dot(toNear, firstDirection)) {
+                std::swap(nearChild, farChild);
+            }
+            stack[stackSize++] = farChild;
+            stack[stackSize++] = nearChild;
+        }
+    }
+}
+
+template <typename VisitFn>
+void Bvh2D::query(const Aabb2D& box, VisitFn&& visitFn) const {
+    if (nodes.empty()) return;
+
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+        if (node.bounds.max.x < box.min.x || node.bounds.min.x > box.max.x ||
+            node.bounds.max.y < box.min.y || node.bounds.min.y > box.max.y) {
+            continue;
+        }
+        if (node.count > 0) {
+            for (int i = 0; i < node.count; i++) {
+                visitFn(primitiveIndices[node.leftFirst + i]);
+            }
+        } else if (stackSize + 2 <= STACK_SIZE) {
+            stack[stackSize++] = node.leftFirst;
+            stack[stackSize++] = node.leftFirst + 1;
+        }
+    }
+}
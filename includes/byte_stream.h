@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Little helpers for the binary log formats. Integers are LEB128 varints,
+// signed ones zigzagged first so small negative numbers stay short.
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void putByte(uint8_t value) { out.push_back(value); }
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+    void putSigned(int64_t value) { putVarint(zigzag(value)); }
+    void putBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+    // Raw little-endian (every platform this builds on is)
+    void putU32(uint32_t value) { putBytes(&value, sizeof(value)); }
+    void putU64(uint64_t value) { putBytes(&value, sizeof(value)); }
+    void putFloat(float value) { putBytes(&value, sizeof(value)); }
+    void putFloats(const std::vector<float>& values) {
+        putVarint(values.size());
+        if (!values.empty()) putBytes(values.data(), values.size() * sizeof(float));
+    }
+    void putString(const std::string& value) {
+        putVarint(value.size());
+        putBytes(value.data(), value.size());
+    }
+
+private:
+    std::vector<uint8_t>& out;
+};
+
+// Reads what ByteWriter wrote; running off the end throws
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : cursor(data), end(data + size) {}
+
+    bool atEnd() const { return cursor == end; }
+    size_t remaining() const { return static_cast<size_t>(end - cursor); }
+    const uint8_t* position() const { return cursor; }
+
+    uint8_t getByte() {
+        need(1);
+        return *cursor++;
+    }
+    uint64_t getVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = getByte();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed varint");
+    }
+    int64_t getSigned() { return unzigzag(getVarint()); }
+    const uint8_t* getBytes(size_t size) {
+        need(size);
+        const uint8_t* start = cursor;
+        cursor += size;
+        return start;
+    }
+    uint32_t getU32() { uint32_t value; std::memcpy(&value, getBytes(sizeof(value)), sizeof(value)); return value; }
+    uint64_t getU64() { uint64_t value; std::memcpy(&value, getBytes(sizeof(value)), sizeof(value)); return value; }
+    float getFloat() { float value; std::memcpy(&value, getBytes(sizeof(value)), sizeof(value)); return value; }
+    void getFloats(std::vector<float>& values) {
+        size_t count = static_cast<size_t>(getVarint());
+        if (count > remaining() / sizeof(float)) throw std::runtime_error("Unexpected end of data");
+        values.resize(count);
+        if (count) std::memcpy(values.data(), getBytes(count * sizeof(float)), count * sizeof(float));
+    }
+    std::string getString() {
+        size_t size = static_cast<size_t>(getVarint());
+        const uint8_t* bytes = getBytes(size);
+        return std::string(reinterpret_cast<const char*>(bytes), size);
+    }
+
+private:
+    const uint8_t* cursor;
+    const uint8_t* end;
+
+    void need(size_t size) const {
+        if (size > remaining()) throw std::runtime_error("Unexpected end of data");
+    }
+};
+
+// FNV-1a over 32-bit words, for spotting state that differs between runs
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    size_t words = size / 4;
+    for (size_t i = 0; i < words; i++) {
+        uint32_t word;
+        std::memcpy(&word, bytes + 4 * i, 4);
+        hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    for (size_t i = words * 4; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Wavelength dependent refractive index. Wavelengths are in nanometres.
+struct DispersionModel {
+    enum Type { Constant, Cauchy, Sellmeier };
+    Type type = Constant;
+    // Constant: a[0] = n
+    // Cauchy:   n = a[0] + a[1] / l^2 + a[2] / l^4   (l in micrometres)
+    // Sellmeier: n^2 = 1 + sum b[i] l^2 / (l^2 - c[i]) (l in micrometres)
+    float a[3] = { 1.0f, 0.0f, 0.0f };
+    float b[3] = { 0.0f, 0.0f, 0.0f };
+    float c[3] = { 0.0f, 0.0f, 0.0f };
+
+    float indexAt(float wavelength) const;
+
+    static DispersionModel constant(float n);
+    static DispersionModel cauchy(float a0, float a1, float a2 = 0.0f);
+    static DispersionModel sellmeier(const float (&b)[3], const float (&c)[3]);
+};
+
+// Named presets for common optical media
+enum class DispersionPreset {
+    Custom,      // constant index taken from the UI slider
+    Water,
+    CrownGlass,
+    BK7,
+    FusedSilica,
+    FlintSF11,
+    Count
+};
+
+const char* dispersionPresetName(DispersionPreset preset);
+DispersionModel dispersionPreset(DispersionPreset preset, float customIndex);
+
+// Visible range traced by the spectral mode
+constexpr float WAVELENGTH_MIN = 380.0f;
+constexpr float WAVELENGTH_MAX = 720.0f;
+// Sodium D line, where the scalar index of a dispersive material is quoted
+constexpr float WAVELENGTH_REFERENCE = 589.3f;
+
+// Linear sRGB colour of a single wavelength, scaled so that an evenly
+// sampled white spectrum adds up to roughly (1, 1, 1) per sample
+glm::vec3 wavelengthToRgb(float wavelength);
@@ -0,0 +1,51 @@
+#pragma once
+#include <glad/glad.h>
+#include "optical_scene.h"
+#include "ray_tree.h"
+
+// GPU ray tracing through transform feedback, for large ray sets. Each
+// source ray is one point; a geometry shader walks it through the scene
+// BVH (stored in texture buffers) and writes its line segments straight
+// into a vertex buffer that is then drawn, so the CPU never touches them.
+//
+// Unlike traceFresnelTree only the stronger child is followed at each
+// interface, so a ray is a single path of at most MAX_DEPTH segments.
+class FeedbackRayTracer {
+public:
+    static constexpr int MAX_DEPTH = 16;  // matches shaders/refraction_feedback.geom
+
+    ~FeedbackRayTracer();
+
+    // Builds the program and buffers; false if the driver rejects them
+    bool init();
+    bool isAvailable() const { return program != 0; }
+
+    // Flattens the scene to segments (arcs tessellated) and uploads them
+    // with their own BVH. Call again whenever the geometry changes.
+    void uploadScene(const OpticalScene& scene, int arcSegments);
+
+    // rays holds rayCount records of (origin.xy, direction.xy, intensity).
+    // Material indices are re-read from the scene on every call. Returns
+    // the number of vertices captured, drawn as GL_LINES from getVertexArray().
+    size_t trace(const OpticalScene& scene, const float* rays, size_t rayCount,
+                 const FresnelSettings& settings, float sFraction);
+
+    // (x, y, intensity) per vertex, same layout as the CPU ray buffer
+    GLuint getVertexArray() const { return outputVAO; }
+    size_t getVertexCount() const { return vertexCount; }
+
+private:
+    GLuint program = 0;
+    GLuint rayVAO = 0, rayVBO = 0;
+    GLuint outputVAO = 0, outputVBO = 0;
+    GLuint nodeBuffer = 0, nodeTexture = 0;
+    GLuint segmentBuffer = 0, segmentTexture = 0;
+    GLuint materialBuffer = 0, materialTexture = 0;
+    GLuint primitivesQuery = 0;
+    size_t outputCapacity = 0;  // vertices
+    size_t vertexCount = 0;
+    int nodeCount = 0;
+
+    static void uploadTexture(GLuint buffer, GLuint texture, GLenum format,
+                              const void* data, size_t bytes);
+};
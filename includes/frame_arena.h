@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame, such
+// as vertices built for one upload. main.cpp resets it at the top of every
+// frame, which frees everything at once; deallocating is a no-op.
+//
+// A frame that needs more than the block holds carries on in overflow
+// blocks, and the next reset replaces them all with one block big enough
+// for that frame, so after a frame or two of warm-up no frame touches the
+// global allocator. Debug builds fill fresh allocations with 0xCD and
+// everything freed by a reset with 0xDD, to make stale use stand out.
+//
+// Only the main thread may use it.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = 4 << 20);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset();
+
+    // This frame so far, and the most any frame has used
+    size_t getUsed() const { return frameBytes; }
+    size_t getAllocationCount() const { return allocationCount; }
+    size_t getHighWaterMark() const { return highWaterMark; }
+    size_t getCapacity() const { return capacity; }
+    int getGrowCount() const { return growCount; }
+
+    // The arena frame-scoped containers use by default, registered by main.cpp
+    static FrameArena* get() { return instance; }
+    static void setInstance(FrameArena* arena) { instance = arena; }
+
+private:
+    static FrameArena* instance;
+
+    char* block = nullptr;
+    size_t capacity = 0;
+    size_t offset = 0;                  // into block
+    std::vector<char*> overflow;
+    size_t frameBytes = 0;              // including padding and overflow
+    size_t allocationCount = 0;
+    size_t highWaterMark = 0;
+    int growCount = 0;
+};
+
+// STL allocator on a FrameArena, for containers that die with the frame:
+//
+//   FrameVector<float> vertices;
+//   vertices.reserve(count * 2);
+//
+// Without a registered arena (headless runs) it falls back to the heap.
+template <typename T>
+class FrameAllocator {
+public:
+    typedef T value_type;
+
+    FrameAllocator() : arena(FrameArena::get()) {}
+    explicit FrameAllocator(FrameArena* arena) : arena(arena) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.getArena()) {}
+
+    T* allocate(size_t count) {
+        if (!arena) return static_cast<T*>(::operator new(count * sizeof(T)));
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t) {
+        if (!arena) ::operator delete(pointer);
+    }
+
+    FrameArena* getArena() const { return arena; }
+
+private:
+    FrameArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+    return a.getArena() == b.getArena();
+}
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+    return !(a == b);
+}
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+// Counts the GL calls the simulations make, by putting counting wrappers
+// in front of glad's function pointers. Every entry point used per frame is
+// wrapped; one-off setup (glGen*, shader compiling and linking) is not, and
+// neither is ImGui's backend, which has its own loader. A bind or state
+// change that sets what is already set is counted as redundant, judged
+// against a shadow of the state that is forgotten every frame.
+//
+// Main thread only, like the GL context.
+class GlCounters {
+public:
+    struct Stats {
+        uint64_t calls = 0;                 // calls to the wrapped entry points
+        uint64_t draws = 0;
+        uint64_t vertices = 0;              // vertices submitted, times instances
+        uint64_t programBinds = 0, redundantProgramBinds = 0;
+        uint64_t vertexArrayBinds = 0, redundantVertexArrayBinds = 0;
+        uint64_t bufferBinds = 0, redundantBufferBinds = 0;
+        uint64_t textureBinds = 0, redundantTextureBinds = 0;
+        uint64_t uploads = 0;               // buffer and texture data calls
+        uint64_t uploadBytes = 0;
+        uint64_t uniforms = 0;
+        uint64_t uniformLookups = 0;        // glGetUniformLocation
+        uint64_t stateChanges = 0, redundantStateChanges = 0;
+        uint64_t queries = 0;               // glGet*, query results and glFinish, which may stall
+
+        uint64_t redundant() const {
+            return redundantProgramBinds + redundantVertexArrayBinds + redundantBufferBinds +
+                   redundantTextureBinds + redundantStateChanges;
+        }
+    };
+
+    // After gladLoadGLLoader; wraps the glad entry points
+    static void install();
+    static bool isInstalled();
+
+    // For calls made through pointers glad does not hold (the render
+    // backend's direct state access entry points)
+    static void recordUpload(uint64_t bytes);
+    static void recordStateChanges(uint64_t count);
+
+    // Closes the frame: its counts become lastFrame() and join the totals
+    static void endFrame();
+    static const Stats& lastFrame();
+    static const Stats& totals();
+    static uint64_t getFrameCount();
+
+    // Per-frame averages over the whole run
+    static void printSummary(std::ostream& out);
+};
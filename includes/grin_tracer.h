@@ -0,0 +1,25 @@
+#pragma once
+#include "index_field.h"
+
+struct GrinSettings {
+    float tolerance = 1e-4f;    // allowed local error per step, in scene units
+    float initialStep = 0.1f;
+    float minStep = 1e-4f;
+    float maxStep = 1.0f;
+    float maxLength = 60.0f;    // total arc length before a ray gives up
+    int maxSteps = 4096;
+    Aabb2D bounds;              // rays stop where they leave this box
+};
+
+// Polyline of one ray through a gradient-index medium. Kept between traces
+// so the point storage is reused rather than reallocated every frame.
+struct GrinPath {
+    std::vector<glm::vec2> points;
+    int acceptedSteps = 0;
+    int rejectedSteps = 0;
+};
+
+// Integrates the ray equation d/ds (n dr/ds) = grad n with an adaptive
+// Dormand-Prince 5(4) stepper, recording every accepted step into path.
+void traceGrinRay(const IndexField& field, const glm::vec2& origin, const glm::vec2& direction,
+                  const GrinSettings& settings, GrinPath& path);
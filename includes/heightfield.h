@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Terrain profile y = h(x), sampled at evenly spaced x with the ground
+// linear in between. A min/max pyramid over the cells (level 0 is one cell
+// per sample pair, each level above merges pairs) lets a trajectory skip
+// any stretch of terrain it passes entirely above in O(log n) steps.
+class Heightfield {
+public:
+    // Samples span [left, right]; throws if there are fewer than two
+    void setSamples(std::vector<float> samples, float left, float right);
+
+    // Greyscale PGM (P2 or P5, 8 or 16 bit). The middle row becomes the
+    // profile, black at minHeight and white at maxHeight. Throws on bad files.
+    void loadPgm(const std::string& path, float left, float right, float minHeight, float maxHeight);
+
+    // Clamped to the end samples outside [left, right]
+    float heightAt(float x) const;
+
+    // Time at which a projectile launched from start with velocity first
+    // comes down onto the ground. False if it leaves [left, right] first.
+    // nodesVisited (optional) counts the pyramid nodes that were examined.
+    bool intersectTrajectory(const glm::vec2& start, const glm::vec2& velocity, float gravity,
+                             float& hitTime, int* nodesVisited = nullptr) const;
+
+    // Same result by testing every cell along the flight, for comparison
+    bool intersectTrajectoryLinear(const glm::vec2& start, const glm::vec2& velocity, float gravity,
+                                   float& hitTime) const;
+
+    const std::vector<float>& getSamples() const { return heights; }
+    // (min, max) height per node; level 0 has one node per cell
+    const std::vector<glm::vec2>& getLevel(int level) const { return levels[level]; }
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+    float getLeft() const { return left; }
+    float getRight() const { return right; }
+    float getSpacing() const { return spacing; }
+    float getMinHeight() const { return levels.back()[0].x; }
+    float getMaxHeight() const { return levels.back()[0].y; }
+
+private:
+    std::vector<float> heights;
+    std::vector<std::vector<glm::vec2>> levels;
+    float left = 0.0f, right = 1.0f, spacing = 1.0f;
+
+    void buildPyramid();
+    bool intersectCell(size_t cell, const glm::vec2& start, const glm::vec2& velocity, float gravity,
+                       float t0, float t1, float& hitTime) const;
+    bool intersectVertical(const glm::vec2& start, float speed, float gravity, float& hitTime) const;
+};
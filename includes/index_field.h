@@ -0,0 +1,63 @@
+#pragma once
+#include "bvh2d.h"
+#include <vector>
+
+// Continuously varying refractive index n(x, y). Rays through these media
+// bend smoothly instead of at interfaces, see grin_tracer.h.
+class IndexField {
+public:
+    virtual ~IndexField() = default;
+
+    // Index at p, with its gradient written to gradient
+    virtual float sample(const glm::vec2& p, glm::vec2& gradient) const = 0;
+
+    float indexAt(const glm::vec2& p) const {
+        glm::vec2 gradient;
+        return sample(p, gradient);
+    }
+};
+
+// Air over hot ground (y = 0): the index drops towards the ground, so rays
+// skimming it curve back up and the sky shows up "on the road".
+// n(y) = airIndex - (airIndex - groundIndex) * exp(-y / scaleHeight)
+class MirageField : public IndexField {
+public:
+    MirageField(float groundIndex, float airIndex, float scaleHeight);
+    float sample(const glm::vec2& p, glm::vec2& gradient) const override;
+
+private:
+    float groundIndex, airIndex, scaleHeight;
+};
+
+// Graded-index fibre running along x at height axisY. Inside the core the
+// index falls off parabolically, n = n0 * sqrt(1 - 2 * delta * (r / a)^2),
+// so guided rays follow sinusoidal paths; the cladding is uniform.
+class GradedFiberField : public IndexField {
+public:
+    GradedFiberField(float axisY, float coreRadius, float coreIndex, float delta);
+    float sample(const glm::vec2& p, glm::vec2& gradient) const override;
+    float getCladdingIndex() const;
+
+private:
+    float axisY, coreRadius, coreIndex, delta;
+};
+
+// Index sampled on a regular grid of nodes spanning bounds, bilinearly
+// interpolated in between. Outside the grid the index is outsideIndex.
+class GridIndexField : public IndexField {
+public:
+    GridIndexField(const Aabb2D& bounds, int width, int height, float outsideIndex);
+    float sample(const glm::vec2& p, glm::vec2& gradient) const override;
+
+    float& at(int x, int y) { return values[y * width + x]; }
+    glm::vec2 nodePosition(int x, int y) const;
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    Aabb2D bounds;
+    int width, height;
+    glm::vec2 cellSize;
+    float outsideIndex;
+    std::vector<float> values;
+};
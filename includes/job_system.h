@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+// One unit of work: a plain function over a range of indices. Tasks are
+// copied by value into fixed ring buffers, so scheduling never allocates.
+struct Task {
+    void (*function)(void* data, size_t begin, size_t end) = nullptr;
+    void* data = nullptr;
+    size_t begin = 0, end = 0;
+    size_t grain = 1;           // longer ranges are split before running
+    TaskGroup* group = nullptr;
+    bool hot = false;           // started inside an AllocTracker::HotRegion
+};
+
+// Tracks the tasks started under it and an optional continuation that runs
+// once they have all finished. Lives on the stack of whoever waits on it,
+// and can be reused once wait() returns.
+class TaskGroup {
+private:
+    friend class JobSystem;
+    std::atomic<int> pending{1};        // unfinished tasks, plus a hold until then()/wait()
+    std::atomic<bool> finished{false};
+    bool released = false;
+    Task continuation;
+};
+
+// Work-stealing thread pool. Each worker owns a deque of tasks: it pushes
+// and pops at the bottom while idle workers steal from the top of the
+// others, so the big early pieces of a split range go to thieves and the
+// small recent ones stay warm in the owner's cache. Threads outside the
+// pool share one extra deque. wait() runs queued tasks instead of blocking,
+// so a task can itself start and wait on a nested group.
+class JobSystem {
+public:
+    // threadCount includes the thread creating the pool (worker 0);
+    // 0 means one per hardware thread
+    explicit JobSystem(int threadCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Restarts the workers; only call from worker 0 with no tasks in flight
+    void setThreadCount(int threadCount);
+    int getThreadCount() const { return threadCount; }
+
+    // The pool parallelFor and the simulations use, registered by main.cpp
+    static JobSystem* get() { return instance; }
+    static void setInstance(JobSystem* jobs) { instance = jobs; }
+
+    // Calls function(data, begin, end) over pieces of [begin, end) no
+    // longer than grain. data must stay alive until the group is waited on.
+    void run(TaskGroup& group, void (*function)(void*, size_t, size_t), void* data,
+             size_t begin, size_t end, size_t grain);
+
+    // fn(begin, end) over pieces of the range; fn is referenced, not copied
+    template <typename Fn>
+    void run(TaskGroup& group, Fn& fn, size_t begin, size_t end, size_t grain) {
+        run(group, &invokeRange<Fn>, &fn, begin, end, grain);
+    }
+    // A single fn() call
+    template <typename Fn>
+    void run(TaskGroup& group, Fn& fn) {
+        run(group, &invokeOnce<Fn>, &fn, 0, 1, 1);
+    }
+
+    // Sets what runs after every task in the group is done. Call after the
+    // group's last run(); the group counts as finished once this has run.
+    void then(TaskGroup& group, void (*function)(void*, size_t, size_t), void* data);
+    template <typename Fn>
+    void then(TaskGroup& group, Fn& fn) {
+        then(group, &invokeOnce<Fn>, &fn);
+    }
+
+    // Runs queued tasks until the group (and its continuation) finished
+    void wait(TaskGroup& group);
+
+private:
+    static constexpr size_t DEQUE_CAPACITY = 1024;
+    static constexpr int SPINS_BEFORE_SLEEP = 64;
+
+    struct Deque {
+        std::mutex lock;
+        Task tasks[DEQUE_CAPACITY];
+        size_t top = 0, bottom = 0;     // steal at top, owner works at bottom
+    };
+
+    static JobSystem* instance;
+
+    int threadCount = 1;
+    std::unique_ptr<Deque[]> deques;    // one per worker, then the shared outside one
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping{false};
+    std::atomic<int> queued{0};
+    std::atomic<int> sleepers{0};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+
+    void start(int threadCount);
+    void stop();
+    void workerLoop(int index);
+    int currentDeque() const;
+    bool push(int deque, const Task& task);
+    bool findTask(int deque, Task& task);
+    void execute(Task task, int deque);
+    void finish(TaskGroup& group, int deque);
+
+    template <typename Fn>
+    static void invokeRange(void* data, size_t begin, size_t end) {
+        (*static_cast<Fn*>(data))(begin, end);
+    }
+    template <typename Fn>
+    static void invokeOnce(void* data, size_t, size_t) {
+        (*static_cast<Fn*>(data))();
+    }
+};
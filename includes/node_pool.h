@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+// Fixed-capacity arena for per-trace nodes. Storage is reserved once and
+// reset every frame, so tracing never touches the global allocator.
+template <typename Node>
+class NodePool {
+public:
+    explicit NodePool(size_t capacity = 0) { reserve(capacity); }
+
+    void reserve(size_t capacity) {
+        nodes.resize(capacity);
+        used = 0;
+    }
+    void reset() {
+        used = 0;
+        exhausted = false;
+    }
+
+    // Returns -1 once the pool is full; callers simply stop spawning
+    int allocate() {
+        if (used == nodes.size()) {
+            exhausted = true;
+            return -1;
+        }
+        if (used + 1 > highWaterMark) highWaterMark = used + 1;
+        return static_cast<int>(used++);
+    }
+
+    Node& operator[](int index) { return nodes[index]; }
+    const Node& operator[](int index) const { return nodes[index]; }
+    size_t size() const { return used; }
+    size_t capacity() const { return nodes.size(); }
+    size_t getHighWaterMark() const { return highWaterMark; }
+    bool wasExhausted() const { return exhausted; }
+
+private:
+    std::vector<Node> nodes;
+    size_t used = 0;
+    size_t highWaterMark = 0;
+    bool exhausted = false;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "bvh2d.h"
+#include <vector>
+
+// Where a moving circle first touches an obstacle
+struct SweepHit {
+    float time;         // fraction of the move, 0..1
+    glm::vec2 normal;   // out of the obstacle, towards the circle
+};
+
+// Static polygonal obstacles, stored as edges under a BVH. Moving bodies
+// are swept against them (continuous collision), so a fast body cannot
+// step over a thin wall between two frames.
+class ObstacleSet {
+public:
+    void clear();
+    // Closed polygon, either winding. Call build() after adding.
+    void addPolygon(const std::vector<glm::vec2>& points);
+    void build();
+
+    // First contact of a circle moving in a straight line from start to end.
+    // Radius 0 sweeps a point, i.e. a segment-vs-edge test. Contacts the
+    // circle already overlaps at start are ignored so it can move free.
+    bool sweep(const glm::vec2& start, const glm::vec2& end, float radius, SweepHit& hit) const;
+
+    // Deepest overlap of a circle at one position (a discrete test)
+    bool overlap(const glm::vec2& center, float radius, glm::vec2& normal, float& depth) const;
+
+    // Two points per edge, ready to draw as GL_LINES
+    const std::vector<glm::vec2>& getEdgePoints() const { return edgePoints; }
+    bool empty() const { return edgePoints.empty(); }
+
+private:
+    std::vector<glm::vec2> edgePoints;
+    Bvh2D bvh;
+};
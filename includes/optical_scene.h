@@ -0,0 +1,81 @@
+#pragma once
+#include "bvh2d.h"
+#include "dispersion.h"
+#include <string>
+#include <vector>
+
+struct OpticalMaterial {
+    std::string name;
+    float index;                 // refractive index at WAVELENGTH_REFERENCE
+    DispersionModel dispersion;  // used by the spectral tracer
+};
+
+// Boundary between two media. Segments and arcs both have a "front" side:
+// for a segment it is the right hand side walking from p0 to p1 (so a
+// counter-clockwise polygon faces outwards), for an arc it is the outside
+// of its circle.
+struct OpticalPrimitive {
+    enum Type { Segment, Arc };
+    Type type;
+    glm::vec2 p0, p1;                    // segment endpoints
+    glm::vec2 center;                    // arc circle
+    float radius;
+    float angleStart, angleSpan;         // radians, span > 0 runs counter-clockwise
+    int frontMaterial, backMaterial;
+};
+
+struct OpticalHit {
+    float t;
+    glm::vec2 point;
+    glm::vec2 normal;  // always faces the front side
+    int primitive;
+};
+
+class OpticalScene {
+public:
+    static constexpr float RAY_EPSILON = 1e-4f;
+    static constexpr float ESCAPE_DISTANCE = 60.0f;
+
+    void clear();
+    int addMaterial(const std::string& name, float index);
+    int addMaterial(const std::string& name, const DispersionModel& dispersion);
+    OpticalMaterial& getMaterial(int material) { return materials[material]; }
+    const std::vector<OpticalMaterial>& getMaterials() const { return materials; }
+
+    void addSegment(const glm::vec2& p0, const glm::vec2& p1, int frontMaterial, int backMaterial);
+    void addArc(const glm::vec2& center, float radius, float angleStart, float angleSpan,
+                int frontMaterial, int backMaterial);
+    // Points are wound counter-clockwise; the outside faces outsideMaterial
+    void addPolygon(const std::vector<glm::vec2>& points, int insideMaterial, int outsideMaterial);
+
+    // Convenience shapes built from the primitives above
+    void addBiconvexLens(const glm::vec2& center, float height, float thickness,
+                         int glassMaterial, int outsideMaterial);
+    void addPrism(const glm::vec2& center, float side, float rotation,
+                  int glassMaterial, int outsideMaterial);
+    void addSlab(const glm::vec2& center, glm::vec2 size, int glassMaterial, int outsideMaterial);
+
+    // Must be called after editing primitives and before tracing
+    void build();
+
+    // Nearest hit before tMax; tests (if given) counts ray/primitive tests
+    bool intersect(const glm::vec2& origin, const glm::vec2& direction,
+                   float tMax, OpticalHit& hit, size_t* tests = nullptr) const;
+
+    // Exact test against a single primitive (normal faces its front side)
+    bool intersectPrimitive(int primitive, const glm::vec2& origin, const glm::vec2& direction,
+                            float tMax, OpticalHit& hit) const;
+
+    // Line list (pairs of points) for drawing the scene outline
+    void tessellate(std::vector<glm::vec2>& lines, int arcSegments) const;
+
+    const Bvh2D& getBvh() const { return bvh; }
+    size_t primitiveCount() const { return primitives.size(); }
+    size_t bvhNodeCount() const { return bvh.getNodes().size(); }
+    const std::vector<OpticalPrimitive>& getPrimitives() const { return primitives; }
+
+private:
+    std::vector<OpticalMaterial> materials;
+    std::vector<OpticalPrimitive> primitives;
+    Bvh2D bvh;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include "job_system.h"
+#include <algorithm>
+
+// Runs fn(i) for every i in [0, count) on the shared job system, the caller
+// included. The range is split in halves down to chunkSize indices per task
+// and idle workers steal the big halves, so rays that take longer than their
+// neighbours balance out. Runs inline without a job system or a second thread.
+template <typename Fn>
+void parallelFor(size_t count, size_t chunkSize, Fn fn) {
+    chunkSize = std::max<size_t>(chunkSize, 1);
+    JobSystem* jobs = JobSystem::get();
+    if (!jobs || jobs->getThreadCount() <= 1 || count <= chunkSize) {
+        for (size_t i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    auto body = [&fn](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) fn(i);
+    };
+    TaskGroup group;
+    jobs->run(group, body, 0, count, chunkSize);
+    jobs->wait(group);
+}
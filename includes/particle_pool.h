@@ -0,0 +1,53 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Short-lived effect particles (impact dust, debris and sparks) kept as a
+// structure of arrays of fixed capacity. Storage is allocated once, live
+// particles are always the first size() entries, spawning appends and a
+// kill moves the last particle into the hole, so both are O(1) and nothing
+// touches the heap while particles come and go.
+class ParticlePool {
+public:
+    enum Kind : uint8_t {
+        Dust,       // slow, drifts and settles
+        Debris,     // heavy, bounces along the ground
+        Spark,      // fast and brief
+        KindCount
+    };
+
+    explicit ParticlePool(size_t capacity = 0) { reserve(capacity); }
+
+    // Drops every particle
+    void reserve(size_t capacity);
+    void clear() { count = 0; }
+
+    // Returns false once the pool is full; the particle is dropped
+    bool spawn(Kind kind, const glm::vec2& position, const glm::vec2& velocity, float life, float floorY);
+    void kill(size_t index);
+
+    // Up to count particles of kind thrown from position into the half
+    // plane around normal, no lower than floorY. Returns how many fit.
+    size_t burst(Kind kind, const glm::vec2& position, const glm::vec2& normal, float speed, size_t count,
+                 float floorY, std::minstd_rand& random);
+
+    // Moves every particle on by dt, then kills the expired ones
+    void update(float dt, float gravity);
+
+    // Three floats per live particle: x, y, and the kind plus the fraction
+    // of its life used (kind + age / life), which is all the shader needs
+    void writeVertices(float* out) const;
+
+    size_t size() const { return count; }
+    size_t capacity() const { return x.size(); }
+    size_t getHighWaterMark() const { return highWaterMark; }
+
+private:
+    std::vector<float> x, y, vx, vy, age, life, drag, groundY;
+    std::vector<uint8_t> kind;
+    size_t count = 0;
+    size_t highWaterMark = 0;
+};
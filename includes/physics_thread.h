@@ -0,0 +1,24 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Calls step() at a fixed rate on a thread of its own, so a slow physics
+// step costs simulation time rather than frames. A step that runs late is
+// followed by the next one straight away to catch up; after falling more
+// than a few steps behind, the backlog is dropped instead.
+class PhysicsThread {
+public:
+    ~PhysicsThread() { stop(); }
+
+    void start(int stepsPerSecond, std::function<void()> step);
+    // Returns once the current step has finished
+    void stop();
+    bool isRunning() const { return thread.joinable(); }
+
+private:
+    static constexpr int MAX_BACKLOG_STEPS = 4;
+
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+};
@@ -1,13 +1,29 @@
 
 #pragma once
 #include "simulation_base.h"
+#include "heightfield.h"
+#include "broadphase.h"
+#include "obstacle_set.h"
+#include "triple_buffer.h"
+#include "spsc_queue.h"
+#include "physics_thread.h"
+#include "session_log.h"
+#include "trajectory_log.h"
+#include "range_table.h"
+#include "particle_pool.h"
+#include <string>
 
 class ProjectileSimulation : public SimulationBase {
 public:
     ~ProjectileSimulation() override;
     void init() override;
-    void render(float deltaTime) override;
+    void update(float deltaTime) override;
+    void render(CommandList& commands) override;
     void handleInput() override;
+    bool isIdle() const override {
+        return view && !view->running && !view->swarmRunning && view->commandsApplied == commandsSent &&
+               !(view->replaying && !view->replayPaused) && particles.size() == 0;
+    }
     
 private:
    struct Projectile {
@@ -15,14 +31,167 @@ private:
         glm::vec2 position;
         glm::vec2 velocity;
         float time;
+        glm::vec2 arcStart;     // launch point, or where it last bounced
+        glm::vec2 arcVelocity;
+        float arcTime;          // time since arcStart
+        int bounces;
     } projectile;
 
+    // One vacuum arc of a shot: launch to landing, or between two bounces
+    struct Arc {
+        glm::vec2 start;
+        glm::vec2 velocity;
+        float duration;
+    };
+
+    // Everything the UI can change that the physics step reads. The UI
+    // edits controls; the physics thread works from its own copy, settings,
+    // which every command brings up to date.
+    struct PhysicsSettings {
+        float cannonAngle = 45.0f;
+        float launchSpeed = 20.0f;
+        float targetDistance = 15.0f;
+        bool showObstacles = false;
+        bool continuousCollision = true;
+        float projectileRadius = 0.15f;     // 0 sweeps a point
+        float wallRestitution = 0.6f;
+        int swarmSize = 10000;
+        float bodyRadius = 0.08f;
+        float restitution = 0.8f;           // 1 is perfectly elastic
+        int swarmSubsteps = 2;
+        int broadphaseType = 0;             // BroadphaseType
+    };
+    static constexpr int SETTINGS_WORDS = 12;   // PhysicsSettings as logged
+    PhysicsSettings controls;
+    PhysicsSettings settings;
+
+    // Physics runs on its own thread at PHYSICS_RATE steps per second. The
+    // UI only sends it commands, and only draws from published snapshots.
+    enum CommandType {
+        ApplySettings,
+        Fire,
+        Reset,
+        SpawnSwarm,
+        ClearSwarm,
+        Seek,           // playback: argument is the step
+        SetPaused       // playback: argument is 0 or 1
+    };
+    struct Command {
+        CommandType type;
+        PhysicsSettings settings;
+        unsigned long long argument = 0;
+    };
+    struct Snapshot {
+        unsigned long long id = 0;
+        unsigned commandsApplied = 0;
+        unsigned launch = 0;                // counts shots fired
+        Projectile projectile = {};
+        glm::vec2 targetPosition;
+        bool running = false;
+        bool completed = false;
+        bool hitTerrain = false;
+        float impactTime = 0.0f;
+        float maxHeight = 0.0f;
+        float totalDistance = 0.0f;
+        float currentHeight = 0.0f;
+        float distanceFromTarget = 0.0f;
+        std::vector<glm::vec2> pathPoints;
+        std::vector<Arc> shotArcs;          // the current shot, the last arc flown so far
+        bool swarmRunning = false;
+        std::vector<glm::vec3> pegs;        // (x, y, radius)
+        std::vector<float> bodyVertices;    // ball centres, ready to upload
+        size_t bodyCount = 0;
+        size_t contactCount = 0;
+        float integrateMilliseconds = 0.0f;
+        float broadphaseMilliseconds = 0.0f;
+        float responseMilliseconds = 0.0f;
+        float stepMilliseconds = 0.0f;
+        bool recording = false;
+        size_t recordedBytes = 0;
+        bool replaying = false;
+        bool replayPaused = false;
+        unsigned long long replayStep = 0, firstStep = 0, lastStep = 0;
+        unsigned long long mismatchStep = 0;    // first step whose hash differed, 0 if none
+        unsigned replayFailures = 0;            // counts playbacks ended by a bad record
+        std::string replayError;                // why the last one ended
+        bool trajectoryLogging = false;
+        unsigned long long trajectoryRows = 0, trajectoryBytes = 0;
+    };
+    PhysicsThread physicsThread;
+    SpscQueue<Command, 256> commands;
+    TripleBuffer<Snapshot> snapshots;
+    unsigned commandsSent = 0;          // UI side
+    unsigned commandsApplied = 0;       // physics side
+    unsigned launchCount = 0;
+    unsigned long long snapshotCount = 0;
+    const Snapshot* view = nullptr;     // latest snapshot read by the UI
+    unsigned long long uploadedSnapshot = 0;
+
+    // Record/replay. While recording, every command the physics thread
+    // applies is logged with its step, along with a state hash per step
+    // and a keyframe every second. Playback restores the nearest keyframe
+    // and re-runs the logged commands from there, checking every hash.
+    SessionWriter recorder;
+    SessionReader player;
+    SessionReader::Cursor replayCursor;
+    uint32_t loggedSettings[SETTINGS_WORDS];    // command deltas are taken against these
+    std::vector<uint8_t> logBytes;
+    unsigned long long physicsStep = 0;
+    bool replaying = false;
+    bool replayPaused = false;
+    unsigned long long replayStep = 0;
+    unsigned long long mismatchStep = 0;
+    char sessionPath[256] = "session.pvsl";
+    std::string sessionError;
+    unsigned replayFailures = 0;        // physics side, with the message below
+    std::string replayError;
+    unsigned shownReplayFailures = 0;   // UI side
+
+    // Trajectory log: while on, every step appends the cannonball in flight
+    // (id = shot number) and optionally every swarm ball (SWARM_LOG_ID +
+    // index) to a columnar file written on a background thread. A log can
+    // be loaded back and its shots drawn over the scene.
+    static constexpr uint32_t SWARM_LOG_ID = 1u << 31;
+    TrajectoryWriter trajectoryWriter;
+    char trajectoryPath[256] = "trajectories.pvtl";
+    bool logSwarm = true;
+    std::string trajectoryError;
+    GLuint overlayVAO = 0, overlayVBO = 0;
+    std::vector<GLint> overlayFirst;
+    std::vector<GLsizei> overlayCount;
+    std::vector<glm::vec2> overlayVertices;
+    std::string overlaySummary;
+
+    // Landing prediction while the sliders move, interpolated from the
+    // range table of the chosen model. Zero drag is this simulation's own
+    // physics; tables are cached on disk by RangeTableCache.
+    RangeTableCache rangeTables;
+    const RangeTable* predictionTable = nullptr;
+    BallisticsModel predictionModel;
+    bool showPrediction = true;
+    int predictionInterpolation = RangeTable::Bicubic;
+    std::string predictionError;
+
+    // Impact effects: dust and debris where a shot lands, sparks where it
+    // bounces. They are only for show, so they live on the UI side, started
+    // from what the snapshots report, and are drawn as one point sprite
+    // draw. All storage is sized for MAX_PARTICLES up front.
+    static constexpr size_t MAX_PARTICLES = 1 << 20;
+    ParticlePool particles;
+    GLuint particleProgram = 0;
+    GLuint particleVAO = 0, particleVBO = 0;
+    std::vector<float> particleVertices;
+    std::minstd_rand particleRandom;
+    bool impactEffects = true;
+    int particlesPerImpact = 3000;
+    unsigned impactLaunch = 0;          // last shot whose landing made a burst
+    unsigned sparkLaunch = 0;
+    int sparkBounces = 0;
+    float particleMilliseconds = 0.0f;
+
     // Cannon and target members
     GLuint cannonVAO, cannonVBO;
     GLuint targetVAO, targetVBO;
-    float cannonAngle = 45.0f;
-    float launchSpeed = 20.0f;
-    float targetDistance = 15.0f;
     glm::vec2 targetPosition;
 
     // Simulation state
@@ -34,12 +203,187 @@ private:
     float distanceFromTarget = 0.0f;
 
     std::vector<glm::vec2> pathPoints;
+    std::vector<Arc> shotArcs;
+
+    // Analytic paths: every arc is drawn by a vertex shader that evaluates
+    // it from gl_VertexID and the arc as instance data, so a shot costs 20
+    // bytes per arc however long it flew. Finished shots are kept as
+    // history. Segment counts follow each arc's flight time, to keep the
+    // chord error under historyTolerance pixels; arcs are grouped by
+    // power-of-two segment count and each group is one instanced draw,
+    // from a vertex array of its own that starts at the group's first arc.
+    // The shot in flight is one draw at the finest segment count it needs.
+    struct ArcBucket {
+        int segments;
+        size_t first, count;
+        GLuint vertexArray;
+    };
+    static constexpr int MAX_ARC_SEGMENTS = 1024;
+    static constexpr int ARC_BUCKETS = 11;     // 1 to MAX_ARC_SEGMENTS
+    GLuint analyticProgram = 0;
+    GLuint historyVAOs[ARC_BUCKETS] = {};
+    GLuint historyVBO = 0;
+    GLuint liveArcVAO = 0, liveArcVBO = 0;
+    int liveArcSegments = 0;
+    bool analyticPaths = false;
+    std::vector<Arc> shotHistory;
+    std::vector<ArcBucket> historyBuckets;
+    unsigned archivedLaunch = 0;
+    bool historyDirty = false;
+    float historyTolerance = 0.5f;
+    int historyViewportHeight = 0;
+    size_t historyVertices = 0;
+
+    // Optional GPU path: the whole flight is sampled analytically by a
+    // transform feedback vertex shader into trajectoryVBO, and the part
+    // flown so far is drawn from there instead of from pathPoints
+    GLuint trajectoryProgram = 0;
+    GLuint trajectoryVAO, trajectoryVBO, feedbackVAO;
+    bool gpuTrajectory = false;
+    int trajectorySamples = 1024;
+    int trajectoryCapacity = 0;         // samples the VBO and the CPU reference hold
+    std::vector<float> referenceXs, referenceYs;
+    float trajectoryTimeStep = 0.0f;
+    unsigned evaluatedLaunch = 0;
+    float gpuTrajectoryMilliseconds = 0.0f;
+    float cpuTrajectoryMilliseconds = 0.0f;
+
+    // Terrain replaces the flat ground. The impact point is found once at
+    // launch by intersecting the whole arc with the heightfield's pyramid.
+    // Only rebuilt while the physics thread is stopped.
+    enum TerrainPreset {
+        FlatGround,
+        Hills,
+        Trenches,
+        Cliffs,
+        HeightmapFile,      // greyscale PGM from heightmapPath
+        TerrainPresetCount
+    };
+    Heightfield terrain;
+    GLuint terrainVAO, terrainVBO;
+    std::vector<float> terrainVertices;
+    int terrainVertexCount = 0;
+    int terrainPreset = FlatGround;
+    static constexpr int MAX_TERRAIN_SAMPLES = 1 << 22;
+    int terrainSamples = 1 << 20;
+    char heightmapPath[256] = "heightmap.pgm";
+    std::string terrainError;
+    float impactTime = 0.0f;
+    bool hitTerrain = false;
+
+    // "Test Shots": a fan of launches at every angle from the cannon, all
+    // intersected with the terrain at once and drawn as impact points
+    GLuint impactVAO, impactVBO;
+    std::vector<glm::vec2> impactPoints;
+    int testShotCount = 4096;
+    float testShotMilliseconds = 0.0f;
+    float linearShotMilliseconds = 0.0f;    // estimated from a sample of the shots
+    float testShotNodes = 0.0f;             // pyramid nodes visited per shot
+
+    // Swarm: many cannonballs colliding with each other and with static
+    // pegs. Pegs are the first pegCount bodies, with zero inverse mass, so
+    // one broadphase pass finds both kinds of contact.
+    struct BodySet {
+        std::vector<float> x, y, vx, vy, radius, inverseMass;
+
+        size_t size() const { return x.size(); }
+        void clear() {
+            x.clear(); y.clear(); vx.clear(); vy.clear(); radius.clear(); inverseMass.clear();
+        }
+        void add(const glm::vec2& position, const glm::vec2& velocity, float r, float invMass) {
+            x.push_back(position.x); y.push_back(position.y);
+            vx.push_back(velocity.x); vy.push_back(velocity.y);
+            radius.push_back(r); inverseMass.push_back(invMass);
+        }
+    };
+    enum BroadphaseType {
+        HashGridBroadphase,
+        SweepAndPruneBroadphase
+    };
+    BodySet bodies;
+    size_t pegCount = 0;
+    SpatialHashGrid hashGrid;
+    SweepAndPrune sweepAndPrune;
+    std::vector<BodyPair> contactPairs;
+    GLuint bodyVAO, bodyVBO;
+    bool swarmRunning = false;
+    float integrateMilliseconds = 0.0f;
+    float broadphaseMilliseconds = 0.0f;
+    float responseMilliseconds = 0.0f;
+
+    // Thin walls and planks. The cannonball and the swarm are swept against
+    // them each step (continuous collision), so a fast shot cannot jump a
+    // wall between two steps; the discrete test is kept for comparison.
+    ObstacleSet obstacles;
+    GLuint obstacleVAO = 0, obstacleVBO = 0;
+
+    // Geometry rebuilt from the UI waits here for update() to upload it
+    bool terrainDirty = false, impactsDirty = false, obstaclesDirty = false, overlayDirty = false;
 
+    // Sorting keeps the recorded order only within one program and vertex
+    // array, so what must cover what is kept apart by layer
+    enum DrawLayer : uint8_t {
+        GroundLayer,        // terrain, filled
+        SceneLayer,         // cannon and obstacles
+        OverlayLayer,       // paths, markers, bodies
+        EffectsLayer        // particles
+    };
 
     void setupProjectileBuffers();
     void setupCannonBuffers();
     void setupTargetBuffers();
+    void setupTrajectoryBuffers();
+    void setupAnalyticBuffers();
+    int arcSegments(float duration, int viewportHeight) const;
+    void rebuildHistory(int viewportHeight);
+    void pointArcs(GLuint arcVAO, GLuint arcVBO, size_t first);
+    void uploadPendingBuffers();
+    void addRandomShots(int count);
+    void evaluateTrajectory(const Snapshot& state);
+    void setupTerrainBuffers();
+    void buildTerrain();
+    float flightTime(const glm::vec2& start, const glm::vec2& velocity, bool& hit) const;
+    void fireTestShots();
+    void setupBodyBuffers();
+    void setupParticleBuffers();
+    void emitImpactParticles(const Snapshot& state);
+    void burstAt(const glm::vec2& point, const glm::vec2& normal, float speed, size_t count);
+    void drawParticles(CommandList& commands, const glm::mat4& projection);
+    void spawnSwarm();
+    void reserveSwarm();
+    void stepSwarm(float deltaTime);
+    void resolveContacts();
+    void buildObstacles();
+    bool findObstacleContact(const glm::vec2& from, const glm::vec2& to, float radius,
+                             float& fraction, glm::vec2& normal, glm::vec2& contact) const;
+    glm::vec2 arcPosition(float time) const;
     void resetSimulation();
+    void launch();
     void updatePhysics(float deltaTime);
+    void stepPhysics();
+    void applyCommand(const Command& command);
+    void publishSnapshot(float stepMilliseconds);
+    void sendCommand(CommandType type, unsigned long long argument = 0);
+    void rebuildTerrain();
+    bool simulateStep();
+    static void packSettings(const PhysicsSettings& values, uint32_t* words);
+    static void unpackSettings(const uint32_t* words, PhysicsSettings& values);
+    void encodeCommand(const Command& command, std::vector<uint8_t>& out);
+    Command decodeCommand(const SessionReader::Record& record);
+    void encodeKeyframe(std::vector<uint8_t>& out);
+    void restoreKeyframe(const SessionReader::Record& record);
+    uint64_t stateHash() const;
+    std::vector<uint8_t> sessionHeader() const;
+    void startRecording();
+    void stopRecording();
+    void startPlayback();
+    void stopPlayback();
+    void advanceReplay();
+    void seekReplay(unsigned long long step);
+    void startTrajectoryLog();
+    void stopTrajectoryLog();
+    void logTrajectories(bool flying);
+    void loadTrajectoryOverlay();
+    void selectPredictionModel();
    
 };
\ No newline at end of file
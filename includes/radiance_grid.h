@@ -0,0 +1,34 @@
+#pragma once
+#include "bvh2d.h"
+#include <vector>
+
+// 2D grid that accumulates the light energy passing through each cell.
+// Every worker splats into its own private histogram, so tracing threads
+// never share a cache line or need atomics; reduce() then folds the
+// histograms into the accumulated grid, split by rows across threads.
+class RadianceGrid {
+public:
+    void resize(int width, int height, const Aabb2D& bounds, int workerCount);
+    void clear();
+
+    // Adds intensity * (length of the segment inside each cell) to the
+    // cells the segment crosses, in worker's histogram
+    void splat(int worker, const glm::vec2& start, const glm::vec2& end, float intensity);
+
+    // Moves every worker histogram into the accumulated grid
+    void reduce();
+
+    const std::vector<float>& getAccumulated() const { return accumulated; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getWorkerCount() const { return static_cast<int>(histograms.size()); }
+    const Aabb2D& getBounds() const { return bounds; }
+    glm::vec2 getCellSize() const { return cellSize; }
+
+private:
+    int width = 0, height = 0;
+    Aabb2D bounds;
+    glm::vec2 cellSize;
+    std::vector<float> accumulated;
+    std::vector<std::vector<float>> histograms;  // one full grid per worker
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "ballistics.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Range, apex and flight time of a grid of shots, angleCount rows by
+// speedCount columns, spread evenly over the angle and speed limits (both
+// included). Tables are row-major with the angle as the row. Shots that
+// never landed are NaN in all three tables.
+class RangeTable {
+public:
+    enum Interpolation {
+        Bilinear,
+        Bicubic         // Catmull-Rom, 4x4 cells
+    };
+
+    // Flies every shot of the grid on the job system
+    void build(const BallisticsModel& model, int angleCount, int speedCount,
+               float angleMin = 0.0f, float angleMax = 90.0f,
+               float speedMin = 0.0f, float speedMax = 50.0f);
+
+    // Binary: a small header, then the three tables as raw floats. All
+    // throw std::runtime_error on failure.
+    void save(const std::string& path) const;
+    void load(const std::string& path);
+    void writeCsv(const std::string& path) const;
+    // Binary PPM of the range table, highest angle at the top
+    void writeHeatmap(const std::string& path) const;
+
+    // The flight at any angle and speed, interpolated from the grid in
+    // constant time; outside the grid the nearest edge is used. Not landed
+    // if any cell it interpolates from did not land.
+    Flight sample(float angle, float speed, Interpolation interpolation = Bicubic) const;
+
+    bool isEmpty() const { return ranges.empty(); }
+    size_t getUnlandedCount() const { return unlanded; }
+    const BallisticsModel& getModel() const { return model; }
+    int getAngleCount() const { return angleCount; }
+    int getSpeedCount() const { return speedCount; }
+    float angleAt(int row) const { return angleMin + (angleMax - angleMin) * row / (angleCount - 1); }
+    float speedAt(int column) const { return speedMin + (speedMax - speedMin) * column / (speedCount - 1); }
+    const std::vector<float>& getRanges() const { return ranges; }
+    const std::vector<float>& getApexes() const { return apexes; }
+    const std::vector<float>& getTimes() const { return times; }
+
+private:
+    BallisticsModel model;
+    int angleCount = 0, speedCount = 0;
+    float angleMin = 0.0f, angleMax = 90.0f;
+    float speedMin = 0.0f, speedMax = 50.0f;
+    std::vector<float> ranges, apexes, times;
+    size_t unlanded = 0;
+
+    void countUnlanded();
+};
+
+// Range tables per physics model, each loaded from directory on first use,
+// or built and saved there if it is missing. The file name encodes the
+// model and resolution, so a table is only ever reused for the same ones.
+// A table with shots that never landed is used but not saved.
+class RangeTableCache {
+public:
+    explicit RangeTableCache(const std::string& directory = ".", int resolution = 256)
+        : directory(directory), resolution(resolution) {}
+
+    // Throws std::runtime_error if the table can neither be loaded nor built
+    const RangeTable& get(const BallisticsModel& model);
+    std::string pathFor(const BallisticsModel& model) const;
+
+private:
+    std::string directory;
+    int resolution;
+    std::vector<std::unique_ptr<RangeTable>> tables;
+};
+
+// What --range-table asks for
+struct RangeTableJob {
+    std::string path;               // binary table
+    std::string csvPath;            // optional
+    std::string heatmapPath;        // optional
+    int angleCount = 4096;
+    int speedCount = 4096;
+    BallisticsModel model;
+};
+
+// Headless entry point for --range-table; returns the exit code
+int runRangeTable(const RangeTableJob& job);
@@ -0,0 +1,35 @@
+#pragma once
+#include "optical_scene.h"
+#include "node_pool.h"
+
+// One straight piece of a light path. Children are allocated from the same
+// pool, so a whole reflection/refraction tree lives in one flat array.
+struct RayTreeNode {
+    glm::vec2 origin;
+    glm::vec2 direction;
+    float length;       // distance to the next interface (or escape)
+    float intensityS;   // s-polarised power
+    float intensityP;   // p-polarised power
+    int parent;         // -1 for rays leaving the source
+    int depth;
+
+    float intensity() const { return intensityS + intensityP; }
+};
+
+typedef NodePool<RayTreeNode> RayNodePool;
+
+struct FresnelSettings {
+    int maxDepth = 8;
+    float intensityCutoff = 0.01f;
+};
+
+// Power reflectance for s and p polarisation at an interface between
+// indices n1 and n2 (cosT is the cosine of the transmitted angle)
+void fresnelReflectance(float n1, float n2, float cosI, float cosT, float& rs, float& rp);
+
+// Traces one source ray through the scene, splitting into reflected and
+// transmitted children at every interface until the intensity drops below
+// the cutoff or maxDepth is reached. Returns the number of ray/primitive tests.
+size_t traceFresnelTree(const OpticalScene& scene, const glm::vec2& origin,
+                        const glm::vec2& direction, float intensityS, float intensityP,
+                        const FresnelSettings& settings, RayNodePool& pool);
@@ -1,11 +1,25 @@
+#pragma once
 #include "simulation_base.h"
- 
+#include "optical_scene.h"
+#include "ray_tree.h"
+#include "spectral_tracer.h"
+#include "grin_tracer.h"
+#include "feedback_tracer.h"
+#include "radiance_grid.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+
 class RefractionSimulation : public SimulationBase{
     public:
     ~RefractionSimulation() override;
     void init() override;
-    void render(float deltaTime) override;
+    void update(float deltaTime) override;
+    void render(CommandList& commands) override;
     void handleInput() override;
+    bool isIdle() const override {
+        return !traceDirty && !vertexDirty && !(showCaustics && causticRays < static_cast<size_t>(causticRayTarget));
+    }
 
     private:
         struct LightRay {
@@ -13,34 +27,161 @@ class RefractionSimulation : public SimulationBase{
         glm::vec2 direction;
         float intensity;
     };
-        // Medium interface (boundary line)
+
+    enum Polarization {
+        Unpolarized,
+        SPolarized,
+        PPolarized
+    };
+
+    enum ScenePreset {
+        FlatInterface,
+        ConvexLens,
+        Prism,
+        GlassSlab,
+        PrismField,
+        Mirage,
+        GradedFiber,
+        LuneburgLens,   // sampled on a grid rather than analytic
+        PresetCount
+    };
+
+        // Scene outline (interfaces between media)
     GLuint interfaceVAO, interfaceVBO;
     std::vector<glm::vec2> interfacePoints;
+    OpticalScene scene;
+    int scenePreset = FlatInterface;
+    int pendingPreset = -1;         // picked in the UI, loaded by update()
+    int outsideMaterial = 0;        // uses n1
+    int glassMaterial = 0;          // uses n2
 
-    // Light rays (using base class VAO, VBO)
+    // Light rays (using base class VAO, VBO). Every reflected and refracted
+    // piece of every ray tree comes out of rayPool, which is reset per trace.
+    static constexpr size_t RAY_POOL_CAPACITY = 1 << 19;
     std::vector<LightRay> incidentRays;
-    std::vector<LightRay> refractedRays;
+    RayNodePool rayPool{RAY_POOL_CAPACITY};
+
+    // Spectral mode: every source ray becomes a white beam of wavelength
+    // samples, drawn with per-vertex colour through spectralVAO
+    static constexpr size_t SPECTRAL_POOL_CAPACITY = 1 << 20;
+    GLuint spectralVAO, spectralVBO;
+    SpectralSegmentPool spectralPool{SPECTRAL_POOL_CAPACITY};
+    bool spectralMode = false;
+    int wavelengthCount = 64;
+
+    // Gradient-index presets replace the interfaces with a continuous index
+    // field; each ray is integrated into its own reusable polyline
+    std::unique_ptr<IndexField> indexField;
+    GrinSettings grinSettings;
+    std::vector<GrinPath> grinPaths;
+    int grinAcceptedSteps = 0;
+    int grinRejectedSteps = 0;
+
+    // Optional GPU path: rays traced by a transform feedback geometry shader
+    // straight into a vertex buffer (dominant Fresnel branch only)
+    FeedbackRayTracer gpuTracer;
+    bool gpuTracing = false;
+    bool tracedOnGpu = false;
+    std::string rendererName;
+
+    // Caustics: random rays across the beam, traced a batch per frame and
+    // splatted into a radiance grid until causticRayTarget is reached. The
+    // grid is drawn as a texture behind the ray lines.
+    struct CausticWorker {
+        RayNodePool pool{1 << 14};
+        GrinPath path;
+        std::minstd_rand random;
+    };
+    static constexpr int CAUSTIC_RESOLUTION = 512;
+    RadianceGrid radiance;
+    std::vector<CausticWorker> causticWorkers;
+    GLuint causticProgram, causticVAO, causticVBO, causticTexture;
+    bool showCaustics = false;
+    int causticRaysPerFrame = 20000;
+    int causticRayTarget = 2000000;
+    size_t causticRays = 0;
+    float causticExposure = 1.0f;
+
+    // Last "Benchmark" run over the current rays, averaged per trace
+    struct TracerBenchmark {
+        bool valid = false;
+        float treeMilliseconds = 0.0f, packetMilliseconds = 0.0f, gpuMilliseconds = 0.0f;
+        size_t treeSegments = 0, packetSegments = 0, gpuSegments = 0;
+    } benchmark;
+    bool benchmarkRequested = false;
 
         // Simulation parameters
     float incidentAngle = 45.0f;    // in degrees
     float n1 = 1.0f;                // refractive index of medium 1 (air)
     float n2 = 1.33f;               // refractive index of medium 2 (water)
-    bool simulationRunning = false;
+    int medium1Preset = static_cast<int>(DispersionPreset::Custom);
+    int medium2Preset = static_cast<int>(DispersionPreset::Custom);
+    glm::vec2 sourcePosition = glm::vec2(0.0f, 5.0f);
+    int rayCount = 1;
+    float beamWidth = 2.0f;
+    FresnelSettings fresnel;
+    int polarization = Unpolarized;
+
+    // Ray tree segments go to the GPU as 16-byte records, not as vertices;
+    // ray_records.vert expands each into a line, or a quad rayWidth pixels
+    // wide, clipped to the view
+    struct RayRecord {
+        float originX, originY;
+        int16_t directionX, directionY;     // snorm16
+        uint16_t length;                    // unorm16 of ESCAPE_DISTANCE
+        uint16_t intensity;                 // unorm16
+    };
+    GLuint rayProgram = 0;
+    GLuint rayRecordVAO, rayRecordVBO;
+    GLuint refractedRecordVAO;          // the same records, from the first refracted one
+    size_t rayRecordCount = 0;
+    size_t incidentRecordCount = 0;
+    float rayWidth = 0.0f;              // 0 draws hairlines
+
+    // Set whenever a parameter changes; a frame with neither set skips the
+    // trace and the vertex upload entirely
+    bool traceDirty = true;
+    bool vertexDirty = true;
+    // Vertices are built in the frame arena and only their counts kept:
+    // gradient-index paths as (x, y, intensity), spectral segments as
+    // (x, y, intensity, r, g, b)
+    size_t rayVertexCount = 0;
+    size_t spectralVertexCount = 0;
+
+    // Sorted by the render queue: caustics under the lines, and the additive
+    // spectral lines over them
+    enum DrawLayer : uint8_t { CausticLayer, LineLayer, SpectralLayer };
 
     float refractionAngle = 0.0f;  // Store the current refraction angle
 float reflectionAngle = 0.0f;  // Store the reflection angle for total internal reflection
+    float hitIncidentAngle = 0.0f; // Angle of the first ray against the surface it hits
 
         // UI state
     bool showCriticalAngle = false;
     float criticalAngle = 0.0f;
-    
+
+    // Tracing statistics for the last frame
+    size_t rayTests = 0;
+    float traceMilliseconds = 0.0f;
+
+    void setupRayBuffers();
+    void pointRayRecords(GLuint vertexArray, size_t first);
+    void updateMaterials();
     void setupInterfaceBuffers();
+    void loadPreset(int preset);
     void updateRays();
     void calculateRefraction();
+    void traceGradientIndex();
+    void updateVertices();
+    float sPolarizedFraction() const;
+    void runBenchmark();
+    void setupCausticBuffers();
+    void resetCaustics();
+    void accumulateCaustics();
     float calculateCriticalAngle();
     void resetSimulation();
 
-    
-    
 
-};
\ No newline at end of file
+
+
+};
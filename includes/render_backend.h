@@ -0,0 +1,51 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+
+// The GL calls the simulations make most, behind a cache of what is bound.
+// A bind of the program, vertex array or array buffer that is already
+// bound is dropped, so code can bind what it needs without tracking what
+// the previous draw left behind.
+//
+// Buffer uploads and vertex array setup go through direct state access
+// (GL 4.5 or ARB_direct_state_access) when the context has it, and need
+// no binding at all; on a plain 3.3 context they bind to edit, through the
+// cache. Buffers and vertex arrays edited here must come from
+// createBuffer()/createVertexArray() or have been bound once, since DSA
+// only accepts names that are already objects.
+//
+// The cache only holds while every bind and delete goes through here, so
+// nothing else may call glUseProgram, glBindVertexArray, glBindBuffer or
+// the matching glDelete* directly. Main thread only, like the context.
+class RenderBackend {
+public:
+    // After gladLoadGLLoader, with the same loader
+    static void init(GLADloadproc loader);
+    static bool hasDirectStateAccess();
+
+    // Forgets what is bound; for when something outside (ImGui's backend,
+    // with its own loader) may have changed it
+    static void invalidate();
+
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vertexArray);
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    static GLuint createBuffer();
+    static GLuint createVertexArray();
+    static void deleteProgram(GLuint program);
+    static void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+    static void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+    static void bufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+    static void bufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+
+    // Attribute index of vertexArray reads from buffer at offset, stride
+    // bytes apart. The integer form keeps integers as integers in the
+    // shader. Either enables the attribute.
+    static void vertexAttribute(GLuint vertexArray, GLuint index, GLuint buffer, GLint size, GLenum type,
+                                GLboolean normalized, GLsizei stride, size_t offset);
+    static void vertexAttributeInteger(GLuint vertexArray, GLuint index, GLuint buffer, GLint size, GLenum type,
+                                       GLsizei stride, size_t offset);
+    static void elementBuffer(GLuint vertexArray, GLuint buffer);
+};
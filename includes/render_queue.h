@@ -0,0 +1,151 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// A frame's draws as data. Simulations record into a CommandList from
+// render() instead of calling GL, and main.cpp hands the list to a
+// RenderQueue, which sorts and submits it in one pass.
+//
+// Recording makes no GL calls, so a list can be filled on any thread, one
+// thread at a time. Like in GL, uniforms stay with their program once set
+// and constant attributes stay until changed; unlike in GL, every draw
+// takes a copy of them, so it is complete wherever sorting puts it.
+// Uniforms are named with string literals, which must outlive the submit.
+// Names are matched by content; only the queue's location cache goes by
+// the pointer, so a second copy of a literal costs one more lookup.
+class CommandList {
+public:
+    enum Blend : uint8_t { BlendAlpha, BlendAdditive };
+
+    // Empties the list for a new frame, keeping its memory
+    void reset(int viewportWidth, int viewportHeight);
+    int getViewportWidth() const { return viewportWidth; }
+    int getViewportHeight() const { return viewportHeight; }
+
+    // Room for drawCount draws of up to RESERVED_VALUES uniforms and
+    // attributes each, and for the uniforms of the given programs, so that
+    // recording them allocates nothing (see AllocTracker::HotRegion)
+    static constexpr size_t RESERVED_VALUES = 8, RESERVED_FLOATS = 48;
+    void reserve(size_t drawCount, std::initializer_list<GLuint> programs);
+
+    void clearColor(const glm::vec4& color);
+
+    // Sorting keeps the recorded order only within one program and vertex
+    // array, so draws that must cover others go in a higher layer
+    void setLayer(uint8_t layer) { current.layer = layer; }
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray) { current.vertexArray = vertexArray; }
+    void bindTexture(GLuint texture) { current.texture = texture; }    // GL_TEXTURE_2D, unit 0
+    void setBlend(Blend blend) { current.blend = blend; }
+    void setPointSize(float size) { current.pointSize = size; }       // 0: the program's gl_PointSize
+
+    void uniform(const char* name, int x);
+    void uniform(const char* name, float x);
+    void uniform(const char* name, const glm::vec2& v);
+    void uniform(const char* name, const glm::vec3& v);
+    void uniform(const char* name, const glm::vec4& v);
+    void uniform(const char* name, const glm::mat4& m);
+    // For an attribute the vertex array has no enabled array for
+    void constantAttribute(GLuint index, const glm::vec4& v);
+
+    void drawArrays(GLenum mode, GLint first, GLsizei count);
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+
+    size_t getDrawCount() const { return draws.size(); }
+
+private:
+    friend class RenderQueue;
+
+    enum Kind : uint8_t { Int, Float, Vec2, Vec3, Vec4, Mat4, Attribute };
+
+    struct Value {
+        const char* name;       // nullptr for an attribute
+        GLuint index;           // attribute index
+        Kind kind;
+        uint32_t offset;        // into the owner's data
+    };
+
+    struct State {
+        uint8_t layer = 0;
+        Blend blend = BlendAlpha;
+        GLuint program = 0, vertexArray = 0, texture = 0;
+        float pointSize = 0.0f;
+    };
+
+    struct Draw {
+        uint64_t key;           // layer, program, vertex array, then recording order
+        State state;
+        GLenum mode;
+        GLint first;
+        GLsizei count, instances;   // instances 0 for a plain draw
+        uint32_t firstValue, valueCount;
+    };
+
+    // The uniforms set so far for one program
+    struct ProgramValues {
+        GLuint program;
+        std::vector<Value> values;
+        std::vector<float> data;
+    };
+
+    static constexpr size_t NO_PROGRAM = ~size_t(0);
+
+    static size_t sizeOf(Kind kind);
+    size_t programIndex(GLuint program);
+    void set(const char* name, GLuint index, Kind kind, const float* data);
+    void record(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+
+    int viewportWidth = 0, viewportHeight = 0;
+    bool hasClear = false;
+    glm::vec4 clearValue;
+    State current;
+    size_t currentProgram = NO_PROGRAM;     // index into programs
+    std::vector<ProgramValues> programs;    // kept across frames
+    ProgramValues attributes;
+    std::vector<Draw> draws;
+    std::vector<Value> values;              // copies taken by the draws
+    std::vector<float> data;
+};
+
+// Submits a CommandList: draws are sorted by layer, program and vertex
+// array so each is bound once, and neighbours that differ only in their
+// range become one call (a single draw for contiguous lists of points,
+// lines or triangles, glMultiDrawArrays otherwise). Binds go through
+// RenderBackend. Main thread only.
+class RenderQueue {
+public:
+    struct Stats {
+        size_t commands = 0;    // draws recorded
+        size_t calls = 0;       // draw calls issued
+        size_t merged = 0;      // draws folded into another's call
+    };
+
+    void submit(const CommandList& list);
+    const Stats& lastSubmit() const { return stats; }
+
+    // Cached uniform locations are per program name, and names are reused
+    // after glDeleteProgram
+    void forgetPrograms() { locations.clear(); }
+
+private:
+    struct Location {
+        GLuint program;
+        const char* name;
+        GLint location;
+    };
+
+    GLint location(GLuint program, const char* name);
+    static bool mergeable(const CommandList& list, const CommandList::Draw& a, const CommandList::Draw& b);
+    void apply(const CommandList& list, const CommandList::Draw& draw, const CommandList::Draw* previous);
+    void restoreDefaults();
+
+    std::vector<Location> locations;
+    std::vector<uint32_t> order;
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    CommandList::State applied;     // what main.cpp sets up: alpha blending, no texture
+    Stats stats;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// One run of either simulation, as read from a scenario file.
+//
+// A scenario file has one run per line: the simulation's name followed by
+// key=value pairs. Anything after '#' is a comment. Missing keys take the
+// same defaults as the UI.
+//
+//   projectile angle=45 speed=20 target=15 drag=0.01 wind=-3
+//   refraction angle=30 n1=1 n2=1.33 polarization=s
+//
+// A value written first:last:step (step defaults to 1) sweeps that key,
+// and several sweeps on one line run every combination of them, so
+//
+//   projectile angle=5:85:5 speed=10:40
+//
+// is 17 x 31 runs. Runs keep file order, with the last swept key varying
+// fastest.
+struct Scenario {
+    enum Kind {
+        Projectile,
+        Refraction
+    };
+    enum Polarization {
+        Unpolarized,
+        SPolarized,
+        PPolarized
+    };
+
+    Kind kind = Projectile;
+    int line = 0;                   // where it came from, for reports
+
+    float angle = 45.0f;            // cannon or incident angle, degrees
+    float speed = 20.0f;
+    float target = 15.0f;           // target distance from the cannon
+    float gravity = 9.81f;
+    float drag = 0.0f;              // see BallisticsModel
+    float wind = 0.0f;
+    float n1 = 1.0f;
+    float n2 = 1.33f;
+    int polarization = Unpolarized;
+};
+
+// Parses a whole scenario file in one pass over its bytes. Throws
+// std::runtime_error naming the source and line on any malformed entry.
+std::vector<Scenario> parseScenarios(const char* text, size_t length, const std::string& source);
+
+// Maps the file and parses it
+std::vector<Scenario> loadScenarios(const std::string& path);
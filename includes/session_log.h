@@ -0,0 +1,111 @@
+#pragma once
+#include "byte_stream.h"
+#include "mapped_file.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A session log records a simulation as the commands it was given, a hash
+// of its state after every step that changed something, and a keyframe of
+// the full state every so often. Re-running the commands from any keyframe
+// reproduces the session; a hash that comes out different means the replay
+// has diverged from the recording.
+//
+// Layout: "PVSL", a version varint, the caller's header (varint length and
+// bytes), then records. Each record is a type byte, a step varint and the
+// payload. Command and hash records store their step as a delta from the
+// record before; keyframes store it whole, so reading can start at any of
+// them. Payloads are opaque here: a varint length and bytes, or for hashes
+// 8 raw bytes.
+enum class SessionRecord : uint8_t {
+    Command = 1,
+    Hash = 2,
+    Keyframe = 3
+};
+
+class SessionWriter {
+public:
+    ~SessionWriter() { close(); }
+
+    // Throws std::runtime_error if the file cannot be created
+    void open(const std::string& path, const std::vector<uint8_t>& header);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+    // Set when a write fails (a full disk, say); nothing more is written
+    // after that. The message stays until the next open.
+    bool hasFailed() const { return failed; }
+    const std::string& getError() const { return error; }
+
+    // Steps must not go backwards
+    void command(uint64_t step, const std::vector<uint8_t>& payload);
+    void hash(uint64_t step, uint64_t value);
+    void keyframe(uint64_t step, const std::vector<uint8_t>& payload);
+
+    uint64_t getLastKeyframeStep() const { return lastKeyframeStep; }
+    size_t getBytesWritten() const { return bytesWritten + buffer.size(); }
+
+private:
+    static constexpr size_t FLUSH_BYTES = 1 << 20;
+
+    FILE* file = nullptr;
+    std::string path;
+    std::vector<uint8_t> buffer;
+    uint64_t lastStep = 0;
+    uint64_t lastKeyframeStep = 0;
+    size_t bytesWritten = 0;
+    std::atomic<bool> failed{false};
+    std::string error;                      // set once, before failed
+
+    void beginRecord(SessionRecord type, uint64_t step);
+    void endRecord();
+    void flush();
+    void fail();
+};
+
+// Reads a log through a memory mapping. Opening scans the records once to
+// index the keyframes; a log cut off mid-record (say, by a crash) is read
+// up to its last complete record.
+class SessionReader {
+public:
+    struct Record {
+        SessionRecord type;
+        uint64_t step;
+        const uint8_t* data;    // command and keyframe payloads
+        size_t size;
+        uint64_t hash;          // hash records
+    };
+    struct Cursor {
+        size_t offset = 0;
+        uint64_t step = 0;      // of the record before offset
+    };
+
+    // Throws std::runtime_error if the file is missing or not a session log
+    void open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    const std::vector<uint8_t>& getHeader() const { return header; }
+    uint64_t getFirstStep() const { return keyframes.front().step; }
+    uint64_t getLastStep() const { return lastStep; }
+    size_t getKeyframeCount() const { return keyframes.size(); }
+
+    // Cursor on the last keyframe at or before step, or the first keyframe
+    Cursor seek(uint64_t step) const;
+    // Reads the record at the cursor and moves past it; false at the end
+    bool read(Cursor& cursor, Record& record) const;
+
+private:
+    struct KeyframeEntry {
+        uint64_t step;
+        size_t offset;
+    };
+
+    MappedFile file;
+    std::vector<uint8_t> header;
+    std::vector<KeyframeEntry> keyframes;
+    size_t recordsEnd = 0;      // end of the last complete record
+    uint64_t lastStep = 0;
+
+    bool parse(size_t& offset, uint64_t& step, Record& record, size_t end) const;
+};
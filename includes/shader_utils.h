@@ -4,10 +4,17 @@
 
 #include <GLFW/glfw3.h>
 #include <string>
+#include <vector>
 
 namespace ShaderUtils {
     unsigned int make_shader(const std::string& vertex_filepath,
                             const std::string& fragment_filepath);
     unsigned int make_module(const std::string& filepath,
                             unsigned int module_type);
+    // Program whose outputs are captured with transform feedback rather
+    // than rasterised. The geometry stage is optional (empty path), and
+    // varyings are written interleaved in the order given.
+    unsigned int make_feedback_shader(const std::string& vertex_filepath,
+                                      const std::string& geometry_filepath,
+                                      const std::vector<std::string>& varyings);
 }
\ No newline at end of file
@@ -4,17 +4,28 @@
 #include <GLFW/glfw3.h>
 #include<glm/glm.hpp>
 #include<vector>
+#include "job_system.h"
+#include "render_queue.h"
 class SimulationBase {
 public:
     virtual void init() = 0;
-    virtual void render(float deltaTime) = 0;
+    // Main thread, context current: the frame's GL work that is not a
+    // draw (buffer uploads, transform feedback passes). Runs before render().
+    virtual void update(float /*deltaTime*/) {}
+    // Records the frame's draws and builds the UI; no GL calls here
+    virtual void render(CommandList& commands) = 0;
     virtual void handleInput() = 0;
     virtual ~SimulationBase() = default;
     GLuint getShaderProgram() const { return shaderProgram; }
+    // True when nothing is animating and no parameter changed since the
+    // last frame, so the main loop can sleep until the next input event
+    virtual bool isIdle() const { return true; }
 
     
 protected:
     virtual void setupBuffers();
+    // The worker pool main.cpp creates for the whole run
+    static JobSystem& jobSystem() { return *JobSystem::get(); }
     GLuint VAO, VBO, shaderProgram;
     
 };
\ No newline at end of file
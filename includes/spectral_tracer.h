@@ -0,0 +1,28 @@
+#pragma once
+#include "optical_scene.h"
+#include "ray_tree.h"
+
+// Wavelengths traced together in one packet. Every per-lane loop in the
+// spectral tracer runs over exactly this many floats so it maps onto SIMD
+// registers (two SSE / one AVX / two NEON registers wide).
+constexpr int SPECTRAL_LANES = 8;
+
+// Piece of one wavelength's path, ready to draw
+struct SpectralSegment {
+    glm::vec2 start;
+    glm::vec2 end;
+    float wavelength;
+    float intensity;
+    int depth;
+};
+
+typedef NodePool<SpectralSegment> SpectralSegmentPool;
+
+// Traces a white beam sampled at wavelengthCount wavelengths (rounded up to
+// whole packets) through the scene, with dispersive indices and Fresnel
+// splitting per wavelength. All wavelengths of a packet share one BVH
+// traversal. The S and P intensities are split evenly over the wavelengths,
+// as for traceFresnelTree. Returns the number of packet/primitive tests.
+size_t traceSpectralBeam(const OpticalScene& scene, const glm::vec2& origin,
+                         const glm::vec2& direction, float intensityS, float intensityP, int wavelengthCount,
+                         const FresnelSettings& settings, SpectralSegmentPool& pool);
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Fixed-size ring between exactly one producer and one consumer thread.
+// Neither side locks; each only writes its own index, and the other side
+// reads it to see how far it may go.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer side; false when the queue is full
+    bool push(const T& item) {
+        size_t end = tail.load(std::memory_order_relaxed);
+        if (end - head.load(std::memory_order_acquire) == Capacity) return false;
+        items[end & (Capacity - 1)] = item;
+        tail.store(end + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the queue is empty
+    bool pop(T& item) {
+        size_t begin = head.load(std::memory_order_relaxed);
+        if (begin == tail.load(std::memory_order_acquire)) return false;
+        item = items[begin & (Capacity - 1)];
+        head.store(begin + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Padded onto separate cache lines so the two threads do not fight over
+    // one (padding rather than alignas, which plain new ignores before C++17)
+    T items[Capacity];
+    char padItems[CACHE_LINE];
+    std::atomic<size_t> head{0};
+    char padHead[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail{0};
+    char padTail[CACHE_LINE - sizeof(std::atomic<size_t>)];
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include "mapped_file.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Trajectory logs hold samples (time, x, y, vx, vy) of any number of
+// projectiles, tagged with a projectile id. Samples are stored column by
+// column in blocks, so a reader can look at one column of a block as a
+// plain array straight out of the mapped file.
+//
+// Layout, little-endian:
+//   "PVTL", u32 version, u32 metadata entry count, then per entry a u32
+//   length and bytes for the key and for the value; zero padding to 8.
+//   Blocks: "BLK0", u32 row count, then the columns id (u32), time, x, y,
+//   vx and vy (f32), each row count long.
+//   Footer, written on close: u64 offset of each block, u64 block count,
+//   "PVTE". A log without it (still open, or cut short) is read by
+//   walking the block headers instead.
+typedef std::vector<std::pair<std::string, std::string>> TrajectoryMetadata;
+
+// Buffers samples into blocks and hands full blocks to a thread of its
+// own that writes them, so the simulation never waits on the disk unless
+// it outruns it by the whole buffer pool.
+class TrajectoryWriter {
+public:
+    ~TrajectoryWriter() { close(); }
+
+    // Throws std::runtime_error if the file cannot be created
+    void open(const std::string& path, const TrajectoryMetadata& metadata);
+    // Writes what is buffered and the footer, and stops the writer thread
+    void close();
+    bool isOpen() const { return file != nullptr; }
+    // Set when a write fails (a full disk, say); nothing more is written
+    // after that. The message stays until the next open.
+    bool hasFailed() const { return failed; }
+    const std::string& getError() const { return error; }
+
+    void append(uint32_t id, float time, float x, float y, float vx, float vy);
+    // count samples taken at the same time from structure-of-arrays
+    // storage; sample i gets id firstId + i
+    void appendRange(uint32_t firstId, size_t count, float time,
+                     const float* x, const float* y, const float* vx, const float* vy);
+
+    uint64_t getRowCount() const { return rows; }
+    uint64_t getBytesWritten() const { return bytesWritten; }
+
+private:
+    static constexpr size_t BLOCK_ROWS = 1 << 16;
+    static constexpr int BLOCK_POOL = 4;
+
+    struct Block {
+        std::vector<uint32_t> id;
+        std::vector<float> time, x, y, vx, vy;
+        size_t rows = 0;
+    };
+
+    FILE* file = nullptr;
+    std::string path;
+    std::unique_ptr<Block> current;
+    std::vector<std::unique_ptr<Block>> freeBlocks, fullBlocks;
+    std::mutex lock;
+    std::condition_variable blockFreed, blockFilled;
+    bool closing = false;
+    std::thread writer;
+    std::vector<uint64_t> blockOffsets;     // writer thread
+    uint64_t rows = 0;
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<bool> failed{false};
+    std::string error;                      // set once, before failed
+
+    void submit();
+    void fail();
+    void writeBlocks();
+};
+
+// Reads a trajectory log through a memory mapping, without copying
+class TrajectoryLog {
+public:
+    struct Block {
+        size_t rows;
+        const uint32_t* id;
+        const float* time;
+        const float* x;
+        const float* y;
+        const float* vx;
+        const float* vy;
+    };
+
+    // Throws std::runtime_error if the file is missing or not a trajectory log
+    void open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    const TrajectoryMetadata& getMetadata() const { return metadata; }
+    // Empty when the key is missing
+    std::string getValue(const std::string& key) const;
+
+    size_t getBlockCount() const { return blockOffsets.size(); }
+    Block getBlock(size_t index) const;
+    uint64_t getRowCount() const { return rows; }
+    size_t getFileSize() const { return file.size(); }
+
+private:
+    MappedFile file;
+    TrajectoryMetadata metadata;
+    std::vector<size_t> blockOffsets;
+    uint64_t rows = 0;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Hands the newest value from one writer thread to one reader thread
+// without either side waiting. The writer fills back() and publishes it;
+// the reader always gets the latest published slot, and keeps it until its
+// next read(), so the writer never touches what is being drawn. Slots are
+// reused, so the writer has to rewrite every field it publishes.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side: swaps in the newest slot if there is one
+    const T& read() {
+        if (middle.load(std::memory_order_acquire) & FRESH) {
+            uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
+        }
+        return slots[frontIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4;     // middle holds a slot the reader has not seen
+
+    T slots[3];
+    uint8_t backIndex = 0;                  // writer only
+    std::atomic<uint8_t> middle{1};
+    uint8_t frontIndex = 2;                 // reader only
+};
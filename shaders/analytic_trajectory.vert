@@ -0,0 +1,17 @@
+#version 330 core
+// One vacuum arc per instance, drawn as a line strip of segments + 1
+// vertices: vertex i is the arc at i / segments of its duration. Nothing
+// per vertex is stored; each arc is 20 bytes of instance data.
+layout (location = 0) in vec2 arcStart;
+layout (location = 1) in vec2 arcVelocity;
+layout (location = 2) in float arcDuration;
+
+uniform mat4 projection;
+uniform float gravity;
+uniform int segments;
+
+void main() {
+    float t = arcDuration * float(gl_VertexID) / float(segments);
+    vec2 position = arcStart + arcVelocity * t - vec2(0.0, 0.5 * gravity * t * t);
+    gl_Position = projection * vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 texCoord;
+
+uniform sampler2D radiance;
+uniform float scale;    // maps the unfocused incoming beam to 1
+
+void main() {
+    float value = texture(radiance, texCoord).r * scale;
+    // Exponential tone map so focal points brighten without clipping
+    float brightness = 1.0 - exp(-value);
+    FragColor = vec4(vec3(1.0, 0.85, 0.55), brightness);
+}
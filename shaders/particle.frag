@@ -0,0 +1,11 @@
+#version 330 core
+in vec4 particleColor;
+out vec4 FragColor;
+
+// Round sprites with a soft edge
+void main() {
+    vec2 offset = gl_PointCoord * 2.0 - 1.0;
+    float distanceSquared = dot(offset, offset);
+    if (distanceSquared > 1.0) discard;
+    FragColor = vec4(particleColor.rgb, particleColor.a * (1.0 - distanceSquared * distanceSquared));
+}
@@ -0,0 +1,28 @@
+#version 330 core
+// One impact particle per point. The kind and how much of its life is used
+// come packed in one float, kind + age / life (see ParticlePool).
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in float aState;
+
+uniform mat4 projection;
+uniform float pixelsPerUnit;
+
+out vec4 particleColor;
+
+// Dust, debris, spark
+const vec3 COLORS[3] = vec3[3](vec3(0.75, 0.68, 0.55), vec3(0.45, 0.35, 0.25), vec3(1.0, 0.8, 0.3));
+const float SIZES[3] = float[3](0.12, 0.07, 0.04);
+
+void main() {
+    int kind = int(aState);
+    float used = fract(aState);
+    gl_Position = projection * vec4(aPos, 0.0, 1.0);
+
+    // Dust spreads and thins out, debris stays solid until the end, sparks
+    // cool from yellow to red
+    float size = SIZES[kind] * (kind == 0 ? 1.0 + 2.0 * used : 1.0);
+    gl_PointSize = max(size * pixelsPerUnit, 1.0);
+    vec3 color = kind == 2 ? mix(COLORS[2], vec3(0.9, 0.2, 0.05), used) : COLORS[kind];
+    float alpha = kind == 0 ? 0.5 * (1.0 - used) : kind == 1 ? min(1.0, 5.0 * (1.0 - used)) : 1.0 - used * used;
+    particleColor = vec4(color, alpha);
+}
@@ -0,0 +1,50 @@
+#version 330 core
+// One ray record per instance, expanded here: 2 vertices make a line, 4 a
+// quad (triangle strip) lineWidth pixels wide. The ray is first clipped to
+// the view, so rays leaving the scene cost no more than visible ones.
+layout (location = 0) in vec2 rayOrigin;
+layout (location = 1) in vec2 rayDirection;     // snorm16, so only nearly unit
+layout (location = 2) in float rayLength;       // fraction of maxLength
+layout (location = 3) in float rayIntensity;
+
+uniform mat4 projection;
+uniform vec4 viewBounds;        // left, bottom, right, top
+uniform float maxLength;
+uniform float lineWidth;        // pixels, quads only
+uniform vec2 viewportSize;
+
+out float intensity;
+out vec3 tint;
+
+void main() {
+    vec2 direction = normalize(rayDirection);
+
+    // Liang-Barsky: the part of [0, length] inside the view
+    float t0 = 0.0;
+    float t1 = rayLength * maxLength;
+    for (int axis = 0; axis < 2; axis++) {
+        float low = viewBounds[axis] - rayOrigin[axis];
+        float high = viewBounds[axis + 2] - rayOrigin[axis];
+        if (abs(direction[axis]) < 1e-6) {
+            if (low > 0.0 || high < 0.0) t1 = -1.0;
+        } else {
+            float a = low / direction[axis], b = high / direction[axis];
+            t0 = max(t0, min(a, b));
+            t1 = min(t1, max(a, b));
+        }
+    }
+
+    vec2 position = rayOrigin + direction * ((gl_VertexID & 1) == 0 ? t0 : t1);
+    vec4 clip = projection * vec4(position, 0.0, 1.0);
+    if (lineWidth > 0.0) {
+        // Half the width either side, measured in pixels
+        vec2 screenDirection = normalize((projection * vec4(direction, 0.0, 0.0)).xy * viewportSize);
+        vec2 side = vec2(-screenDirection.y, screenDirection.x) * lineWidth / viewportSize;
+        clip.xy += (gl_VertexID & 2) == 0 ? -side : side;
+    }
+
+    // Nothing left: park every vertex outside the clip volume
+    gl_Position = t1 > t0 ? clip : vec4(2.0, 2.0, 2.0, 1.0);
+    intensity = rayIntensity;
+    tint = vec3(1.0);
+}
@@ -2,6 +2,10 @@
 out vec4 FragColor;
 uniform vec3 color;
 
+in float intensity;
+in vec3 tint;   // per-wavelength colour in spectral mode, white otherwise
+
 void main() {
-    FragColor = vec4(color, 1.0);
+    // sqrt keeps weak Fresnel reflections visible without washing out the rest
+    FragColor = vec4(color * tint, sqrt(clamp(intensity, 0.0, 1.0)));
 }
\ No newline at end of file
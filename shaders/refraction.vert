@@ -1,11 +1,17 @@
 #version 330 core
 layout (location = 0) in vec2 aPos;
+layout (location = 1) in float aIntensity;
+layout (location = 2) in vec3 aTint;
 
 uniform mat4 projection;
 uniform mat4 model;
 
+out float intensity;
+out vec3 tint;
+
 void main() {
     gl_Position = projection * model * vec4(aPos.xy, 0.0, 1.0);
         gl_PointSize = 8.0; // Makes the projectile visible
-
+    intensity = aIntensity;
+    tint = aTint;
 }
\ No newline at end of file
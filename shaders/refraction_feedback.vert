@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec2 aOrigin;
+layout (location = 1) in vec2 aDirection;
+layout (location = 2) in float aIntensity;
+
+out Ray {
+    vec2 origin;
+    vec2 direction;
+    float intensity;
+} ray;
+
+void main() {
+    ray.origin = aOrigin;
+    ray.direction = normalize(aDirection);
+    ray.intensity = aIntensity;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+// Samples the analytic trajectory at t = gl_VertexID * timeStep. Run with
+// rasterisation disabled; outPosition is captured by transform feedback.
+uniform vec2 startPosition;
+uniform vec2 launchVelocity;
+uniform float gravity;
+uniform float timeStep;
+
+out vec2 outPosition;
+
+void main() {
+    float t = float(gl_VertexID) * timeStep;
+    outPosition = startPosition + launchVelocity * t - vec2(0.0, 0.5 * gravity * t * t);
+}
@@ -0,0 +1,180 @@
+#include "alloc_tracker.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Ahead of every block; 16 bytes keeps the block aligned for any
+// fundamental type, like malloc's own
+struct Header {
+    uint64_t size;
+    uint64_t tag;
+};
+static_assert(sizeof(Header) == 16, "header must keep malloc's alignment");
+
+struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> liveBytes{0};
+    std::atomic<uint64_t> peakLiveBytes{0};
+};
+
+Counters counters[AllocTracker::TagCount];
+Counters total;
+std::atomic<uint64_t> hotAllocations{0};
+std::atomic<uint64_t> frameCount{0};
+std::atomic<bool> strict{false};
+uint64_t strictAfterFrame = 0;
+
+// Main thread only: where the counters stood at the last endFrame, and the
+// difference to the one before
+struct FrameMark {
+    uint64_t allocations = 0, frees = 0, bytes = 0;
+};
+FrameMark marks[AllocTracker::TagCount], totalMark;
+AllocTracker::Stats lastStats[AllocTracker::TagCount], lastTotal;
+uint64_t hotMark = 0, lastHot = 0;
+
+thread_local AllocTracker::Tag currentTag = AllocTracker::Other;
+thread_local int hotDepth = 0;
+
+void count(Counters& c, uint64_t bytes) {
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    uint64_t live = c.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    // Racy, but only ever low by a little
+    if (live > c.peakLiveBytes.load(std::memory_order_relaxed)) {
+        c.peakLiveBytes.store(live, std::memory_order_relaxed);
+    }
+}
+
+void uncount(Counters& c, uint64_t bytes) {
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+AllocTracker::Stats closeFrame(const Counters& c, FrameMark& mark) {
+    AllocTracker::Stats stats;
+    uint64_t allocations = c.allocations.load(std::memory_order_relaxed);
+    uint64_t frees = c.frees.load(std::memory_order_relaxed);
+    uint64_t bytes = c.bytes.load(std::memory_order_relaxed);
+    stats.allocations = allocations - mark.allocations;
+    stats.frees = frees - mark.frees;
+    stats.bytes = bytes - mark.bytes;
+    stats.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+    stats.peakLiveBytes = c.peakLiveBytes.load(std::memory_order_relaxed);
+    mark.allocations = allocations;
+    mark.frees = frees;
+    mark.bytes = bytes;
+    return stats;
+}
+
+}
+
+AllocTracker::Scope::Scope(Tag tag) : previous(currentTag) { currentTag = tag; }
+AllocTracker::Scope::~Scope() { currentTag = previous; }
+
+AllocTracker::HotRegion::HotRegion() { hotDepth++; }
+AllocTracker::HotRegion::~HotRegion() { hotDepth--; }
+
+AllocTracker::HotState::HotState(bool hot) : previous(hotDepth) { hotDepth = hot ? 1 : 0; }
+AllocTracker::HotState::~HotState() { hotDepth = previous; }
+bool AllocTracker::inHotRegion() { return hotDepth > 0; }
+
+const char* AllocTracker::tagName(Tag tag) {
+    static const char* const names[TagCount] = { "Other", "Physics", "Render", "ImGui", "Shaders" };
+    return tag < TagCount ? names[tag] : "?";
+}
+
+void* AllocTracker::allocate(size_t bytes) {
+    Tag tag = currentTag;
+    if (hotDepth > 0 && tag != Gui) {
+        hotAllocations.fetch_add(1, std::memory_order_relaxed);
+        if (strict.load(std::memory_order_relaxed) &&
+            frameCount.load(std::memory_order_relaxed) >= strictAfterFrame) {
+            // No iostreams here: they could allocate
+            fprintf(stderr, "Allocation of %zu bytes in a hot region (tag %s) in frame %llu\n", bytes,
+                    tagName(tag), static_cast<unsigned long long>(frameCount.load()));
+            abort();
+        }
+    }
+
+    Header* header = static_cast<Header*>(malloc(sizeof(Header) + bytes));
+    if (!header) return nullptr;
+    header->size = bytes;
+    header->tag = tag;
+    count(counters[tag], bytes);
+    count(total, bytes);
+    return header + 1;
+}
+
+void AllocTracker::release(void* pointer) {
+    if (!pointer) return;
+    Header* header = static_cast<Header*>(pointer) - 1;
+    uncount(counters[header->tag], header->size);
+    uncount(total, header->size);
+    free(header);
+}
+
+void AllocTracker::endFrame() {
+    for (int tag = 0; tag < TagCount; tag++) {
+        lastStats[tag] = closeFrame(counters[tag], marks[tag]);
+    }
+    lastTotal = closeFrame(total, totalMark);
+    uint64_t hot = hotAllocations.load(std::memory_order_relaxed);
+    lastHot = hot - hotMark;
+    hotMark = hot;
+    frameCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t AllocTracker::getFrameCount() { return frameCount.load(std::memory_order_relaxed); }
+AllocTracker::Stats AllocTracker::lastFrame(Tag tag) { return lastStats[tag]; }
+AllocTracker::Stats AllocTracker::lastFrameTotal() { return lastTotal; }
+
+void AllocTracker::setStrict(bool on, uint64_t warmupFrames) {
+    strictAfterFrame = getFrameCount() + warmupFrames;
+    strict.store(on);
+}
+
+bool AllocTracker::isStrict() { return strict.load(); }
+uint64_t AllocTracker::getHotAllocations() { return hotAllocations.load(std::memory_order_relaxed); }
+uint64_t AllocTracker::getLastFrameHotAllocations() { return lastHot; }
+
+// The replaced global allocation functions. Arrays and nothrow forms go
+// through the same path.
+void* operator new(size_t bytes) {
+    void* pointer = AllocTracker::allocate(bytes);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t bytes) {
+    return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    return AllocTracker::allocate(bytes);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    return AllocTracker::allocate(bytes);
+}
+
+void operator delete(void* pointer) noexcept {
+    AllocTracker::release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    AllocTracker::release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    AllocTracker::release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    AllocTracker::release(pointer);
+}
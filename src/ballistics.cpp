@@ -0,0 +1,79 @@
+#include "ballistics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Steps over the drag-free flight time; drag only shortens the flight, the
+// cap is for wild inputs
+constexpr int STEPS_PER_FLIGHT = 48;
+constexpr int MAX_STEPS = 8 * STEPS_PER_FLIGHT;
+
+struct State {
+    float x, y, vx, vy;
+};
+
+struct Derivative {
+    float vx, vy, ax, ay;
+};
+
+inline Derivative derive(const BallisticsModel& model, float gravity, const State& s) {
+    float airX = s.vx - model.wind;
+    float airSpeed = sqrtf(airX * airX + s.vy * s.vy);
+    return { s.vx, s.vy, -model.drag * airSpeed * airX, -gravity - model.drag * airSpeed * s.vy };
+}
+
+inline State advance(const State& s, const Derivative& d, float h) {
+    return { s.x + d.vx * h, s.y + d.vy * h, s.vx + d.ax * h, s.vy + d.ay * h };
+}
+
+inline State rungeKutta(const BallisticsModel& model, float gravity, const State& s, float h) {
+    Derivative k1 = derive(model, gravity, s);
+    Derivative k2 = derive(model, gravity, advance(s, k1, 0.5f * h));
+    Derivative k3 = derive(model, gravity, advance(s, k2, 0.5f * h));
+    Derivative k4 = derive(model, gravity, advance(s, k3, h));
+    float w = h / 6.0f;
+    return { s.x + w * (k1.vx + 2.0f * (k2.vx + k3.vx) + k4.vx),
+             s.y + w * (k1.vy + 2.0f * (k2.vy + k3.vy) + k4.vy),
+             s.vx + w * (k1.ax + 2.0f * (k2.ax + k3.ax) + k4.ax),
+             s.vy + w * (k1.ay + 2.0f * (k2.ay + k3.ay) + k4.ay) };
+}
+
+}
+
+Flight flyToGround(const BallisticsModel& model, float angleDegrees, float speed) {
+    float angle = angleDegrees * (3.14159265358979f / 180.0f);
+    float vx = speed * cosf(angle), vy = speed * sinf(angle);
+    float gravity = std::max(model.gravity, 1e-6f);
+    Flight flight;
+    if (vy <= 0.0f) return flight;     // level or downwards: already on the ground
+
+    float vacuumTime = 2.0f * vy / gravity;
+    if (model.drag <= 0.0f) {
+        flight.time = vacuumTime;
+        flight.range = vx * vacuumTime;
+        flight.apex = vy * vy / (2.0f * gravity);
+        return flight;
+    }
+
+    float h = vacuumTime / STEPS_PER_FLIGHT;
+    State s = { 0.0f, 0.0f, vx, vy };
+    for (int step = 0; step < MAX_STEPS; step++) {
+        State next = rungeKutta(model, gravity, s, h);
+        // Vertical speed is close to linear over one step
+        if (s.vy > 0.0f && next.vy <= 0.0f) {
+            flight.apex = std::max(flight.apex, s.y + 0.5f * s.vy * h * s.vy / (s.vy - next.vy));
+        }
+        if (next.y <= 0.0f) {
+            float f = s.y / (s.y - next.y);
+            flight.range = s.x + (next.x - s.x) * f;
+            flight.time = (step + f) * h;
+            return flight;
+        }
+        s = next;
+    }
+    flight.range = s.x;
+    flight.time = MAX_STEPS * h;
+    flight.landed = false;
+    return flight;
+}
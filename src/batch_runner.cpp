@@ -0,0 +1,149 @@
+#include "batch_runner.h"
+#include "ballistics.h"
+#include "job_system.h"
+#include "ray_tree.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float HIT_DISTANCE = 0.5f;    // same as the UI's "Target Hit!"
+constexpr size_t RUNS_PER_TASK = 1024;
+constexpr size_t ROWS_PER_TASK = 4096;
+
+float radians(float degrees) { return degrees * (PI / 180.0f); }
+float degrees(float radians) { return radians * (180.0f / PI); }
+
+// Without drag, the same arc the physics thread flies on flat ground
+void runProjectile(const Scenario& scenario, ScenarioResult& result) {
+    BallisticsModel model;
+    model.gravity = scenario.gravity;
+    model.drag = scenario.drag;
+    model.wind = scenario.wind;
+    Flight flight = flyToGround(model, scenario.angle, scenario.speed);
+    result.range = flight.range;
+    result.apex = flight.apex;
+    result.flightTime = flight.time;
+    result.targetMiss = fabsf(result.range - scenario.target);
+    result.hit = flight.landed && result.targetMiss < HIT_DISTANCE;
+}
+
+// Snell's law and the Fresnel equations, as at the flat interface preset
+void runRefraction(const Scenario& scenario, ScenarioResult& result) {
+    float cosI = cosf(radians(scenario.angle));
+    float sinT = scenario.n1 / scenario.n2 * sinf(radians(scenario.angle));
+    if (sinT >= 1.0f) {
+        result.totalInternalReflection = true;
+        result.reflectance = 1.0f;
+        return;
+    }
+    float cosT = sqrtf(1.0f - sinT * sinT);
+    float rs, rp;
+    fresnelReflectance(scenario.n1, scenario.n2, cosI, cosT, rs, rp);
+    switch (scenario.polarization) {
+        case Scenario::SPolarized: result.reflectance = rs; break;
+        case Scenario::PPolarized: result.reflectance = rp; break;
+        default: result.reflectance = 0.5f * (rs + rp); break;
+    }
+    result.refractionAngle = degrees(asinf(sinT));
+}
+
+size_t formatRow(char* row, size_t capacity, size_t index, const Scenario& scenario,
+                 const ScenarioResult& result) {
+    int written;
+    if (scenario.kind == Scenario::Projectile) {
+        written = snprintf(row, capacity, "%zu,%d,projectile,%g,%g,%g,%g,%g,%g,,,,%g,%g,%g,%g,%d,,,\n",
+                           index, scenario.line, scenario.angle, scenario.speed, scenario.target,
+                           scenario.gravity, scenario.drag, scenario.wind, result.range, result.apex, result.flightTime,
+                           result.targetMiss, result.hit ? 1 : 0);
+    } else {
+        const char* polarization[] = { "u", "s", "p" };
+        written = snprintf(row, capacity, "%zu,%d,refraction,%g,,,,,,%g,%g,%s,,,,,,%g,%g,%d\n",
+                           index, scenario.line, scenario.angle, scenario.n1, scenario.n2,
+                           polarization[scenario.polarization], result.refractionAngle,
+                           result.reflectance, result.totalInternalReflection ? 1 : 0);
+    }
+    return static_cast<size_t>(std::max(0, std::min(written, static_cast<int>(capacity) - 1)));
+}
+
+}
+
+std::vector<ScenarioResult> runScenarios(const std::vector<Scenario>& scenarios) {
+    std::vector<ScenarioResult> results(scenarios.size());
+    auto run = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (scenarios[i].kind == Scenario::Projectile) {
+                runProjectile(scenarios[i], results[i]);
+            } else {
+                runRefraction(scenarios[i], results[i]);
+            }
+        }
+    };
+    TaskGroup group;
+    JobSystem::get()->run(group, run, 0, scenarios.size(), RUNS_PER_TASK);
+    JobSystem::get()->wait(group);
+    return results;
+}
+
+void writeResults(FILE* out, const std::vector<Scenario>& scenarios,
+                  const std::vector<ScenarioResult>& results) {
+    fputs("index,line,simulation,angle,speed,target,gravity,drag,wind,n1,n2,polarization,"
+          "range,apex,flight_time,target_miss,hit,refraction_angle,reflectance,total_internal_reflection\n", out);
+
+    // Rows are formatted in parallel into per-task buffers, then written
+    // out in task order, so the file is the same for any thread count
+    const size_t ROW_CAPACITY = 256;
+    size_t taskCount = (scenarios.size() + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    std::vector<std::string> text(taskCount);
+    auto format = [&](size_t begin, size_t end) {
+        char row[ROW_CAPACITY];
+        for (size_t task = begin; task < end; task++) {
+            std::string& chunk = text[task];
+            size_t last = std::min(scenarios.size(), (task + 1) * ROWS_PER_TASK);
+            for (size_t i = task * ROWS_PER_TASK; i < last; i++) {
+                chunk.append(row, formatRow(row, ROW_CAPACITY, i, scenarios[i], results[i]));
+            }
+        }
+    };
+    TaskGroup group;
+    JobSystem::get()->run(group, format, 0, taskCount, 1);
+    JobSystem::get()->wait(group);
+    for (const std::string& chunk : text) fwrite(chunk.data(), 1, chunk.size(), out);
+}
+
+int runBatch(const std::string& scenarioPath, const std::string& outputPath) {
+    typedef std::chrono::steady_clock Clock;
+    auto milliseconds = [](Clock::time_point from) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+    };
+
+    try {
+        Clock::time_point start = Clock::now();
+        std::vector<Scenario> scenarios = loadScenarios(scenarioPath);
+        double parseMilliseconds = milliseconds(start);
+
+        start = Clock::now();
+        std::vector<ScenarioResult> results = runScenarios(scenarios);
+        double runMilliseconds = milliseconds(start);
+
+        start = Clock::now();
+        FILE* out = outputPath == "-" ? stdout : fopen(outputPath.c_str(), "wb");
+        if (!out) throw std::runtime_error("Failed to create results file: " + outputPath);
+        writeResults(out, scenarios, results);
+        bool failed = ferror(out) != 0;
+        if (out != stdout) failed |= fclose(out) != 0;
+        if (failed) throw std::runtime_error("Failed to write results file: " + outputPath);
+
+        std::cerr << "Ran " << scenarios.size() << " scenarios on " << JobSystem::get()->getThreadCount()
+                  << " threads: parse " << parseMilliseconds << " ms, run " << runMilliseconds
+                  << " ms, write " << milliseconds(start) << " ms" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Batch run failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,190 @@
+#include "broadphase.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+constexpr size_t Broadphase::PAIRS_PER_BODY;
+
+void Broadphase::gatherPairs(std::vector<BodyPair>& pairs) const {
+    pairs.clear();
+    for (const std::vector<BodyPair>& chunk : chunkPairs) {
+        pairs.insert(pairs.end(), chunk.begin(), chunk.end());
+    }
+}
+
+void Broadphase::reserve(size_t count) {
+    for (std::vector<BodyPair>& chunk : chunkPairs) {
+        chunk.reserve((count / PAIR_CHUNKS + 1) * PAIRS_PER_BODY);
+    }
+}
+
+static bool circlesOverlap(float ax, float ay, float ar, float bx, float by, float br) {
+    float dx = bx - ax, dy = by - ay, r = ar + br;
+    return dx * dx + dy * dy < r * r;
+}
+
+static BodyPair orderedPair(uint32_t a, uint32_t b) {
+    return a < b ? BodyPair{ a, b } : BodyPair{ b, a };
+}
+
+uint32_t SpatialHashGrid::tableSizeFor(size_t count) {
+    // At least 16 buckets keeps the three rows of a 3x3 scan from wrapping
+    // onto each other (see findPairs)
+    uint32_t tableSize = 16;
+    while (tableSize < 2 * count) tableSize <<= 1;
+    return tableSize;
+}
+
+void SpatialHashGrid::reserve(size_t count) {
+    Broadphase::reserve(count);
+    bucketOf.reserve(count);
+    bucketStart.reserve(tableSizeFor(count) + 1);
+    sortedBody.reserve(count);
+    sortedX.reserve(count);
+    sortedY.reserve(count);
+    sortedRadius.reserve(count);
+}
+
+void SpatialHashGrid::build(const float* x, const float* y, const float* radius, size_t count) {
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < count; i++) maxRadius = std::max(maxRadius, radius[i]);
+    cellSize = std::max(minCellSize, std::max(2.0f * maxRadius, 1e-6f));
+
+    uint32_t tableSize = tableSizeFor(count);
+    tableMask = tableSize - 1;
+    rowStride = 1;
+    while (rowStride * rowStride < tableSize) rowStride <<= 1;
+
+    bucketOf.resize(count);
+    float inverseCell = 1.0f / cellSize;
+    parallelFor(count, 4096, [&](size_t i) {
+        bucketOf[i] = bucket(static_cast<int>(floorf(x[i] * inverseCell)),
+                             static_cast<int>(floorf(y[i] * inverseCell)));
+    });
+
+    // Counting sort by bucket; stable, so equal buckets keep body order
+    bucketStart.assign(tableSize + 1, 0);
+    for (size_t i = 0; i < count; i++) bucketStart[bucketOf[i] + 1]++;
+    for (uint32_t b = 0; b < tableSize; b++) bucketStart[b + 1] += bucketStart[b];
+    sortedBody.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        sortedBody[bucketStart[bucketOf[i]]++] = static_cast<uint32_t>(i);
+    }
+    // The scatter advanced every start to the next bucket's start
+    for (uint32_t b = tableSize; b > 0; b--) bucketStart[b] = bucketStart[b - 1];
+    bucketStart[0] = 0;
+
+    sortedX.resize(count);
+    sortedY.resize(count);
+    sortedRadius.resize(count);
+    parallelFor(count, 4096, [&](size_t k) {
+        uint32_t body = sortedBody[k];
+        sortedX[k] = x[body];
+        sortedY[k] = y[body];
+        sortedRadius[k] = radius[body];
+    });
+}
+
+void SpatialHashGrid::findPairs(std::vector<BodyPair>& pairs) {
+    size_t count = sortedBody.size();
+    float inverseCell = 1.0f / cellSize;
+    parallelFor(PAIR_CHUNKS, 1, [&](size_t chunk) {
+        std::vector<BodyPair>& out = chunkPairs[chunk];
+        out.clear();
+        for (size_t k = count * chunk / PAIR_CHUNKS; k < count * (chunk + 1) / PAIR_CHUNKS; k++) {
+            int cellX = static_cast<int>(floorf(sortedX[k] * inverseCell));
+            int cellY = static_cast<int>(floorf(sortedY[k] * inverseCell));
+
+            // Only later sorted positions are tested, so each pair shows up once
+            auto scan = [&](uint32_t firstBucket, uint32_t endBucket) {
+                for (uint32_t m = std::max<uint32_t>(bucketStart[firstBucket], k + 1);
+                     m < bucketStart[endBucket]; m++) {
+                    if (circlesOverlap(sortedX[k], sortedY[k], sortedRadius[k],
+                                       sortedX[m], sortedY[m], sortedRadius[m])) {
+                        out.push_back(orderedPair(sortedBody[k], sortedBody[m]));
+                    }
+                }
+            };
+
+            // The three cells of a row are consecutive buckets, so each row
+            // is one contiguous run of the sorted arrays (two if it wraps)
+            uint32_t tableSize = tableMask + 1;
+            for (int dy = -1; dy <= 1; dy++) {
+                uint32_t first = bucket(cellX - 1, cellY + dy);
+                scan(first, std::min(first + 3, tableSize));
+                if (first + 3 > tableSize) scan(0, first + 3 - tableSize);
+            }
+        }
+    });
+    gatherPairs(pairs);
+}
+
+void SweepAndPrune::reserve(size_t count) {
+    // Capacity only: order must keep its size, which says whether it holds
+    // last step's order
+    Broadphase::reserve(count);
+    order.reserve(count);
+    minX.reserve(count);
+    sortedMinX.reserve(count);
+    sortedMaxX.reserve(count);
+    sortedX.reserve(count);
+    sortedY.reserve(count);
+    sortedRadius.reserve(count);
+}
+
+void SweepAndPrune::build(const float* x, const float* y, const float* radius, size_t count) {
+    minX.resize(count);
+    parallelFor(count, 4096, [&](size_t i) { minX[i] = x[i] - radius[i]; });
+
+    // Ties go by body index, so the order (and with it the pair order) is
+    // the same however it was reached; replays depend on that
+    auto byMinX = [&](uint32_t a, uint32_t b) { return minX[a] < minX[b] || (minX[a] == minX[b] && a < b); };
+    if (order.size() != count) {
+        order.resize(count);
+        for (size_t i = 0; i < count; i++) order[i] = static_cast<uint32_t>(i);
+        std::sort(order.begin(), order.end(), byMinX);
+    } else {
+        // Insertion sort from last step's order. If the bodies were shuffled
+        // too much for that to pay off, finish with a full sort instead.
+        size_t shifts = 0, budget = 16 * count;
+        for (size_t i = 1; i < count && shifts <= budget; i++) {
+            uint32_t body = order[i];
+            size_t j = i;
+            for (; j > 0 && byMinX(body, order[j - 1]); j--) order[j] = order[j - 1];
+            order[j] = body;
+            shifts += i - j;
+        }
+        if (shifts > budget) std::sort(order.begin(), order.end(), byMinX);
+    }
+
+    sortedMinX.resize(count);
+    sortedMaxX.resize(count);
+    sortedX.resize(count);
+    sortedY.resize(count);
+    sortedRadius.resize(count);
+    parallelFor(count, 4096, [&](size_t k) {
+        uint32_t body = order[k];
+        sortedMinX[k] = minX[body];
+        sortedMaxX[k] = x[body] + radius[body];
+        sortedX[k] = x[body];
+        sortedY[k] = y[body];
+        sortedRadius[k] = radius[body];
+    });
+}
+
+void SweepAndPrune::findPairs(std::vector<BodyPair>& pairs) {
+    size_t count = order.size();
+    parallelFor(PAIR_CHUNKS, 1, [&](size_t chunk) {
+        std::vector<BodyPair>& out = chunkPairs[chunk];
+        out.clear();
+        for (size_t k = count * chunk / PAIR_CHUNKS; k < count * (chunk + 1) / PAIR_CHUNKS; k++) {
+            for (size_t m = k + 1; m < count && sortedMinX[m] <= sortedMaxX[k]; m++) {
+                if (circlesOverlap(sortedX[k], sortedY[k], sortedRadius[k],
+                                   sortedX[m], sortedY[m], sortedRadius[m])) {
+                    out.push_back(orderedPair(order[k], order[m]));
+                }
+            }
+        }
+    });
+    gatherPairs(pairs);
+}
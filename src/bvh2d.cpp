@@ -0,0 +1,134 @@
+#include "bvh2d.h"
+#include <algorithm>
+
+void Bvh2D::build(const std::vector<Aabb2D>& primitiveBounds) {
+    nodes.clear();
+    primitiveIndices.resize(primitiveBounds.size());
+    centroids.resize(primitiveBounds.size());
+    if (primitiveBounds.empty()) return;
+
+    for (size_t i = 0; i < primitiveBounds.size(); i++) {
+        primitiveIndices[i] = static_cast<int>(i);
+        centroids[i] = primitiveBounds[i].center();
+    }
+
+    // A binary tree over N primitives never needs more than 2N - 1 nodes
+    nodes.reserve(primitiveBounds.size() * 2);
+    Node root;
+    root.leftFirst = 0;
+    root.count = static_cast<int>(primitiveBounds.size());
+    nodes.push_back(root);
+
+    // Iterative subdivision keeps the depth bounded by the traversal stack
+    std::vector<std::pair<int, int>> pending;  // (node, depth)
+    pending.push_back(std::make_pair(0, 0));
+    while (!pending.empty()) {
+        int nodeIndex = pending.back().first;
+        int depth = pending.back().second;
+        pending.pop_back();
+
+        Node& node = nodes[nodeIndex];
+        node.bounds = Aabb2D();
+        for (int i = 0; i < node.count; i++) {
+            node.bounds.grow(primitiveBounds[primitiveIndices[node.leftFirst + i]]);
+        }
+        if (depth >= STACK_SIZE - 2) continue;
+
+        subdivide(nodeIndex, primitiveBounds);
+        if (nodes[nodeIndex].count == 0) {
+            int left = nodes[nodeIndex].leftFirst;
+            pending.push_back(std::make_pair(left, depth + 1));
+            pending.push_back(std::make_pair(left + 1, depth + 1));
+        }
+    }
+    centroids.clear();
+    centroids.shrink_to_fit();
+}
+
+void Bvh2D::subdivide(int nodeIndex, const std::vector<Aabb2D>& primitiveBounds) {
+    Node& node = nodes[nodeIndex];
+    if (node.count <= 1) return;
+
+    Aabb2D centroidBounds;
+    for (int i = 0; i < node.count; i++) {
+        centroidBounds.grow(centroids[primitiveIndices[node.leftFirst + i]]);
+    }
+
+    // Binned SAH: evaluate BIN_COUNT - 1 split planes on both axes
+    float bestCost = 1e30f;
+    int bestAxis = -1;
+    int bestSplit = 0;
+    for (int axis = 0; axis < 2; axis++) {
+        float lo = centroidBounds.min[axis];
+        float hi = centroidBounds.max[axis];
+        if (hi - lo < 1e-6f) continue;
+
+        Aabb2D binBounds[BIN_COUNT];
+        int binCount[BIN_COUNT] = {};
+        float scale = BIN_COUNT / (hi - lo);
+        for (int i = 0; i < node.count; i++) {
+            int prim = primitiveIndices[node.leftFirst + i];
+            int bin = std::min(BIN_COUNT - 1, static_cast<int>((centroids[prim][axis] - lo) * scale));
+            binCount[bin]++;
+            binBounds[bin].grow(primitiveBounds[prim]);
+        }
+
+        // Sweep from both ends so each plane is costed in O(1)
+        float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+        int leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+        Aabb2D leftBox, rightBox;
+        int leftSum = 0, rightSum = 0;
+        for (int i = 0; i < BIN_COUNT - 1; i++) {
+            leftSum += binCount[i];
+            leftCount[i] = leftSum;
+            leftBox.grow(binBounds[i]);
+            leftArea[i] = leftBox.perimeter();
+
+            rightSum += binCount[BIN_COUNT - 1 - i];
+            rightCount[BIN_COUNT - 2 - i] = rightSum;
+            rightBox.grow(binBounds[BIN_COUNT - 1 - i]);
+            rightArea[BIN_COUNT - 2 - i] = rightBox.perimeter();
+        }
+        for (int i = 0; i < BIN_COUNT - 1; i++) {
+            if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+            float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+
+    // Keep the leaf if splitting is not cheaper than testing everything.
+    // Costs are relative to one primitive test; a traversal step costs about as much.
+    float parentArea = node.bounds.perimeter();
+    float splitCost = TRAVERSAL_COST + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+    float leafCost = static_cast<float>(node.count);
+    if (bestAxis < 0 || (splitCost >= leafCost && node.count <= MAX_LEAF_SIZE)) return;
+
+    float lo = centroidBounds.min[bestAxis];
+    float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - lo);
+    int* first = primitiveIndices.data() + node.leftFirst;
+    int* last = first + node.count;
+    int* middle = std::partition(first, last, [&](int prim) {
+        int bin = std::min(BIN_COUNT - 1, static_cast<int>((centroids[prim][bestAxis] - lo) * scale));
+        return bin <= bestSplit;
+    });
+
+    int leftCount = static_cast<int>(middle - first);
+    if (leftCount == 0 || leftCount == node.count) return;
+
+    Node left, right;
+    left.leftFirst = node.leftFirst;
+    left.count = leftCount;
+    right.leftFirst = node.leftFirst + leftCount;
+    right.count = node.count - leftCount;
+
+    int leftIndex = static_cast<int>(nodes.size());
+    node.leftFirst = leftIndex;
+    node.count = 0;
+    // node is a reference into nodes; push_back cannot reallocate thanks to reserve()
+    nodes.push_back(left);
+    nodes.push_back(right);
+}
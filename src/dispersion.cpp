@@ -0,0 +1,115 @@
+#include "dispersion.h"
+#include <cmath>
+
+float DispersionModel::indexAt(float wavelength) const {
+    float l = wavelength * 1e-3f;  // nm -> um
+    float l2 = l * l;
+    switch (type) {
+        case Cauchy:
+            return a[0] + a[1] / l2 + a[2] / (l2 * l2);
+        case Sellmeier: {
+            float n2 = 1.0f;
+            for (int i = 0; i < 3; i++) {
+                n2 += b[i] * l2 / (l2 - c[i]);
+            }
+            return sqrtf(n2);
+        }
+        case Constant:
+        default:
+            return a[0];
+    }
+}
+
+DispersionModel DispersionModel::constant(float n) {
+    DispersionModel model;
+    model.type = Constant;
+    model.a[0] = n;
+    return model;
+}
+
+DispersionModel DispersionModel::cauchy(float a0, float a1, float a2) {
+    DispersionModel model;
+    model.type = Cauchy;
+    model.a[0] = a0;
+    model.a[1] = a1;
+    model.a[2] = a2;
+    return model;
+}
+
+DispersionModel DispersionModel::sellmeier(const float (&b)[3], const float (&c)[3]) {
+    DispersionModel model;
+    model.type = Sellmeier;
+    for (int i = 0; i < 3; i++) {
+        model.b[i] = b[i];
+        model.c[i] = c[i];
+    }
+    return model;
+}
+
+const char* dispersionPresetName(DispersionPreset preset) {
+    switch (preset) {
+        case DispersionPreset::Custom: return "Custom (constant)";
+        case DispersionPreset::Water: return "Water";
+        case DispersionPreset::CrownGlass: return "Crown glass";
+        case DispersionPreset::BK7: return "Schott N-BK7";
+        case DispersionPreset::FusedSilica: return "Fused silica";
+        case DispersionPreset::FlintSF11: return "Schott SF11 flint";
+        default: return "";
+    }
+}
+
+DispersionModel dispersionPreset(DispersionPreset preset, float customIndex) {
+    switch (preset) {
+        case DispersionPreset::Water:
+            return DispersionModel::cauchy(1.3240f, 0.003046f);
+        case DispersionPreset::CrownGlass:
+            return DispersionModel::cauchy(1.5046f, 0.00420f);
+        case DispersionPreset::BK7: {
+            const float b[3] = { 1.03961212f, 0.231792344f, 1.01046945f };
+            const float c[3] = { 0.00600069867f, 0.0200179144f, 103.560653f };
+            return DispersionModel::sellmeier(b, c);
+        }
+        case DispersionPreset::FusedSilica: {
+            const float b[3] = { 0.6961663f, 0.4079426f, 0.8974794f };
+            const float c[3] = { 0.0046791f, 0.0135121f, 97.934003f };
+            return DispersionModel::sellmeier(b, c);
+        }
+        case DispersionPreset::FlintSF11: {
+            const float b[3] = { 1.73759695f, 0.313747346f, 1.89878101f };
+            const float c[3] = { 0.013188707f, 0.0623068142f, 155.23629f };
+            return DispersionModel::sellmeier(b, c);
+        }
+        case DispersionPreset::Custom:
+        default:
+            return DispersionModel::constant(customIndex);
+    }
+}
+
+namespace {
+// Piecewise Gaussian fit of the CIE 1931 colour matching functions
+// (Wyman, Sloan and Shirley 2013)
+float lobe(float x, float mu, float sigmaLow, float sigmaHigh) {
+    float t = (x - mu) / (x < mu ? sigmaLow : sigmaHigh);
+    return expf(-0.5f * t * t);
+}
+}
+
+glm::vec3 wavelengthToRgb(float wavelength) {
+    float x = 1.056f * lobe(wavelength, 599.8f, 37.9f, 31.0f)
+            + 0.362f * lobe(wavelength, 442.0f, 16.0f, 26.7f)
+            - 0.065f * lobe(wavelength, 501.1f, 20.4f, 26.2f);
+    float y = 0.821f * lobe(wavelength, 568.8f, 46.9f, 40.5f)
+            + 0.286f * lobe(wavelength, 530.9f, 16.3f, 31.1f);
+    float z = 1.217f * lobe(wavelength, 437.0f, 11.8f, 36.0f)
+            + 0.681f * lobe(wavelength, 459.0f, 26.0f, 13.8f);
+
+    // XYZ -> linear sRGB
+    glm::vec3 rgb(3.2406f * x - 1.5372f * y - 0.4986f * z,
+                  -0.9689f * x + 1.8758f * y + 0.0415f * z,
+                  0.0557f * x - 0.2040f * y + 1.0570f * z);
+    rgb = glm::max(rgb, glm::vec3(0.0f));
+
+    // White balance: per channel scale so that an equal energy spectrum
+    // sampled evenly over [WAVELENGTH_MIN, WAVELENGTH_MAX] averages to (1, 1, 1)
+    return rgb * glm::vec3(1.9298f, 2.9469f, 3.1108f);
+}
@@ -0,0 +1,189 @@
+#include "feedback_tracer.h"
+#include "shader_utils.h"
+#include "render_backend.h"
+#include <cmath>
+#include <iostream>
+
+constexpr auto FEEDBACK_VERTEX_SHADER_PATH = "../shaders/refraction_feedback.vert";
+constexpr auto FEEDBACK_GEOMETRY_SHADER_PATH = "../shaders/refraction_feedback.geom";
+
+bool FeedbackRayTracer::init() {
+    try {
+        program = ShaderUtils::make_feedback_shader(FEEDBACK_VERTEX_SHADER_PATH,
+                                                    FEEDBACK_GEOMETRY_SHADER_PATH,
+                                                    { "outPosition", "outIntensity" });
+    } catch (const std::exception& e) {
+        std::cerr << "GPU ray tracing unavailable: " << e.what() << std::endl;
+        program = 0;
+    }
+    if (!program) return false;
+
+    // Source rays: (origin, direction, intensity), one point each
+    rayVAO = RenderBackend::createVertexArray();
+    rayVBO = RenderBackend::createBuffer();
+    RenderBackend::bindVertexArray(rayVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, rayVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    // Captured segments, drawn with the regular ray shader
+    outputVAO = RenderBackend::createVertexArray();
+    outputVBO = RenderBackend::createBuffer();
+    RenderBackend::bindVertexArray(outputVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, outputVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    RenderBackend::bindVertexArray(0);
+
+    GLuint buffers[3], textures[3];
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+    nodeBuffer = buffers[0];
+    segmentBuffer = buffers[1];
+    materialBuffer = buffers[2];
+    nodeTexture = textures[0];
+    segmentTexture = textures[1];
+    materialTexture = textures[2];
+    glGenQueries(1, &primitivesQuery);
+
+    RenderBackend::useProgram(program);
+    glUniform1i(glGetUniformLocation(program, "nodes"), 0);
+    glUniform1i(glGetUniformLocation(program, "segments"), 1);
+    glUniform1i(glGetUniformLocation(program, "materials"), 2);
+    return true;
+}
+
+void FeedbackRayTracer::uploadTexture(GLuint buffer, GLuint texture, GLenum format,
+                                      const void* data, size_t bytes) {
+    RenderBackend::bindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    RenderBackend::bindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void FeedbackRayTracer::uploadScene(const OpticalScene& scene, int arcSegments) {
+    if (!isAvailable()) return;
+
+    // Arcs become chords walked counter-clockwise, which keeps the outside
+    // of the circle on the right, i.e. on the front side like a segment
+    struct Segment {
+        glm::vec2 p0, p1;
+        int front, back;
+    };
+    std::vector<Segment> flat;
+    for (const OpticalPrimitive& prim : scene.getPrimitives()) {
+        if (prim.type == OpticalPrimitive::Segment) {
+            flat.push_back({ prim.p0, prim.p1, prim.frontMaterial, prim.backMaterial });
+            continue;
+        }
+        for (int i = 0; i < arcSegments; i++) {
+            float a0 = prim.angleStart + prim.angleSpan * i / arcSegments;
+            float a1 = prim.angleStart + prim.angleSpan * (i + 1) / arcSegments;
+            flat.push_back({ prim.center + prim.radius * glm::vec2(cosf(a0), sinf(a0)),
+                             prim.center + prim.radius * glm::vec2(cosf(a1), sinf(a1)),
+                             prim.frontMaterial, prim.backMaterial });
+        }
+    }
+
+    std::vector<Aabb2D> bounds(flat.size());
+    for (size_t i = 0; i < flat.size(); i++) {
+        bounds[i].grow(flat[i].p0);
+        bounds[i].grow(flat[i].p1);
+    }
+    Bvh2D bvh;
+    bvh.build(bounds);
+
+    // Two RGBA32F texels per node and per segment. Segments are stored in
+    // leaf order, so a leaf's primitives are texels first..first+count.
+    std::vector<glm::vec4> nodeTexels;
+    for (const Bvh2D::Node& node : bvh.getNodes()) {
+        nodeTexels.push_back(glm::vec4(node.bounds.min, node.bounds.max));
+        nodeTexels.push_back(glm::vec4(node.leftFirst, node.count, 0.0f, 0.0f));
+    }
+    std::vector<glm::vec4> segmentTexels;
+    for (int index : bvh.getPrimitiveIndices()) {
+        const Segment& segment = flat[index];
+        segmentTexels.push_back(glm::vec4(segment.p0, segment.p1));
+        segmentTexels.push_back(glm::vec4(segment.front, segment.back, 0.0f, 0.0f));
+    }
+    nodeCount = static_cast<int>(bvh.getNodes().size());
+
+    uploadTexture(nodeBuffer, nodeTexture, GL_RGBA32F, nodeTexels.data(),
+                  nodeTexels.size() * sizeof(glm::vec4));
+    uploadTexture(segmentBuffer, segmentTexture, GL_RGBA32F, segmentTexels.data(),
+                  segmentTexels.size() * sizeof(glm::vec4));
+}
+
+size_t FeedbackRayTracer::trace(const OpticalScene& scene, const float* rays, size_t rayCount,
+                                const FresnelSettings& settings, float sFraction) {
+    vertexCount = 0;
+    if (!isAvailable() || rayCount == 0) return 0;
+
+    std::vector<float> indices;
+    for (const OpticalMaterial& material : scene.getMaterials()) {
+        indices.push_back(material.index);
+    }
+    uploadTexture(materialBuffer, materialTexture, GL_R32F, indices.data(),
+                  indices.size() * sizeof(float));
+
+    RenderBackend::bufferData(rayVBO, rayCount * 5 * sizeof(float), rays, GL_STREAM_DRAW);
+
+    // Room for every ray to use its full depth; only grows
+    size_t needed = rayCount * MAX_DEPTH * 2;
+    if (needed > outputCapacity) {
+        outputCapacity = needed;
+        RenderBackend::bufferData(outputVBO, outputCapacity * 3 * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    }
+
+    RenderBackend::useProgram(program);
+    glUniform1i(glGetUniformLocation(program, "nodeCount"), nodeCount);
+    glUniform1i(glGetUniformLocation(program, "maxDepth"), settings.maxDepth);
+    glUniform1f(glGetUniformLocation(program, "intensityCutoff"), settings.intensityCutoff);
+    glUniform1f(glGetUniformLocation(program, "escapeDistance"), OpticalScene::ESCAPE_DISTANCE);
+    glUniform2f(glGetUniformLocation(program, "polarization"), sFraction, 1.0f - sFraction);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, nodeTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, segmentTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, materialTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, outputVBO);
+    RenderBackend::bindVertexArray(rayVAO);
+    glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, primitivesQuery);
+    glBeginTransformFeedback(GL_LINES);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(rayCount));
+    glEndTransformFeedback();
+    glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    // Waits for the GPU; traces only run when a parameter changed
+    GLuint lines = 0;
+    glGetQueryObjectuiv(primitivesQuery, GL_QUERY_RESULT, &lines);
+    vertexCount = static_cast<size_t>(lines) * 2;
+    return vertexCount;
+}
+
+FeedbackRayTracer::~FeedbackRayTracer() {
+    if (!program) return;
+    RenderBackend::deleteProgram(program);
+    RenderBackend::deleteVertexArrays(1, &rayVAO);
+    RenderBackend::deleteBuffers(1, &rayVBO);
+    RenderBackend::deleteVertexArrays(1, &outputVAO);
+    RenderBackend::deleteBuffers(1, &outputVBO);
+    GLuint buffers[3] = { nodeBuffer, segmentBuffer, materialBuffer };
+    GLuint textures[3] = { nodeTexture, segmentTexture, materialTexture };
+    RenderBackend::deleteBuffers(3, buffers);
+    glDeleteTextures(3, textures);
+    glDeleteQueries(1, &primitivesQuery);
+}
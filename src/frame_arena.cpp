@@ -0,0 +1,57 @@
+#include "frame_arena.h"
+#include <algorithm>
+#include <cstring>
+
+FrameArena* FrameArena::instance = nullptr;
+
+#ifndef NDEBUG
+static void poison(void* bytes, int value, size_t length) { memset(bytes, value, length); }
+#else
+static void poison(void*, int, size_t) {}
+#endif
+
+FrameArena::FrameArena(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {
+    block = static_cast<char*>(::operator new(this->capacity));
+}
+
+FrameArena::~FrameArena() {
+    if (instance == this) instance = nullptr;
+    for (char* extra : overflow) ::operator delete(extra);
+    ::operator delete(block);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    allocationCount++;
+    size_t start = (offset + alignment - 1) & ~(alignment - 1);
+    if (start + bytes <= capacity) {
+        frameBytes += start + bytes - offset;
+        offset = start + bytes;
+        poison(block + start, 0xCD, bytes);
+        return block + start;
+    }
+
+    // Out of room: this allocation gets a block of its own for now (the
+    // global allocator aligns for any fundamental type)
+    char* extra = static_cast<char*>(::operator new(std::max<size_t>(bytes, 1)));
+    overflow.push_back(extra);
+    frameBytes += bytes;
+    poison(extra, 0xCD, bytes);
+    return extra;
+}
+
+void FrameArena::reset() {
+    highWaterMark = std::max(highWaterMark, frameBytes);
+    poison(block, 0xDD, offset);
+    if (!overflow.empty()) {
+        for (char* extra : overflow) ::operator delete(extra);
+        overflow.clear();
+        // One block for all of the frame that overflowed, with headroom
+        ::operator delete(block);
+        capacity = std::max(2 * capacity, frameBytes + frameBytes / 2);
+        block = static_cast<char*>(::operator new(capacity));
+        growCount++;
+    }
+    offset = 0;
+    frameBytes = 0;
+    allocationCount = 0;
+}
@@ -0,0 +1,566 @@
+#include "gl_counters.h"
+#include <glad/glad.h>
+#include <algorithm>
+
+namespace {
+
+GlCounters::Stats frame, previous, total;
+uint64_t frameCount = 0;
+bool installed = false;
+
+// What the counted calls last set. UNKNOWN until set in this frame, except
+// the active texture unit: everything here leaves it at GL_TEXTURE0 and
+// ImGui puts back whatever it found, so each frame starts there.
+constexpr GLuint UNKNOWN = ~0u;
+constexpr int TEXTURE_UNITS = 16;
+const GLenum TRACKED_CAPS[] = { GL_BLEND, GL_PROGRAM_POINT_SIZE, GL_RASTERIZER_DISCARD, GL_DEPTH_TEST,
+                                GL_CULL_FACE, GL_SCISSOR_TEST };
+constexpr int CAP_COUNT = sizeof(TRACKED_CAPS) / sizeof(TRACKED_CAPS[0]);
+
+struct Shadow {
+    GLuint program, vertexArray, arrayBuffer;
+    GLuint activeUnit;
+    GLuint textures[TEXTURE_UNITS];
+    int caps[CAP_COUNT];                // -1 unknown, else 0 or 1
+    GLenum blendSource, blendDestination;
+    float pointSize;
+} shadow;
+
+void forgetState() {
+    shadow.program = shadow.vertexArray = shadow.arrayBuffer = UNKNOWN;
+    shadow.activeUnit = GL_TEXTURE0;
+    std::fill(shadow.textures, shadow.textures + TEXTURE_UNITS, UNKNOWN);
+    std::fill(shadow.caps, shadow.caps + CAP_COUNT, -1);
+    shadow.blendSource = shadow.blendDestination = UNKNOWN;
+    shadow.pointSize = -1.0f;
+}
+
+// Counts a bind; true if it changes nothing
+bool bind(GLuint& current, GLuint name, uint64_t& binds, uint64_t& redundant) {
+    frame.calls++;
+    binds++;
+    if (current == name) {
+        redundant++;
+        return true;
+    }
+    current = name;
+    return false;
+}
+
+void stateChange(bool redundant) {
+    frame.calls++;
+    frame.stateChanges++;
+    if (redundant) frame.redundantStateChanges++;
+}
+
+void upload(uint64_t bytes) {
+    frame.calls++;
+    frame.uploads++;
+    frame.uploadBytes += bytes;
+}
+
+void query() {
+    frame.calls++;
+    frame.queries++;
+}
+
+void uniform() {
+    frame.calls++;
+    frame.uniforms++;
+}
+
+uint64_t textureBytes(GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+    if (!pixels) return 0;
+    uint64_t components = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGB ? 3 : 4;
+    uint64_t size = type == GL_FLOAT || type == GL_INT || type == GL_UNSIGNED_INT ? 4
+                  : type == GL_HALF_FLOAT || type == GL_SHORT || type == GL_UNSIGNED_SHORT ? 2 : 1;
+    return static_cast<uint64_t>(width) * height * components * size;
+}
+
+// The real entry points, saved by install()
+PFNGLDRAWARRAYSPROC realDrawArrays;
+PFNGLDRAWELEMENTSPROC realDrawElements;
+PFNGLDRAWARRAYSINSTANCEDPROC realDrawArraysInstanced;
+PFNGLDRAWELEMENTSINSTANCEDPROC realDrawElementsInstanced;
+PFNGLMULTIDRAWARRAYSPROC realMultiDrawArrays;
+PFNGLUSEPROGRAMPROC realUseProgram;
+PFNGLBINDVERTEXARRAYPROC realBindVertexArray;
+PFNGLBINDBUFFERPROC realBindBuffer;
+PFNGLBINDBUFFERBASEPROC realBindBufferBase;
+PFNGLACTIVETEXTUREPROC realActiveTexture;
+PFNGLBINDTEXTUREPROC realBindTexture;
+PFNGLDELETEPROGRAMPROC realDeleteProgram;
+PFNGLDELETEVERTEXARRAYSPROC realDeleteVertexArrays;
+PFNGLDELETEBUFFERSPROC realDeleteBuffers;
+PFNGLDELETETEXTURESPROC realDeleteTextures;
+PFNGLBUFFERDATAPROC realBufferData;
+PFNGLBUFFERSUBDATAPROC realBufferSubData;
+PFNGLTEXIMAGE2DPROC realTexImage2D;
+PFNGLTEXSUBIMAGE2DPROC realTexSubImage2D;
+PFNGLTEXPARAMETERIPROC realTexParameteri;
+PFNGLTEXBUFFERPROC realTexBuffer;
+PFNGLGETUNIFORMLOCATIONPROC realGetUniformLocation;
+PFNGLUNIFORM1IPROC realUniform1i;
+PFNGLUNIFORM1FPROC realUniform1f;
+PFNGLUNIFORM2FPROC realUniform2f;
+PFNGLUNIFORM2FVPROC realUniform2fv;
+PFNGLUNIFORM3FPROC realUniform3f;
+PFNGLUNIFORM4FPROC realUniform4f;
+PFNGLUNIFORMMATRIX4FVPROC realUniformMatrix4fv;
+PFNGLENABLEPROC realEnable;
+PFNGLDISABLEPROC realDisable;
+PFNGLBLENDFUNCPROC realBlendFunc;
+PFNGLPOINTSIZEPROC realPointSize;
+PFNGLVERTEXATTRIBPOINTERPROC realVertexAttribPointer;
+PFNGLENABLEVERTEXATTRIBARRAYPROC realEnableVertexAttribArray;
+PFNGLVERTEXATTRIBIPOINTERPROC realVertexAttribIPointer;
+PFNGLVERTEXATTRIBDIVISORPROC realVertexAttribDivisor;
+PFNGLVERTEXATTRIB4FVPROC realVertexAttrib4fv;
+PFNGLVIEWPORTPROC realViewport;
+PFNGLCLEARCOLORPROC realClearColor;
+PFNGLCLEARPROC realClear;
+PFNGLBEGINTRANSFORMFEEDBACKPROC realBeginTransformFeedback;
+PFNGLENDTRANSFORMFEEDBACKPROC realEndTransformFeedback;
+PFNGLBEGINQUERYPROC realBeginQuery;
+PFNGLENDQUERYPROC realEndQuery;
+PFNGLGETINTEGERVPROC realGetIntegerv;
+PFNGLGETSTRINGPROC realGetString;
+PFNGLGETSTRINGIPROC realGetStringi;
+PFNGLGETQUERYOBJECTUIVPROC realGetQueryObjectuiv;
+PFNGLFINISHPROC realFinish;
+
+void APIENTRY countedDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    frame.calls++;
+    frame.draws++;
+    frame.vertices += count;
+    realDrawArrays(mode, first, count);
+}
+
+void APIENTRY countedDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    frame.calls++;
+    frame.draws++;
+    frame.vertices += count;
+    realDrawElements(mode, count, type, indices);
+}
+
+void APIENTRY countedDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    frame.calls++;
+    frame.draws++;
+    frame.vertices += static_cast<uint64_t>(count) * instances;
+    realDrawArraysInstanced(mode, first, count, instances);
+}
+
+void APIENTRY countedDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                           GLsizei instances) {
+    frame.calls++;
+    frame.draws++;
+    frame.vertices += static_cast<uint64_t>(count) * instances;
+    realDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+// One call, but the driver still does drawCount draws' worth of validation
+void APIENTRY countedMultiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawCount) {
+    frame.calls++;
+    frame.draws++;
+    for (GLsizei i = 0; i < drawCount; i++) frame.vertices += count[i];
+    realMultiDrawArrays(mode, first, count, drawCount);
+}
+
+void APIENTRY countedUseProgram(GLuint program) {
+    bind(shadow.program, program, frame.programBinds, frame.redundantProgramBinds);
+    realUseProgram(program);
+}
+
+void APIENTRY countedBindVertexArray(GLuint vertexArray) {
+    bind(shadow.vertexArray, vertexArray, frame.vertexArrayBinds, frame.redundantVertexArrayBinds);
+    realBindVertexArray(vertexArray);
+}
+
+void APIENTRY countedBindBuffer(GLenum target, GLuint buffer) {
+    if (target == GL_ARRAY_BUFFER) {
+        bind(shadow.arrayBuffer, buffer, frame.bufferBinds, frame.redundantBufferBinds);
+    } else {
+        frame.calls++;
+        frame.bufferBinds++;
+    }
+    realBindBuffer(target, buffer);
+}
+
+// Indexed targets (transform feedback, uniform blocks); never ARRAY_BUFFER
+void APIENTRY countedBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    frame.calls++;
+    frame.bufferBinds++;
+    realBindBufferBase(target, index, buffer);
+}
+
+void APIENTRY countedActiveTexture(GLenum unit) {
+    stateChange(shadow.activeUnit == unit);
+    shadow.activeUnit = unit;
+    realActiveTexture(unit);
+}
+
+void APIENTRY countedBindTexture(GLenum target, GLuint texture) {
+    GLuint unit = shadow.activeUnit - GL_TEXTURE0;
+    if (target == GL_TEXTURE_2D && unit < TEXTURE_UNITS) {
+        bind(shadow.textures[unit], texture, frame.textureBinds, frame.redundantTextureBinds);
+    } else {
+        frame.calls++;
+        frame.textureBinds++;
+    }
+    realBindTexture(target, texture);
+}
+
+// Deleted names can come back from glGen*, so they must not look bound
+void APIENTRY countedDeleteProgram(GLuint program) {
+    frame.calls++;
+    if (shadow.program == program) shadow.program = UNKNOWN;
+    realDeleteProgram(program);
+}
+
+void APIENTRY countedDeleteVertexArrays(GLsizei count, const GLuint* names) {
+    frame.calls++;
+    for (GLsizei i = 0; i < count; i++) {
+        if (shadow.vertexArray == names[i]) shadow.vertexArray = UNKNOWN;
+    }
+    realDeleteVertexArrays(count, names);
+}
+
+void APIENTRY countedDeleteBuffers(GLsizei count, const GLuint* names) {
+    frame.calls++;
+    for (GLsizei i = 0; i < count; i++) {
+        if (shadow.arrayBuffer == names[i]) shadow.arrayBuffer = UNKNOWN;
+    }
+    realDeleteBuffers(count, names);
+}
+
+void APIENTRY countedDeleteTextures(GLsizei count, const GLuint* names) {
+    frame.calls++;
+    for (GLsizei i = 0; i < count; i++) {
+        for (GLuint& texture : shadow.textures) {
+            if (texture == names[i]) texture = UNKNOWN;
+        }
+    }
+    realDeleteTextures(count, names);
+}
+
+void APIENTRY countedBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    upload(data ? size : 0);
+    realBufferData(target, size, data, usage);
+}
+
+void APIENTRY countedBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    upload(size);
+    realBufferSubData(target, offset, size, data);
+}
+
+void APIENTRY countedTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                                GLint border, GLenum format, GLenum type, const void* pixels) {
+    upload(textureBytes(width, height, format, type, pixels));
+    realTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+void APIENTRY countedTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                                   GLenum format, GLenum type, const void* pixels) {
+    upload(textureBytes(width, height, format, type, pixels));
+    realTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+
+void APIENTRY countedTexParameteri(GLenum target, GLenum name, GLint value) {
+    stateChange(false);
+    realTexParameteri(target, name, value);
+}
+
+void APIENTRY countedTexBuffer(GLenum target, GLenum format, GLuint buffer) {
+    stateChange(false);
+    realTexBuffer(target, format, buffer);
+}
+
+GLint APIENTRY countedGetUniformLocation(GLuint program, const GLchar* name) {
+    frame.calls++;
+    frame.uniformLookups++;
+    return realGetUniformLocation(program, name);
+}
+
+void APIENTRY countedUniform1i(GLint location, GLint x) {
+    uniform();
+    realUniform1i(location, x);
+}
+
+void APIENTRY countedUniform1f(GLint location, GLfloat x) {
+    uniform();
+    realUniform1f(location, x);
+}
+
+void APIENTRY countedUniform2f(GLint location, GLfloat x, GLfloat y) {
+    uniform();
+    realUniform2f(location, x, y);
+}
+
+void APIENTRY countedUniform2fv(GLint location, GLsizei count, const GLfloat* value) {
+    uniform();
+    realUniform2fv(location, count, value);
+}
+
+void APIENTRY countedUniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+    uniform();
+    realUniform3f(location, x, y, z);
+}
+
+void APIENTRY countedUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    uniform();
+    realUniform4f(location, x, y, z, w);
+}
+
+void APIENTRY countedUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    uniform();
+    realUniformMatrix4fv(location, count, transpose, value);
+}
+
+// Counts an enable or disable, and whether it changed anything
+void capability(GLenum cap, int value) {
+    for (int i = 0; i < CAP_COUNT; i++) {
+        if (TRACKED_CAPS[i] == cap) {
+            stateChange(shadow.caps[i] == value);
+            shadow.caps[i] = value;
+            return;
+        }
+    }
+    stateChange(false);
+}
+
+void APIENTRY countedEnable(GLenum cap) {
+    capability(cap, 1);
+    realEnable(cap);
+}
+
+void APIENTRY countedDisable(GLenum cap) {
+    capability(cap, 0);
+    realDisable(cap);
+}
+
+void APIENTRY countedBlendFunc(GLenum source, GLenum destination) {
+    stateChange(shadow.blendSource == source && shadow.blendDestination == destination);
+    shadow.blendSource = source;
+    shadow.blendDestination = destination;
+    realBlendFunc(source, destination);
+}
+
+void APIENTRY countedPointSize(GLfloat size) {
+    stateChange(shadow.pointSize == size);
+    shadow.pointSize = size;
+    realPointSize(size);
+}
+
+void APIENTRY countedVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                         GLsizei stride, const void* pointer) {
+    stateChange(false);
+    realVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void APIENTRY countedEnableVertexAttribArray(GLuint index) {
+    stateChange(false);
+    realEnableVertexAttribArray(index);
+}
+
+void APIENTRY countedVertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride,
+                                          const void* pointer) {
+    stateChange(false);
+    realVertexAttribIPointer(index, size, type, stride, pointer);
+}
+
+void APIENTRY countedVertexAttribDivisor(GLuint index, GLuint divisor) {
+    stateChange(false);
+    realVertexAttribDivisor(index, divisor);
+}
+
+// The constant value of a disabled attribute array
+void APIENTRY countedVertexAttrib4fv(GLuint index, const GLfloat* value) {
+    stateChange(false);
+    realVertexAttrib4fv(index, value);
+}
+
+void APIENTRY countedViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    stateChange(false);
+    realViewport(x, y, width, height);
+}
+
+void APIENTRY countedClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    stateChange(false);
+    realClearColor(red, green, blue, alpha);
+}
+
+void APIENTRY countedClear(GLbitfield mask) {
+    frame.calls++;
+    realClear(mask);
+}
+
+void APIENTRY countedBeginTransformFeedback(GLenum mode) {
+    frame.calls++;
+    realBeginTransformFeedback(mode);
+}
+
+void APIENTRY countedEndTransformFeedback() {
+    frame.calls++;
+    realEndTransformFeedback();
+}
+
+void APIENTRY countedBeginQuery(GLenum target, GLuint id) {
+    frame.calls++;
+    realBeginQuery(target, id);
+}
+
+void APIENTRY countedEndQuery(GLenum target) {
+    frame.calls++;
+    realEndQuery(target);
+}
+
+void APIENTRY countedGetIntegerv(GLenum name, GLint* data) {
+    query();
+    realGetIntegerv(name, data);
+}
+
+const GLubyte* APIENTRY countedGetString(GLenum name) {
+    query();
+    return realGetString(name);
+}
+
+const GLubyte* APIENTRY countedGetStringi(GLenum name, GLuint index) {
+    query();
+    return realGetStringi(name, index);
+}
+
+// Waits for the GPU when the result is not in yet
+void APIENTRY countedGetQueryObjectuiv(GLuint id, GLenum name, GLuint* value) {
+    query();
+    realGetQueryObjectuiv(id, name, value);
+}
+
+// Not a glGet, but it stalls the same way
+void APIENTRY countedFinish() {
+    query();
+    realFinish();
+}
+
+template <typename Function>
+void wrap(Function& entry, Function& real, Function counted) {
+    real = entry;
+    if (entry) entry = counted;
+}
+
+void add(GlCounters::Stats& sum, const GlCounters::Stats& stats) {
+    sum.calls += stats.calls;
+    sum.draws += stats.draws;
+    sum.vertices += stats.vertices;
+    sum.programBinds += stats.programBinds;
+    sum.redundantProgramBinds += stats.redundantProgramBinds;
+    sum.vertexArrayBinds += stats.vertexArrayBinds;
+    sum.redundantVertexArrayBinds += stats.redundantVertexArrayBinds;
+    sum.bufferBinds += stats.bufferBinds;
+    sum.redundantBufferBinds += stats.redundantBufferBinds;
+    sum.textureBinds += stats.textureBinds;
+    sum.redundantTextureBinds += stats.redundantTextureBinds;
+    sum.uploads += stats.uploads;
+    sum.uploadBytes += stats.uploadBytes;
+    sum.uniforms += stats.uniforms;
+    sum.uniformLookups += stats.uniformLookups;
+    sum.stateChanges += stats.stateChanges;
+    sum.redundantStateChanges += stats.redundantStateChanges;
+    sum.queries += stats.queries;
+}
+
+}
+
+void GlCounters::install() {
+    if (installed) return;
+    installed = true;
+    forgetState();
+    wrap(glad_glDrawArrays, realDrawArrays, countedDrawArrays);
+    wrap(glad_glDrawElements, realDrawElements, countedDrawElements);
+    wrap(glad_glDrawArraysInstanced, realDrawArraysInstanced, countedDrawArraysInstanced);
+    wrap(glad_glDrawElementsInstanced, realDrawElementsInstanced, countedDrawElementsInstanced);
+    wrap(glad_glMultiDrawArrays, realMultiDrawArrays, countedMultiDrawArrays);
+    wrap(glad_glUseProgram, realUseProgram, countedUseProgram);
+    wrap(glad_glBindVertexArray, realBindVertexArray, countedBindVertexArray);
+    wrap(glad_glBindBuffer, realBindBuffer, countedBindBuffer);
+    wrap(glad_glBindBufferBase, realBindBufferBase, countedBindBufferBase);
+    wrap(glad_glActiveTexture, realActiveTexture, countedActiveTexture);
+    wrap(glad_glBindTexture, realBindTexture, countedBindTexture);
+    wrap(glad_glDeleteProgram, realDeleteProgram, countedDeleteProgram);
+    wrap(glad_glDeleteVertexArrays, realDeleteVertexArrays, countedDeleteVertexArrays);
+    wrap(glad_glDeleteBuffers, realDeleteBuffers, countedDeleteBuffers);
+    wrap(glad_glDeleteTextures, realDeleteTextures, countedDeleteTextures);
+    wrap(glad_glBufferData, realBufferData, countedBufferData);
+    wrap(glad_glBufferSubData, realBufferSubData, countedBufferSubData);
+    wrap(glad_glTexImage2D, realTexImage2D, countedTexImage2D);
+    wrap(glad_glTexSubImage2D, realTexSubImage2D, countedTexSubImage2D);
+    wrap(glad_glTexParameteri, realTexParameteri, countedTexParameteri);
+    wrap(glad_glTexBuffer, realTexBuffer, countedTexBuffer);
+    wrap(glad_glGetUniformLocation, realGetUniformLocation, countedGetUniformLocation);
+    wrap(glad_glUniform1i, realUniform1i, countedUniform1i);
+    wrap(glad_glUniform1f, realUniform1f, countedUniform1f);
+    wrap(glad_glUniform2f, realUniform2f, countedUniform2f);
+    wrap(glad_glUniform2fv, realUniform2fv, countedUniform2fv);
+    wrap(glad_glUniform3f, realUniform3f, countedUniform3f);
+    wrap(glad_glUniform4f, realUniform4f, countedUniform4f);
+    wrap(glad_glUniformMatrix4fv, realUniformMatrix4fv, countedUniformMatrix4fv);
+    wrap(glad_glEnable, realEnable, countedEnable);
+    wrap(glad_glDisable, realDisable, countedDisable);
+    wrap(glad_glBlendFunc, realBlendFunc, countedBlendFunc);
+    wrap(glad_glPointSize, realPointSize, countedPointSize);
+    wrap(glad_glVertexAttribPointer, realVertexAttribPointer, countedVertexAttribPointer);
+    wrap(glad_glEnableVertexAttribArray, realEnableVertexAttribArray, countedEnableVertexAttribArray);
+    wrap(glad_glVertexAttribIPointer, realVertexAttribIPointer, countedVertexAttribIPointer);
+    wrap(glad_glVertexAttribDivisor, realVertexAttribDivisor, countedVertexAttribDivisor);
+    wrap(glad_glVertexAttrib4fv, realVertexAttrib4fv, countedVertexAttrib4fv);
+    wrap(glad_glViewport, realViewport, countedViewport);
+    wrap(glad_glClearColor, realClearColor, countedClearColor);
+    wrap(glad_glClear, realClear, countedClear);
+    wrap(glad_glBeginTransformFeedback, realBeginTransformFeedback, countedBeginTransformFeedback);
+    wrap(glad_glEndTransformFeedback, realEndTransformFeedback, countedEndTransformFeedback);
+    wrap(glad_glBeginQuery, realBeginQuery, countedBeginQuery);
+    wrap(glad_glEndQuery, realEndQuery, countedEndQuery);
+    wrap(glad_glGetIntegerv, realGetIntegerv, countedGetIntegerv);
+    wrap(glad_glGetString, realGetString, countedGetString);
+    wrap(glad_glGetStringi, realGetStringi, countedGetStringi);
+    wrap(glad_glGetQueryObjectuiv, realGetQueryObjectuiv, countedGetQueryObjectuiv);
+    wrap(glad_glFinish, realFinish, countedFinish);
+}
+
+bool GlCounters::isInstalled() { return installed; }
+
+void GlCounters::recordUpload(uint64_t bytes) {
+    if (installed) upload(bytes);
+}
+
+void GlCounters::recordStateChanges(uint64_t count) {
+    if (!installed) return;
+    frame.calls += count;
+    frame.stateChanges += count;
+}
+
+void GlCounters::endFrame() {
+    previous = frame;
+    add(total, frame);
+    frame = Stats();
+    frameCount++;
+    // ImGui draws through its own loader after the simulations; whatever
+    // it leaves bound is not known here
+    forgetState();
+}
+
+const GlCounters::Stats& GlCounters::lastFrame() { return previous; }
+const GlCounters::Stats& GlCounters::totals() { return total; }
+uint64_t GlCounters::getFrameCount() { return frameCount; }
+
+void GlCounters::printSummary(std::ostream& out) {
+    if (frameCount == 0) return;
+    double frames = static_cast<double>(frameCount);
+    out << "GL calls per frame over " << frameCount << " frames: " << total.calls / frames << " calls, "
+        << total.draws / frames << " draws (" << total.vertices / frames << " vertices), "
+        << total.programBinds / frames << " program binds, " << total.vertexArrayBinds / frames << " VAO binds, "
+        << total.bufferBinds / frames << " buffer binds, " << total.uploads / frames << " uploads ("
+        << total.uploadBytes / frames / 1024.0 << " KB), " << total.uniforms / frames << " uniforms, "
+        << total.uniformLookups / frames << " uniform lookups, " << total.stateChanges / frames
+        << " state changes, " << total.queries / frames << " queries; " << total.redundant() / frames
+        << " redundant" << std::endl;
+}
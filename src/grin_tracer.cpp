@@ -0,0 +1,109 @@
+#include "grin_tracer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// State is (position, T) with T = n * dr/ds, so |T| == n along the ray and
+// the derivative with respect to arc length is (T / n, grad n)
+glm::vec4 rayDerivative(const IndexField& field, const glm::vec4& state, float& index) {
+    glm::vec2 gradient;
+    index = field.sample(glm::vec2(state.x, state.y), gradient);
+    return glm::vec4(state.z / index, state.w / index, gradient.x, gradient.y);
+}
+
+bool inside(const Aabb2D& box, const glm::vec2& p) {
+    return p.x >= box.min.x && p.x <= box.max.x && p.y >= box.min.y && p.y <= box.max.y;
+}
+
+// Where the segment from a (inside) to b leaves the box
+glm::vec2 clipToBox(const Aabb2D& box, const glm::vec2& a, const glm::vec2& b) {
+    glm::vec2 d = b - a;
+    float t = 1.0f;
+    for (int axis = 0; axis < 2; axis++) {
+        if (d[axis] > 0.0f) t = std::min(t, (box.max[axis] - a[axis]) / d[axis]);
+        if (d[axis] < 0.0f) t = std::min(t, (box.min[axis] - a[axis]) / d[axis]);
+    }
+    return a + d * std::max(t, 0.0f);
+}
+}
+
+void traceGrinRay(const IndexField& field, const glm::vec2& origin, const glm::vec2& direction,
+                  const GrinSettings& settings, GrinPath& path) {
+    // Dormand-Prince tableau (the system is autonomous, so no c_i nodes)
+    static const float a21 = 1.0f / 5;
+    static const float a31 = 3.0f / 40, a32 = 9.0f / 40;
+    static const float a41 = 44.0f / 45, a42 = -56.0f / 15, a43 = 32.0f / 9;
+    static const float a51 = 19372.0f / 6561, a52 = -25360.0f / 2187, a53 = 64448.0f / 6561,
+                       a54 = -212.0f / 729;
+    static const float a61 = 9017.0f / 3168, a62 = -355.0f / 33, a63 = 46732.0f / 5247,
+                       a64 = 49.0f / 176, a65 = -5103.0f / 18656;
+    static const float b1 = 35.0f / 384, b3 = 500.0f / 1113, b4 = 125.0f / 192,
+                       b5 = -2187.0f / 6784, b6 = 11.0f / 84;
+    // Fifth minus embedded fourth order weights
+    static const float e1 = 71.0f / 57600, e3 = -71.0f / 16695, e4 = 71.0f / 1920,
+                       e5 = -17253.0f / 339200, e6 = 22.0f / 525, e7 = -1.0f / 40;
+
+    path.points.clear();
+    path.acceptedSteps = 0;
+    path.rejectedSteps = 0;
+    path.points.push_back(origin);
+    if (!inside(settings.bounds, origin)) return;
+
+    float index;
+    glm::vec2 unit = glm::normalize(direction);
+    glm::vec4 state(origin.x, origin.y, 0.0f, 0.0f);
+    rayDerivative(field, state, index);
+    state.z = unit.x * index;
+    state.w = unit.y * index;
+    glm::vec4 k1 = rayDerivative(field, state, index);
+
+    float h = settings.initialStep;
+    float travelled = 0.0f;
+    int steps = 0;
+    while (travelled < settings.maxLength && steps++ < settings.maxSteps) {
+        h = std::min(h, settings.maxLength - travelled);
+        float unused;
+        glm::vec4 k2 = rayDerivative(field, state + h * (a21 * k1), unused);
+        glm::vec4 k3 = rayDerivative(field, state + h * (a31 * k1 + a32 * k2), unused);
+        glm::vec4 k4 = rayDerivative(field, state + h * (a41 * k1 + a42 * k2 + a43 * k3), unused);
+        glm::vec4 k5 = rayDerivative(field, state + h * (a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4),
+                                     unused);
+        glm::vec4 k6 = rayDerivative(field, state + h * (a61 * k1 + a62 * k2 + a63 * k3 +
+                                                         a64 * k4 + a65 * k5), unused);
+        glm::vec4 next = state + h * (b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6);
+        float nextIndex;
+        glm::vec4 k7 = rayDerivative(field, next, nextIndex);
+
+        // Position error, plus the direction error it will turn into
+        glm::vec4 error = h * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7);
+        float errorNorm = std::max(glm::length(glm::vec2(error.x, error.y)),
+                                   glm::length(glm::vec2(error.z, error.w)) / nextIndex);
+
+        if (errorNorm > settings.tolerance && h > settings.minStep) {
+            path.rejectedSteps++;
+            h = std::max(settings.minStep, h * std::max(0.2f,
+                         0.9f * powf(settings.tolerance / errorNorm, 0.2f)));
+            continue;
+        }
+
+        glm::vec2 from(state.x, state.y);
+        glm::vec2 to(next.x, next.y);
+        path.acceptedSteps++;
+        travelled += h;
+        if (!inside(settings.bounds, to)) {
+            path.points.push_back(clipToBox(settings.bounds, from, to));
+            return;
+        }
+        path.points.push_back(to);
+
+        // Keep |T| == n so rounding does not slowly change the ray's speed.
+        // k7 only needs its T / n half refreshed, the gradient is unchanged.
+        glm::vec2 momentum(next.z, next.w);
+        momentum *= nextIndex / glm::length(momentum);
+        state = glm::vec4(to.x, to.y, momentum.x, momentum.y);
+        k1 = glm::vec4(momentum / nextIndex, k7.z, k7.w);
+
+        float grow = errorNorm > 0.0f ? 0.9f * powf(settings.tolerance / errorNorm, 0.2f) : 5.0f;
+        h = glm::clamp(h * std::min(grow, 5.0f), settings.minStep, settings.maxStep);
+    }
+}
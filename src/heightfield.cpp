@@ -0,0 +1,213 @@
+#include "heightfield.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+// The launch point sits on the ground, so contacts this close to t = 0 are ignored
+constexpr float MIN_HIT_TIME = 1e-4f;
+
+void Heightfield::setSamples(std::vector<float> samples, float left, float right) {
+    if (samples.size() < 2) throw std::runtime_error("Heightfield needs at least two samples");
+    heights = std::move(samples);
+    this->left = left;
+    this->right = right;
+    spacing = (right - left) / (heights.size() - 1);
+    buildPyramid();
+}
+
+void Heightfield::loadPgm(const std::string& path, float left, float right, float minHeight, float maxHeight) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Failed to open heightmap: " + path);
+
+    // Header: magic, width, height, maxval, with # comments allowed between
+    auto readValue = [&]() {
+        file >> std::ws;
+        while (file.peek() == '#') {
+            file.ignore(1 << 16, '\n');
+            file >> std::ws;
+        }
+        int value = -1;
+        file >> value;
+        return value;
+    };
+    std::string magic;
+    file >> magic;
+    if (magic != "P2" && magic != "P5") throw std::runtime_error("Not a greyscale PGM: " + path);
+    int width = readValue(), height = readValue(), maxValue = readValue();
+    if (!file || width < 2 || height < 1 || maxValue < 1 || maxValue > 65535) {
+        throw std::runtime_error("Bad PGM header: " + path);
+    }
+
+    std::vector<float> samples(width);
+    int row = height / 2;
+    if (magic == "P2") {
+        for (int y = 0; y <= row; y++) {
+            for (int x = 0; x < width; x++) {
+                int value = readValue();
+                if (value < 0) throw std::runtime_error("PGM data ends early: " + path);
+                if (y == row) samples[x] = static_cast<float>(value);
+            }
+        }
+    } else {
+        // Exactly one whitespace byte separates the header from the pixels
+        file.get();
+        int bytesPerValue = maxValue > 255 ? 2 : 1;
+        std::vector<unsigned char> pixels(static_cast<size_t>(width) * bytesPerValue);
+        file.seekg(static_cast<std::streamoff>(row) * pixels.size(), std::ios::cur);
+        if (!file.read(reinterpret_cast<char*>(pixels.data()), pixels.size())) {
+            throw std::runtime_error("PGM data ends early: " + path);
+        }
+        for (int x = 0; x < width; x++) {
+            samples[x] = bytesPerValue == 2 ? static_cast<float>(pixels[2 * x] << 8 | pixels[2 * x + 1])
+                                            : static_cast<float>(pixels[x]);
+        }
+    }
+
+    for (float& sample : samples) {
+        sample = minHeight + (maxHeight - minHeight) * sample / maxValue;
+    }
+    setSamples(std::move(samples), left, right);
+}
+
+void Heightfield::buildPyramid() {
+    levels.clear();
+    std::vector<glm::vec2> cells(heights.size() - 1);
+    for (size_t i = 0; i < cells.size(); i++) {
+        cells[i] = glm::vec2(std::min(heights[i], heights[i + 1]), std::max(heights[i], heights[i + 1]));
+    }
+    levels.push_back(std::move(cells));
+
+    while (levels.back().size() > 1) {
+        const std::vector<glm::vec2>& below = levels.back();
+        std::vector<glm::vec2> above((below.size() + 1) / 2);
+        for (size_t i = 0; i < above.size(); i++) {
+            above[i] = below[2 * i];
+            if (2 * i + 1 < below.size()) {
+                above[i].x = std::min(above[i].x, below[2 * i + 1].x);
+                above[i].y = std::max(above[i].y, below[2 * i + 1].y);
+            }
+        }
+        levels.push_back(std::move(above));
+    }
+}
+
+float Heightfield::heightAt(float x) const {
+    float u = glm::clamp((x - left) / spacing, 0.0f, static_cast<float>(heights.size() - 1));
+    size_t cell = std::min(static_cast<size_t>(u), heights.size() - 2);
+    float f = u - cell;
+    return heights[cell] + (heights[cell + 1] - heights[cell]) * f;
+}
+
+bool Heightfield::intersectCell(size_t cell, const glm::vec2& start, const glm::vec2& velocity, float gravity,
+                                float t0, float t1, float& hitTime) const {
+    // Height of arc above ground over the window, as a function of tau = t - t0:
+    // f(tau) = f0 + d * tau - g/2 * tau^2, since the ground is linear in x
+    float slope = (heights[cell + 1] - heights[cell]) / spacing;
+    float x = start.x + velocity.x * t0;
+    float ground = heights[cell] + slope * (x - (left + cell * spacing));
+    float f0 = start.y + velocity.y * t0 - 0.5f * gravity * t0 * t0 - ground;
+    if (f0 <= 0.0f) {
+        hitTime = t0;
+        return true;
+    }
+    float d = velocity.y - gravity * t0 - slope * velocity.x;
+    // Later root of f; on steep ground d is huge and negative, where the
+    // plain formula cancels to noise, so use the conjugate form there
+    float root = sqrtf(d * d + 2.0f * gravity * f0);
+    float tau = d > 0.0f ? (d + root) / gravity : 2.0f * f0 / (root - d);
+    if (tau > t1 - t0) return false;
+    hitTime = t0 + tau;
+    return true;
+}
+
+bool Heightfield::intersectVertical(const glm::vec2& start, float speed, float gravity, float& hitTime) const {
+    if (start.x < left || start.x > right) return false;
+    float f0 = start.y - heightAt(start.x);
+    float discriminant = speed * speed + 2.0f * gravity * f0;
+    hitTime = discriminant > 0.0f ? std::max((speed + sqrtf(discriminant)) / gravity, MIN_HIT_TIME)
+                                  : MIN_HIT_TIME;
+    return true;
+}
+
+bool Heightfield::intersectTrajectory(const glm::vec2& start, const glm::vec2& velocity, float gravity,
+                                      float& hitTime, int* nodesVisited) const {
+    if (velocity.x == 0.0f) return intersectVertical(start, velocity.y, gravity, hitTime);
+
+    // Depth-first from the root, nearer child on top of the stack, so the
+    // first leaf that reports a hit is the earliest one along the flight
+    struct Entry {
+        int level;
+        size_t index;
+    };
+    Entry stack[64];
+    int top = 0;
+    int visited = 0;
+    bool found = false;
+    size_t cellCount = levels[0].size();
+    float inverseVelocity = 1.0f / velocity.x;
+    stack[top++] = { static_cast<int>(levels.size()) - 1, 0 };
+
+    while (top > 0) {
+        Entry entry = stack[--top];
+        visited++;
+
+        // The node's x span becomes a window of flight time
+        size_t first = entry.index << entry.level;
+        size_t last = std::min((entry.index + 1) << entry.level, cellCount);
+        float t0 = (left + first * spacing - start.x) * inverseVelocity;
+        float t1 = (left + last * spacing - start.x) * inverseVelocity;
+        if (t0 > t1) std::swap(t0, t1);
+        t0 = std::max(t0, MIN_HIT_TIME);
+        if (t0 > t1) continue;
+
+        // The arc is concave, so its lowest point over the window is at an
+        // end. If that is above the highest ground here, skip the whole node.
+        float y0 = start.y + velocity.y * t0 - 0.5f * gravity * t0 * t0;
+        float y1 = start.y + velocity.y * t1 - 0.5f * gravity * t1 * t1;
+        if (std::min(y0, y1) > levels[entry.level][entry.index].y) continue;
+
+        if (entry.level == 0) {
+            if (intersectCell(first, start, velocity, gravity, t0, t1, hitTime)) {
+                found = true;
+                break;
+            }
+            continue;
+        }
+
+        size_t nearChild = 2 * entry.index, farChild = 2 * entry.index + 1;
+        if (velocity.x < 0.0f) std::swap(nearChild, farChild);
+        size_t childCount = levels[entry.level - 1].size();
+        if (farChild < childCount) stack[top++] = { entry.level - 1, farChild };
+        if (nearChild < childCount) stack[top++] = { entry.level - 1, nearChild };
+    }
+
+    if (nodesVisited) *nodesVisited = visited;
+    return found;
+}
+
+bool Heightfield::intersectTrajectoryLinear(const glm::vec2& start, const glm::vec2& velocity, float gravity,
+                                            float& hitTime) const {
+    if (velocity.x == 0.0f) return intersectVertical(start, velocity.y, gravity, hitTime);
+
+    long long cellCount = static_cast<long long>(levels[0].size());
+    long long cell = static_cast<long long>(floorf((start.x - left) / spacing));
+    int step = velocity.x > 0.0f ? 1 : -1;
+    if (cell < 0) {
+        if (step < 0) return false;
+        cell = 0;
+    } else if (cell >= cellCount) {
+        if (step > 0) return false;
+        cell = cellCount - 1;
+    }
+
+    for (; cell >= 0 && cell < cellCount; cell += step) {
+        float t0 = (left + cell * spacing - start.x) / velocity.x;
+        float t1 = (left + (cell + 1) * spacing - start.x) / velocity.x;
+        if (t0 > t1) std::swap(t0, t1);
+        t0 = std::max(t0, MIN_HIT_TIME);
+        if (t0 > t1) continue;
+        if (intersectCell(static_cast<size_t>(cell), start, velocity, gravity, t0, t1, hitTime)) return true;
+    }
+    return false;
+}
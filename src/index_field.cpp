@@ -0,0 +1,64 @@
+#include "index_field.h"
+#include <algorithm>
+#include <cmath>
+
+MirageField::MirageField(float groundIndex, float airIndex, float scaleHeight)
+    : groundIndex(groundIndex), airIndex(airIndex), scaleHeight(scaleHeight) {}
+
+float MirageField::sample(const glm::vec2& p, glm::vec2& gradient) const {
+    float y = std::max(p.y, 0.0f);
+    float falloff = (airIndex - groundIndex) * expf(-y / scaleHeight);
+    gradient = glm::vec2(0.0f, p.y > 0.0f ? falloff / scaleHeight : 0.0f);
+    return airIndex - falloff;
+}
+
+GradedFiberField::GradedFiberField(float axisY, float coreRadius, float coreIndex, float delta)
+    : axisY(axisY), coreRadius(coreRadius), coreIndex(coreIndex), delta(delta) {}
+
+float GradedFiberField::getCladdingIndex() const {
+    return coreIndex * sqrtf(1.0f - 2.0f * delta);
+}
+
+float GradedFiberField::sample(const glm::vec2& p, glm::vec2& gradient) const {
+    float offset = p.y - axisY;
+    if (fabsf(offset) >= coreRadius) {
+        gradient = glm::vec2(0.0f);
+        return getCladdingIndex();
+    }
+    float a2 = coreRadius * coreRadius;
+    float root = sqrtf(1.0f - 2.0f * delta * offset * offset / a2);
+    gradient = glm::vec2(0.0f, -2.0f * coreIndex * delta * offset / (a2 * root));
+    return coreIndex * root;
+}
+
+GridIndexField::GridIndexField(const Aabb2D& bounds, int width, int height, float outsideIndex)
+    : bounds(bounds), width(width), height(height), outsideIndex(outsideIndex),
+      values(static_cast<size_t>(width) * height, outsideIndex) {
+    cellSize = (bounds.max - bounds.min) / glm::vec2(width - 1, height - 1);
+}
+
+glm::vec2 GridIndexField::nodePosition(int x, int y) const {
+    return bounds.min + cellSize * glm::vec2(x, y);
+}
+
+float GridIndexField::sample(const glm::vec2& p, glm::vec2& gradient) const {
+    glm::vec2 cell = (p - bounds.min) / cellSize;
+    if (cell.x < 0.0f || cell.y < 0.0f || cell.x >= width - 1 || cell.y >= height - 1) {
+        gradient = glm::vec2(0.0f);
+        return outsideIndex;
+    }
+    int x = static_cast<int>(cell.x);
+    int y = static_cast<int>(cell.y);
+    float fx = cell.x - x;
+    float fy = cell.y - y;
+
+    const float* row0 = &values[y * width + x];
+    const float* row1 = row0 + width;
+    float bottom = row0[0] + (row0[1] - row0[0]) * fx;
+    float top = row1[0] + (row1[1] - row1[0]) * fx;
+
+    // Exact derivative of the bilinear patch
+    gradient.x = ((row0[1] - row0[0]) * (1.0f - fy) + (row1[1] - row1[0]) * fy) / cellSize.x;
+    gradient.y = (top - bottom) / cellSize.y;
+    return bottom + (top - bottom) * fy;
+}
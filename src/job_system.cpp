@@ -0,0 +1,214 @@
+#include "job_system.h"
+#include "alloc_tracker.h"
+#include <algorithm>
+
+JobSystem* JobSystem::instance = nullptr;
+
+// Which deque this thread owns: -1 for threads outside the pool
+static thread_local int workerIndex = -1;
+static thread_local unsigned stealSeed = 0x9e3779b9u;
+
+JobSystem::JobSystem(int threadCount) {
+    start(threadCount);
+}
+
+JobSystem::~JobSystem() {
+    stop();
+    if (instance == this) instance = nullptr;
+}
+
+void JobSystem::setThreadCount(int count) {
+    stop();
+    start(count);
+}
+
+void JobSystem::start(int count) {
+    if (count <= 0) count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threadCount = count;
+    deques.reset(new Deque[threadCount + 1]);
+    queued = 0;
+    stopping = false;
+
+    workerIndex = 0;
+    workers.reserve(threadCount - 1);
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::stop() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+}
+
+int JobSystem::currentDeque() const {
+    return workerIndex >= 0 && workerIndex < threadCount ? workerIndex : threadCount;
+}
+
+void JobSystem::workerLoop(int index) {
+    workerIndex = index;
+    stealSeed = 0x9e3779b9u * (index + 1);
+    int spins = 0;
+    while (!stopping) {
+        Task task;
+        if (findTask(index, task)) {
+            execute(task, index);
+            spins = 0;
+            continue;
+        }
+        if (++spins < SPINS_BEFORE_SLEEP) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Nothing anywhere: sleep until a push or shutdown
+        std::unique_lock<std::mutex> guard(sleepLock);
+        sleepers++;
+        wake.wait(guard, [&]() { return queued.load() > 0 || stopping.load(); });
+        sleepers--;
+        spins = 0;
+    }
+}
+
+bool JobSystem::push(int index, const Task& task) {
+    Deque& deque = deques[index];
+    {
+        std::lock_guard<std::mutex> guard(deque.lock);
+        if (deque.bottom - deque.top == DEQUE_CAPACITY) return false;
+        deque.tasks[deque.bottom++ % DEQUE_CAPACITY] = task;
+    }
+    queued++;
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        wake.notify_one();
+    }
+    return true;
+}
+
+bool JobSystem::findTask(int index, Task& task) {
+    // Own deque first, newest task
+    {
+        Deque& own = deques[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (own.bottom != own.top) {
+            task = own.tasks[--own.bottom % DEQUE_CAPACITY];
+            queued--;
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of another deque, starting at a random one
+    if (queued.load() == 0) return false;
+    int dequeCount = threadCount + 1;
+    stealSeed ^= stealSeed << 13;
+    stealSeed ^= stealSeed >> 17;
+    stealSeed ^= stealSeed << 5;
+    int first = static_cast<int>(stealSeed % dequeCount);
+    for (int i = 0; i < dequeCount; i++) {
+        int victim = (first + i) % dequeCount;
+        if (victim == index) continue;
+        Deque& deque = deques[victim];
+        std::lock_guard<std::mutex> guard(deque.lock);
+        if (deque.bottom != deque.top) {
+            task = deque.tasks[deque.top++ % DEQUE_CAPACITY];
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(Task task, int index) {
+    // Split off upper halves while the range is longer than the grain, so
+    // idle workers have something to steal; keep the lower half here
+    while (task.end - task.begin > task.grain) {
+        Task upper = task;
+        upper.begin = task.begin + (task.end - task.begin) / 2;
+        task.group->pending++;
+        if (!push(index, upper)) {
+            task.group->pending--;  // deque full: run the rest of the range here
+            break;
+        }
+        task.end = upper.begin;
+    }
+    {
+        AllocTracker::HotState hot(task.hot);
+        task.function(task.data, task.begin, task.end);
+    }
+    finish(*task.group, index);
+}
+
+void JobSystem::finish(TaskGroup& group, int index) {
+    // Whoever takes the count to zero owns the group from here on
+    if (group.pending.fetch_sub(1) != 1) return;
+
+    if (group.continuation.function) {
+        Task next = group.continuation;
+        group.continuation.function = nullptr;
+        group.pending = 1;
+        if (!push(index, next)) execute(next, index);
+        return;
+    }
+    // Last access: a waiter may return and reuse the group right after
+    group.finished = true;
+}
+
+void JobSystem::run(TaskGroup& group, void (*function)(void*, size_t, size_t), void* data,
+                    size_t begin, size_t end, size_t grain) {
+    if (begin >= end) return;
+    Task task;
+    task.function = function;
+    task.data = data;
+    task.begin = begin;
+    task.end = end;
+    task.grain = std::max<size_t>(grain, 1);
+    task.group = &group;
+    task.hot = AllocTracker::inHotRegion();
+
+    int index = currentDeque();
+    group.pending++;
+    if (!push(index, task)) execute(task, index);
+}
+
+void JobSystem::then(TaskGroup& group, void (*function)(void*, size_t, size_t), void* data) {
+    group.continuation.function = function;
+    group.continuation.data = data;
+    group.continuation.begin = 0;
+    group.continuation.end = 1;
+    group.continuation.grain = 1;
+    group.continuation.group = &group;
+    group.continuation.hot = AllocTracker::inHotRegion();
+
+    // Drop the hold; if every task already finished, this schedules the continuation
+    group.released = true;
+    finish(group, currentDeque());
+}
+
+void JobSystem::wait(TaskGroup& group) {
+    int index = currentDeque();
+    if (!group.released) {
+        group.released = true;
+        finish(group, index);
+    }
+
+    int idle = 0;
+    while (!group.finished) {
+        Task task;
+        if (findTask(index, task)) {
+            execute(task, index);
+            idle = 0;
+        } else if (++idle > SPINS_BEFORE_SLEEP) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Ready for another round
+    group.finished = false;
+    group.released = false;
+    group.pending = 1;
+}
@@ -3,14 +3,34 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "projectile_simulation.h"
 #include "refraction_simulation.h"
+#include "job_system.h"
+#include "frame_arena.h"
+#include "alloc_tracker.h"
+#include "gl_counters.h"
+#include "render_backend.h"
+#include "render_queue.h"
+#include "batch_runner.h"
+#include "range_table.h"
 #include "imgui/include/imgui.h"
 #include "imgui/include/imgui_impl_glfw.h"
 #include "imgui/include/imgui_impl_opengl3.h"
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
 
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
+// When the simulation is idle the loop sleeps in glfwWaitEventsTimeout
+// instead of spinning, waking at least this often (seconds)
+const double IDLE_WAKE_INTERVAL = 0.5;
+// Frames ImGui gets to settle hover/active state after input before sleeping
+const int IDLE_SETTLE_FRAMES = 3;
+// --zero-alloc lets this many frames warm up before hot regions must not allocate
+const int ZERO_ALLOC_WARMUP_FRAMES = 300;
+
 enum class SimulationType {
     None,
     Projectile,
@@ -29,7 +49,73 @@ void cleanup(GLFWwindow* window) {
     glfwTerminate();
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Command line: --max-fps <n> caps the frame rate (0 = uncapped),
+    // --no-vsync disables the swap interval, --threads <n> sizes the
+    // worker pool (0 = one per hardware thread). --batch <scenarios> runs
+    // a scenario file headless instead, writing CSV to --out (default stdout).
+    // --range-table <file> sweeps angle x speed headless instead: --grid
+    // <angles>x<speeds>, --drag <k>, --wind <m/s>, plus optional --csv <file>
+    // and --heatmap <file.ppm>. --zero-alloc aborts on any allocation in a
+    // hot region (see AllocTracker) after the warm-up frames.
+    int maxFps = 0;
+    bool vsync = true;
+    int threadCount = 0;
+    std::string batchPath;
+    std::string batchOutput = "-";
+    RangeTableJob rangeTable;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--max-fps" && i + 1 < argc) {
+            maxFps = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--no-vsync") {
+            vsync = false;
+        } else if (arg == "--zero-alloc") {
+            AllocTracker::setStrict(true, ZERO_ALLOC_WARMUP_FRAMES);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchPath = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            batchOutput = argv[++i];
+        } else if (arg == "--range-table" && i + 1 < argc) {
+            rangeTable.path = argv[++i];
+        } else if (arg == "--grid" && i + 1 < argc) {
+            std::string grid = argv[++i];
+            rangeTable.angleCount = atoi(grid.c_str());
+            size_t separator = grid.find('x');
+            rangeTable.speedCount = separator == std::string::npos ? rangeTable.angleCount
+                                                                   : atoi(grid.c_str() + separator + 1);
+        } else if (arg == "--drag" && i + 1 < argc) {
+            rangeTable.model.drag = static_cast<float>(atof(argv[++i]));
+        } else if (arg == "--wind" && i + 1 < argc) {
+            rangeTable.model.wind = static_cast<float>(atof(argv[++i]));
+        } else if (arg == "--csv" && i + 1 < argc) {
+            rangeTable.csvPath = argv[++i];
+        } else if (arg == "--heatmap" && i + 1 < argc) {
+            rangeTable.heatmapPath = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+        }
+    }
+
+    // One worker pool for every simulation, created here so the workers
+    // start once rather than per simulation or per parallel loop
+    JobSystem jobs(threadCount);
+    JobSystem::setInstance(&jobs);
+    int workerThreads = jobs.getThreadCount();
+
+    if (!batchPath.empty()) {
+        int status = runBatch(batchPath, batchOutput);
+        JobSystem::setInstance(nullptr);
+        return status;
+    }
+    if (!rangeTable.path.empty()) {
+        int status = runRangeTable(rangeTable);
+        JobSystem::setInstance(nullptr);
+        return status;
+    }
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -50,6 +136,7 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(vsync ? 1 : 0);
 
     // Initialize GLAD before any OpenGL calls
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
@@ -57,12 +144,20 @@ int main() {
         glfwTerminate();
         return -1;
     }
+    GlCounters::install();
+    RenderBackend::init((GLADloadproc)glfwGetProcAddress);
 
     // Set callbacks after window creation and GLAD initialization
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    // Initialize ImGui
+    // Initialize ImGui, counting its memory as its own
     IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(
+        [](size_t bytes, void*) {
+            AllocTracker::Scope scope(AllocTracker::Gui);
+            return AllocTracker::allocate(bytes);
+        },
+        [](void* pointer, void*) { AllocTracker::release(pointer); });
     if (ImGui::CreateContext() == nullptr) {
         std::cerr << "Failed to create ImGui context" << std::endl;
         glfwTerminate();
@@ -90,6 +185,14 @@ int main() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_PROGRAM_POINT_SIZE);
 
+    // Scratch memory for data that dies with the frame (see FrameArena)
+    FrameArena frameArena;
+    FrameArena::setInstance(&frameArena);
+
+    // Simulations record their draws here; the queue sorts and submits them
+    CommandList frameCommands;
+    RenderQueue renderQueue;
+
     // Simulation variables
     std::unique_ptr<SimulationBase> currentSimulation;
     SimulationType selectedSimulation = SimulationType::None;
@@ -101,12 +204,19 @@ int main() {
     // Timing variables
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
+    int idleFrames = 0;
 
     // Main loop
     while (!glfwWindowShouldClose(window)) {
-        float currentFrame = static_cast<float>(glfwGetTime());
+        double frameStart = glfwGetTime();
+        float currentFrame = static_cast<float>(frameStart);
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        AllocTracker::endFrame();
+        GlCounters::endFrame();
+        // ImGui drew last frame through its own loader
+        RenderBackend::invalidate();
+        frameArena.reset();
 
         // Start new ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -116,7 +226,7 @@ int main() {
         // Show simulation selector if no simulation is chosen
         if (!simulationChosen) {
             ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH * 0.5f - 200, SCR_HEIGHT * 0.5f - 100), ImGuiCond_Always);
-            ImGui::SetNextWindowSize(ImVec2(400, 200), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(400, 230), ImGuiCond_Always);
             ImGui::Begin("Select Simulation", nullptr, 
                 ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
             
@@ -136,6 +246,14 @@ int main() {
                 simulationChosen = true;
             }
 
+            // Only here, while no simulation holds per-worker state
+            ImGui::Spacing();
+            ImGui::SliderInt("Worker Threads", &workerThreads, 1,
+                             std::max(16, static_cast<int>(std::thread::hardware_concurrency())));
+            if (ImGui::IsItemDeactivatedAfterEdit() && workerThreads != jobs.getThreadCount()) {
+                jobs.setThreadCount(workerThreads);
+            }
+
             ImGui::End();
 
             // Initialize chosen simulation
@@ -155,10 +273,11 @@ int main() {
                             break;
                     }
                     currentSimulation->init();
+                    renderQueue.forgetPrograms();
                     
                     // Set projection for the new simulation
                     GLuint shaderProgram = currentSimulation->getShaderProgram();
-                    glUseProgram(shaderProgram);
+                    RenderBackend::useProgram(shaderProgram);
                     GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
                     glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
                 } catch (const std::exception& e) {
@@ -184,23 +303,121 @@ int main() {
             // Run current simulation
             if (currentSimulation) {
                 currentSimulation->handleInput();
-                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                currentSimulation->render(deltaTime);
+                int width, height;
+                glfwGetFramebufferSize(window, &width, &height);
+                // The simulations and the queue mark their own hot regions
+                AllocTracker::Scope allocScope(AllocTracker::Render);
+                currentSimulation->update(deltaTime);
+                frameCommands.reset(width, height);
+                currentSimulation->render(frameCommands);
+                renderQueue.submit(frameCommands);
             }
+
+            ImGui::SetNextWindowPos(ImVec2(10, SCR_HEIGHT - 90), ImGuiCond_FirstUseEver);
+            ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+            ImGui::Begin("Frame Stats", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+            ImGui::Text("Arena: %.1f KB in %zu allocations this frame", frameArena.getUsed() / 1024.0,
+                        frameArena.getAllocationCount());
+            ImGui::Text("Peak %.1f KB of %.1f KB (grew %d times)", frameArena.getHighWaterMark() / 1024.0,
+                        frameArena.getCapacity() / 1024.0, frameArena.getGrowCount());
+
+            // Heap use by tag, for the frame before this one
+            ImGui::Separator();
+            if (ImGui::BeginTable("Allocations", 4, ImGuiTableFlags_RowBg)) {
+                ImGui::TableSetupColumn("Heap");
+                ImGui::TableSetupColumn("Allocs");
+                ImGui::TableSetupColumn("KB");
+                ImGui::TableSetupColumn("Live KB (peak)");
+                ImGui::TableHeadersRow();
+                for (int tag = 0; tag <= AllocTracker::TagCount; tag++) {
+                    bool isTotal = tag == AllocTracker::TagCount;
+                    AllocTracker::Stats stats = isTotal ? AllocTracker::lastFrameTotal()
+                                                        : AllocTracker::lastFrame(static_cast<AllocTracker::Tag>(tag));
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(isTotal ? "Total" : AllocTracker::tagName(static_cast<AllocTracker::Tag>(tag)));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(stats.allocations));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f", stats.bytes / 1024.0);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.0f (%.0f)", stats.liveBytes / 1024.0, stats.peakLiveBytes / 1024.0);
+                }
+                ImGui::EndTable();
+            }
+            ImGui::Text("Hot region allocations: %llu last frame, %llu in all%s",
+                        static_cast<unsigned long long>(AllocTracker::getLastFrameHotAllocations()),
+                        static_cast<unsigned long long>(AllocTracker::getHotAllocations()),
+                        AllocTracker::isStrict() ? " (strict)" : "");
+
+            // GL calls made through glad in the frame before this one
+            const GlCounters::Stats& gl = GlCounters::lastFrame();
+            ImGui::Separator();
+            ImGui::Text("GL: %llu calls, %llu draws, %llu vertices", static_cast<unsigned long long>(gl.calls),
+                        static_cast<unsigned long long>(gl.draws), static_cast<unsigned long long>(gl.vertices));
+            ImGui::Text("Binds: %llu program (%llu redundant), %llu VAO (%llu), %llu buffer (%llu), %llu texture (%llu)",
+                        static_cast<unsigned long long>(gl.programBinds),
+                        static_cast<unsigned long long>(gl.redundantProgramBinds),
+                        static_cast<unsigned long long>(gl.vertexArrayBinds),
+                        static_cast<unsigned long long>(gl.redundantVertexArrayBinds),
+                        static_cast<unsigned long long>(gl.bufferBinds),
+                        static_cast<unsigned long long>(gl.redundantBufferBinds),
+                        static_cast<unsigned long long>(gl.textureBinds),
+                        static_cast<unsigned long long>(gl.redundantTextureBinds));
+            ImGui::Text("Uploads: %llu (%.1f KB)", static_cast<unsigned long long>(gl.uploads), gl.uploadBytes / 1024.0);
+            ImGui::Text("Uniforms: %llu set, %llu looked up", static_cast<unsigned long long>(gl.uniforms),
+                        static_cast<unsigned long long>(gl.uniformLookups));
+            ImGui::Text("State changes: %llu (%llu redundant), queries: %llu",
+                        static_cast<unsigned long long>(gl.stateChanges),
+                        static_cast<unsigned long long>(gl.redundantStateChanges),
+                        static_cast<unsigned long long>(gl.queries));
+            ImGui::Text("Direct state access: %s", RenderBackend::hasDirectStateAccess() ? "yes" : "no (3.3 binds)");
+            const RenderQueue::Stats& queue = renderQueue.lastSubmit();
+            ImGui::Text("Commands: %zu recorded, %zu draw calls (%zu merged)", queue.commands, queue.calls,
+                        queue.merged);
+            ImGui::End();
         }
 
         // Render ImGui
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-        // Swap buffers and poll events
         glfwSwapBuffers(window);
-        glfwPollEvents();
+
+        // Poll while anything is moving; once the simulation (or the
+        // selector screen) has been idle for a few frames, sleep until input
+        bool idle = !currentSimulation || currentSimulation->isIdle();
+        idleFrames = idle ? idleFrames + 1 : 0;
+        if (idleFrames > IDLE_SETTLE_FRAMES) {
+            double waitStart = glfwGetTime();
+            glfwWaitEventsTimeout(IDLE_WAKE_INTERVAL);
+            // Woken early means an input event rather than the timeout
+            if (glfwGetTime() - waitStart < IDLE_WAKE_INTERVAL * 0.9) {
+                idleFrames = 0;
+            }
+        } else {
+            glfwPollEvents();
+        }
+
+        // Frame cap on top of vsync, for uncapped drivers and fast monitors
+        if (maxFps > 0) {
+            double frameEnd = frameStart + 1.0 / maxFps;
+            double remaining = frameEnd - glfwGetTime();
+            if (remaining > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(remaining));
+            }
+        }
+    }
+
+    GlCounters::printSummary(std::cout);
+    if (AllocTracker::isStrict()) {
+        std::cout << "No hot region allocations in " << AllocTracker::getFrameCount() << " frames" << std::endl;
     }
 
     // Cleanup
     currentSimulation.reset();
+    FrameArena::setInstance(nullptr);
+    JobSystem::setInstance(nullptr);
     cleanup(window);
     return 0;
 }
\ No newline at end of file
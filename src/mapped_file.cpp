@@ -0,0 +1,41 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void MappedFile::open(const std::string& path) {
+    close();
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("Failed to read file size: " + path);
+    }
+
+    // Empty files cannot be mapped, but are still valid (and empty)
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(descriptor);
+            length = 0;
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+        bytes = static_cast<const uint8_t*>(mapping);
+    }
+    // The mapping keeps the file alive on its own
+    ::close(descriptor);
+    opened = true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+}
@@ -0,0 +1,102 @@
+#include "obstacle_set.h"
+#include <cmath>
+#include <initializer_list>
+
+void ObstacleSet::clear() {
+    edgePoints.clear();
+    bvh.clear();
+}
+
+void ObstacleSet::addPolygon(const std::vector<glm::vec2>& points) {
+    for (size_t i = 0; i < points.size(); i++) {
+        edgePoints.push_back(points[i]);
+        edgePoints.push_back(points[(i + 1) % points.size()]);
+    }
+}
+
+void ObstacleSet::build() {
+    std::vector<Aabb2D> bounds(edgePoints.size() / 2);
+    for (size_t i = 0; i < bounds.size(); i++) {
+        bounds[i].grow(edgePoints[2 * i]);
+        bounds[i].grow(edgePoints[2 * i + 1]);
+    }
+    bvh.build(bounds);
+}
+
+bool ObstacleSet::sweep(const glm::vec2& start, const glm::vec2& end, float radius, SweepHit& hit) const {
+    Aabb2D box;
+    box.grow(start);
+    box.grow(end);
+    box.min -= glm::vec2(radius);
+    box.max += glm::vec2(radius);
+
+    glm::vec2 d = end - start;
+    hit.time = 2.0f;
+    bvh.query(box, [&](int edge) {
+        glm::vec2 a = edgePoints[2 * edge], b = edgePoints[2 * edge + 1];
+
+        // Edge interior: the centre reaches the line offset by radius, on
+        // the side it starts on, while its foot lies between the ends
+        glm::vec2 along = b - a;
+        float length = glm::length(along);
+        if (length > 1e-6f) {
+            along /= length;
+            glm::vec2 normal(-along.y, along.x);
+            float distance = glm::dot(start - a, normal);
+            float approach = glm::dot(d, normal);
+            if (distance < 0.0f) {
+                normal = -normal;
+                distance = -distance;
+                approach = -approach;
+            }
+            if (approach < 0.0f && distance >= radius) {
+                float t = (distance - radius) / -approach;
+                float foot = glm::dot(start + d * t - a, along);
+                if (t <= 1.0f && t < hit.time && foot >= 0.0f && foot <= length) {
+                    hit.time = t;
+                    hit.normal = normal;
+                }
+            }
+        }
+
+        // Edge ends: the centre reaches a circle of radius around the corner
+        if (radius <= 0.0f) return;
+        for (const glm::vec2& corner : { a, b }) {
+            glm::vec2 m = start - corner;
+            float c = glm::dot(m, m) - radius * radius;
+            float half = glm::dot(m, d);
+            float dd = glm::dot(d, d);
+            if (c < 0.0f || half >= 0.0f) continue;   // overlapping already, or moving away
+            float discriminant = half * half - dd * c;
+            if (discriminant < 0.0f) continue;
+            float t = (-half - sqrtf(discriminant)) / dd;
+            if (t <= 1.0f && t < hit.time) {
+                hit.time = t;
+                hit.normal = glm::normalize(m + d * t);
+            }
+        }
+    });
+    return hit.time <= 1.0f;
+}
+
+bool ObstacleSet::overlap(const glm::vec2& center, float radius, glm::vec2& normal, float& depth) const {
+    // A point needs some size to overlap anything
+    float reach = std::max(radius, 1e-3f);
+    Aabb2D box;
+    box.min = center - glm::vec2(reach);
+    box.max = center + glm::vec2(reach);
+
+    depth = 0.0f;
+    bvh.query(box, [&](int edge) {
+        glm::vec2 a = edgePoints[2 * edge], b = edgePoints[2 * edge + 1];
+        glm::vec2 along = b - a;
+        float u = glm::clamp(glm::dot(center - a, along) / std::max(glm::dot(along, along), 1e-12f), 0.0f, 1.0f);
+        glm::vec2 away = center - (a + along * u);
+        float distance = glm::length(away);
+        if (distance < reach && reach - distance > depth) {
+            depth = reach - distance;
+            normal = distance > 1e-6f ? away / distance : glm::vec2(-along.y, along.x) / glm::length(along);
+        }
+    });
+    return depth > 0.0f;
+}
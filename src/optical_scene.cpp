@@ -0,0 +1,203 @@
+#include "optical_scene.h"
+#include <cmath>
+
+namespace {
+constexpr float TWO_PI = 6.28318530718f;
+
+Aabb2D primitiveBounds(const OpticalPrimitive& prim) {
+    Aabb2D box;
+    if (prim.type == OpticalPrimitive::Segment) {
+        box.grow(prim.p0);
+        box.grow(prim.p1);
+        return box;
+    }
+    // Arc: both endpoints plus every axis extreme that falls inside the span
+    box.grow(prim.center + prim.radius * glm::vec2(cos(prim.angleStart), sin(prim.angleStart)));
+    float angleEnd = prim.angleStart + prim.angleSpan;
+    box.grow(prim.center + prim.radius * glm::vec2(cos(angleEnd), sin(angleEnd)));
+    for (int k = -4; k <= 8; k++) {
+        float extreme = k * TWO_PI * 0.25f;
+        if (extreme > prim.angleStart && extreme < angleEnd) {
+            box.grow(prim.center + prim.radius * glm::vec2(cos(extreme), sin(extreme)));
+        }
+    }
+    return box;
+}
+
+bool angleInArc(float angle, float angleStart, float angleSpan) {
+    float offset = fmodf(angle - angleStart, TWO_PI);
+    if (offset < 0.0f) offset += TWO_PI;
+    return offset <= angleSpan;
+}
+}
+
+void OpticalScene::clear() {
+    materials.clear();
+    primitives.clear();
+    bvh.clear();
+}
+
+int OpticalScene::addMaterial(const std::string& name, float index) {
+    return addMaterial(name, DispersionModel::constant(index));
+}
+
+int OpticalScene::addMaterial(const std::string& name, const DispersionModel& dispersion) {
+    OpticalMaterial material;
+    material.name = name;
+    material.index = dispersion.indexAt(WAVELENGTH_REFERENCE);
+    material.dispersion = dispersion;
+    materials.push_back(material);
+    return static_cast<int>(materials.size()) - 1;
+}
+
+void OpticalScene::addSegment(const glm::vec2& p0, const glm::vec2& p1,
+                              int frontMaterial, int backMaterial) {
+    OpticalPrimitive prim = {};
+    prim.type = OpticalPrimitive::Segment;
+    prim.p0 = p0;
+    prim.p1 = p1;
+    prim.frontMaterial = frontMaterial;
+    prim.backMaterial = backMaterial;
+    primitives.push_back(prim);
+}
+
+void OpticalScene::addArc(const glm::vec2& center, float radius, float angleStart, float angleSpan,
+                          int frontMaterial, int backMaterial) {
+    OpticalPrimitive prim = {};
+    prim.type = OpticalPrimitive::Arc;
+    prim.center = center;
+    prim.radius = radius;
+    prim.angleStart = angleStart;
+    prim.angleSpan = angleSpan;
+    prim.frontMaterial = frontMaterial;
+    prim.backMaterial = backMaterial;
+    primitives.push_back(prim);
+}
+
+void OpticalScene::addPolygon(const std::vector<glm::vec2>& points, int insideMaterial,
+                              int outsideMaterial) {
+    for (size_t i = 0; i < points.size(); i++) {
+        addSegment(points[i], points[(i + 1) % points.size()], outsideMaterial, insideMaterial);
+    }
+}
+
+void OpticalScene::addBiconvexLens(const glm::vec2& center, float height, float thickness,
+                                   int glassMaterial, int outsideMaterial) {
+    // Two equal arcs meeting at the top and bottom of the lens
+    float halfHeight = height * 0.5f;
+    float sag = thickness * 0.5f;
+    float radius = (halfHeight * halfHeight + sag * sag) / (2.0f * sag);
+    float halfAngle = asin(halfHeight / radius);
+
+    // Right face belongs to a circle centred left of the lens and vice versa
+    addArc(center - glm::vec2(radius - sag, 0.0f), radius, -halfAngle, 2.0f * halfAngle,
+           outsideMaterial, glassMaterial);
+    addArc(center + glm::vec2(radius - sag, 0.0f), radius, TWO_PI * 0.5f - halfAngle,
+           2.0f * halfAngle, outsideMaterial, glassMaterial);
+}
+
+void OpticalScene::addPrism(const glm::vec2& center, float side, float rotation,
+                            int glassMaterial, int outsideMaterial) {
+    std::vector<glm::vec2> points;
+    float circumradius = side / sqrt(3.0f);
+    for (int i = 0; i < 3; i++) {
+        float angle = rotation + TWO_PI * 0.25f + i * TWO_PI / 3.0f;
+        points.push_back(center + circumradius * glm::vec2(cos(angle), sin(angle)));
+    }
+    addPolygon(points, glassMaterial, outsideMaterial);
+}
+
+void OpticalScene::addSlab(const glm::vec2& center, glm::vec2 size, int glassMaterial,
+                           int outsideMaterial) {
+    glm::vec2 half = size * 0.5f;
+    std::vector<glm::vec2> points = {
+        center + glm::vec2(-half.x, -half.y),
+        center + glm::vec2(half.x, -half.y),
+        center + glm::vec2(half.x, half.y),
+        center + glm::vec2(-half.x, half.y)
+    };
+    addPolygon(points, glassMaterial, outsideMaterial);
+}
+
+void OpticalScene::build() {
+    std::vector<Aabb2D> bounds;
+    bounds.reserve(primitives.size());
+    for (const auto& prim : primitives) {
+        bounds.push_back(primitiveBounds(prim));
+    }
+    bvh.build(bounds);
+}
+
+bool OpticalScene::intersectPrimitive(int primitive, const glm::vec2& origin,
+                                      const glm::vec2& direction, float tMax,
+                                      OpticalHit& hit) const {
+    const OpticalPrimitive& prim = primitives[primitive];
+    hit.primitive = primitive;
+    if (prim.type == OpticalPrimitive::Segment) {
+        // Solve origin + t * direction = p0 + s * (p1 - p0)
+        glm::vec2 edge = prim.p1 - prim.p0;
+        float denom = direction.x * edge.y - direction.y * edge.x;
+        if (fabsf(denom) < 1e-12f) return false;
+        glm::vec2 toStart = prim.p0 - origin;
+        float t = (toStart.x * edge.y - toStart.y * edge.x) / denom;
+        float s = (toStart.x * direction.y - toStart.y * direction.x) / denom;
+        if (t <= RAY_EPSILON || t >= tMax || s < 0.0f || s > 1.0f) return false;
+
+        hit.t = t;
+        hit.point = origin + t * direction;
+        hit.normal = glm::normalize(glm::vec2(edge.y, -edge.x));
+        return true;
+    }
+
+    // Arc: ray/circle roots, nearest one that lies within the span
+    glm::vec2 toOrigin = origin - prim.center;
+    float b = glm::dot(toOrigin, direction);
+    float c = glm::dot(toOrigin, toOrigin) - prim.radius * prim.radius;
+    float discriminant = b * b - c;
+    if (discriminant < 0.0f) return false;
+    float root = sqrt(discriminant);
+    float candidates[2] = { -b - root, -b + root };
+    for (float t : candidates) {
+        if (t <= RAY_EPSILON || t >= tMax) continue;
+        glm::vec2 point = origin + t * direction;
+        glm::vec2 radial = point - prim.center;
+        if (!angleInArc(atan2(radial.y, radial.x), prim.angleStart, prim.angleSpan)) continue;
+
+        hit.t = t;
+        hit.point = point;
+        hit.normal = radial / prim.radius;
+        return true;
+    }
+    return false;
+}
+
+bool OpticalScene::intersect(const glm::vec2& origin, const glm::vec2& direction,
+                             float tMax, OpticalHit& hit, size_t* tests) const {
+    bool found = false;
+    bvh.intersect(origin, direction, tMax, [&](int primIndex, float& closest) {
+        if (tests) (*tests)++;
+        OpticalHit candidate;
+        if (intersectPrimitive(primIndex, origin, direction, closest, candidate)) {
+            closest = candidate.t;
+            hit = candidate;
+            found = true;
+        }
+    });
+    return found;
+}
+
+void OpticalScene::tessellate(std::vector<glm::vec2>& lines, int arcSegments) const {
+    for (const auto& prim : primitives) {
+        if (prim.type == OpticalPrimitive::Segment) {
+            lines.push_back(prim.p0);
+            lines.push_back(prim.p1);
+            continue;
+        }
+        for (int i = 0; i < arcSegments; i++) {
+            float a0 = prim.angleStart + prim.angleSpan * i / arcSegments;
+            float a1 = prim.angleStart + prim.angleSpan * (i + 1) / arcSegments;
+            lines.push_back(prim.center + prim.radius * glm::vec2(cos(a0), sin(a0)));
+            lines.push_back(prim.center + prim.radius * glm::vec2(cos(a1), sin(a1)));
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include "particle_pool.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Particles per integrate task; big enough that the task overhead vanishes
+constexpr size_t UPDATE_CHUNK = 16384;
+
+// Ground contact keeps this much of the speed along and off the floor
+constexpr float FLOOR_FRICTION = 0.6f;
+constexpr float FLOOR_BOUNCE = 0.35f;
+
+struct KindParameters {
+    float speedScale;       // of the burst speed
+    float spread;           // radians either side of the normal
+    float minLife, maxLife;
+    float drag;             // per second
+};
+
+const KindParameters KINDS[ParticlePool::KindCount] = {
+    { 0.25f, 1.4f, 1.5f, 3.0f, 2.5f },      // Dust
+    { 0.6f, 1.0f, 1.5f, 2.5f, 0.2f },       // Debris
+    { 1.2f, 1.5f, 0.2f, 0.6f, 0.8f },       // Spark
+};
+
+// A plain loop over the arrays with the floor contact written as selects,
+// so the compiler turns it into SIMD code (CMakeLists relaxes the float
+// traps that would otherwise keep the selects as branches). Parameters,
+// not locals, so that restrict is honoured.
+void integrateParticles(float* __restrict x, float* __restrict y, float* __restrict vx, float* __restrict vy,
+                        float* __restrict age, const float* __restrict drag, const float* __restrict floorY,
+                        size_t count, float dt, float gravity) {
+    float fall = gravity * dt;
+    for (size_t i = 0; i < count; i++) {
+        float damping = 1.0f / (1.0f + drag[i] * dt);
+        float velocityX = vx[i] * damping;
+        float velocityY = (vy[i] - fall) * damping;
+        float positionY = y[i] + velocityY * dt;
+        float slidX = velocityX * FLOOR_FRICTION;
+        float bouncedY = -velocityY * FLOOR_BOUNCE;
+        bool below = positionY < floorY[i];
+        x[i] += velocityX * dt;
+        y[i] = below ? floorY[i] : positionY;
+        vx[i] = below ? slidX : velocityX;
+        vy[i] = below ? bouncedY : velocityY;
+        age[i] += dt;
+    }
+}
+
+}
+
+void ParticlePool::reserve(size_t capacity) {
+    for (std::vector<float>* array : { &x, &y, &vx, &vy, &age, &life, &drag, &groundY }) {
+        array->assign(capacity, 0.0f);
+    }
+    kind.assign(capacity, 0);
+    count = 0;
+    highWaterMark = 0;
+}
+
+bool ParticlePool::spawn(Kind particleKind, const glm::vec2& position, const glm::vec2& velocity, float lifetime,
+                         float floorY) {
+    if (count == capacity()) return false;
+    size_t i = count++;
+    x[i] = position.x;
+    y[i] = position.y;
+    vx[i] = velocity.x;
+    vy[i] = velocity.y;
+    age[i] = 0.0f;
+    life[i] = lifetime;
+    drag[i] = KINDS[particleKind].drag;
+    groundY[i] = floorY;
+    kind[i] = particleKind;
+    highWaterMark = std::max(highWaterMark, count);
+    return true;
+}
+
+void ParticlePool::kill(size_t index) {
+    size_t last = --count;
+    x[index] = x[last];
+    y[index] = y[last];
+    vx[index] = vx[last];
+    vy[index] = vy[last];
+    age[index] = age[last];
+    life[index] = life[last];
+    drag[index] = drag[last];
+    groundY[index] = groundY[last];
+    kind[index] = kind[last];
+}
+
+size_t ParticlePool::burst(Kind particleKind, const glm::vec2& position, const glm::vec2& normal, float speed,
+                           size_t burstCount, float floorY, std::minstd_rand& random) {
+    const KindParameters& parameters = KINDS[particleKind];
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float heading = atan2f(normal.y, normal.x);
+    burstCount = std::min(burstCount, capacity() - count);
+    for (size_t n = 0; n < burstCount; n++) {
+        float angle = heading + parameters.spread * (2.0f * unit(random) - 1.0f);
+        // Most particles slow, a few fast, which reads as a burst rather than a ring
+        float u = unit(random);
+        float particleSpeed = speed * parameters.speedScale * (0.15f + 0.85f * u * u);
+        float lifetime = parameters.minLife + (parameters.maxLife - parameters.minLife) * unit(random);
+        spawn(particleKind, position, particleSpeed * glm::vec2(cosf(angle), sinf(angle)), lifetime, floorY);
+    }
+    return burstCount;
+}
+
+void ParticlePool::update(float dt, float gravity) {
+    size_t chunks = (count + UPDATE_CHUNK - 1) / UPDATE_CHUNK;
+    parallelFor(chunks, 1, [&](size_t chunk) {
+        size_t begin = chunk * UPDATE_CHUNK;
+        size_t end = std::min(count, begin + UPDATE_CHUNK);
+        integrateParticles(&x[begin], &y[begin], &vx[begin], &vy[begin], &age[begin], &drag[begin],
+                           &groundY[begin], end - begin, dt, gravity);
+    });
+
+    // The particle moved into a hole has not been checked yet, so stay put
+    for (size_t i = 0; i < count;) {
+        if (age[i] >= life[i]) {
+            kill(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void ParticlePool::writeVertices(float* out) const {
+    size_t chunks = (count + UPDATE_CHUNK - 1) / UPDATE_CHUNK;
+    parallelFor(chunks, 1, [&](size_t chunk) {
+        for (size_t i = chunk * UPDATE_CHUNK; i < std::min(count, (chunk + 1) * UPDATE_CHUNK); i++) {
+            out[3 * i] = x[i];
+            out[3 * i + 1] = y[i];
+            out[3 * i + 2] = kind[i] + std::min(age[i] / life[i], 0.999f);
+        }
+    });
+}
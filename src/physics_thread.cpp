@@ -0,0 +1,26 @@
+#include "physics_thread.h"
+#include <chrono>
+
+void PhysicsThread::start(int stepsPerSecond, std::function<void()> step) {
+    stop();
+    stopping = false;
+    thread = std::thread([this, stepsPerSecond, step]() {
+        typedef std::chrono::steady_clock Clock;
+        Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / stepsPerSecond));
+        Clock::time_point next = Clock::now();
+        while (!stopping) {
+            step();
+            next += period;
+            Clock::time_point now = Clock::now();
+            if (now - next > period * MAX_BACKLOG_STEPS) next = now;
+            std::this_thread::sleep_until(next);
+        }
+    });
+}
+
+void PhysicsThread::stop() {
+    if (!thread.joinable()) return;
+    stopping = true;
+    thread.join();
+}
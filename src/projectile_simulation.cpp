@@ -1,13 +1,55 @@
 #include "projectile_simulation.h"
 #include "shader_utils.h"
+#include "render_backend.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include "imgui/include/imgui.h"
 #include "imgui/include/imgui_impl_glfw.h"
 #include "imgui/include/imgui_impl_opengl3.h"
+#include "parallel.h"
+#include "alloc_tracker.h"
+#include <iostream>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <random>
+#include <thread>
 
 // Shader paths
 constexpr auto VERTEX_SHADER_PATH = "../shaders/projectile.vert";
 constexpr auto FRAGMENT_SHADER_PATH = "../shaders/projectile.frag";
+constexpr auto TRAJECTORY_SHADER_PATH = "../shaders/trajectory_feedback.vert";
+constexpr auto ANALYTIC_SHADER_PATH = "../shaders/analytic_trajectory.vert";
+constexpr auto PARTICLE_VERTEX_SHADER_PATH = "../shaders/particle.vert";
+constexpr auto PARTICLE_FRAGMENT_SHADER_PATH = "../shaders/particle.frag";
+
+constexpr float GRAVITY = 9.81f;
+
+// Physics steps per second, on the physics thread
+constexpr int PHYSICS_RATE = 120;
+constexpr float PHYSICS_STEP = 1.0f / PHYSICS_RATE;
+
+// Session logs keep a full keyframe this often, which bounds how far a
+// seek has to re-simulate
+constexpr unsigned long long KEYFRAME_STEPS = PHYSICS_RATE;
+
+// Terrain extends past the right edge of the view so long shots still land
+constexpr float TERRAIN_LEFT = -15.0f;
+constexpr float TERRAIN_RIGHT = 45.0f;
+constexpr float VIEW_BOTTOM = -5.0f;
+constexpr float VIEW_HALF_WIDTH = 15.0f;
+
+// Below this closing speed contacts stop bouncing, so piles can settle
+constexpr float RESTING_SPEED = 0.5f;
+
+// Bodies are put back this far off a wall they touched
+constexpr float CONTACT_OFFSET = 1e-3f;
+constexpr int MAX_CONTACTS_PER_STEP = 8;
+
+static glm::vec2 bounceOff(const glm::vec2& velocity, const glm::vec2& normal, float restitution) {
+    float into = glm::dot(velocity, normal);
+    return into < 0.0f ? velocity - (1.0f + restitution) * into * normal : velocity;
+}
 
 void ProjectileSimulation::init() {
     // 1. Set up shaders
@@ -19,9 +61,22 @@ void ProjectileSimulation::init() {
     setupBuffers();          // base class buffers VAO,VBO
     setupCannonBuffers();    // Projectile-specific buffers
     setupTargetBuffers();
+    setupTrajectoryBuffers();
+    setupAnalyticBuffers();
+    setupTerrainBuffers();
+    setupBodyBuffers();
+    setupParticleBuffers();
+    buildTerrain();
+    buildObstacles();
+    predictionModel.gravity = GRAVITY;
+    selectPredictionModel();
     
-    // 3. Initialize projectile state
+    // 3. Initialize projectile state, then hand it to the physics thread
+    settings = controls;
     resetSimulation();
+    publishSnapshot(0.0f);
+    view = &snapshots.read();
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
 }
 
 void ProjectileSimulation::setupCannonBuffers(){
@@ -45,15 +100,11 @@ void ProjectileSimulation::setupCannonBuffers(){
 
 
     // cannon buffers
-    glGenVertexArrays(1, &cannonVAO);
-    glGenBuffers(1, &cannonVBO);
+    cannonVAO = RenderBackend::createVertexArray();
+    cannonVBO = RenderBackend::createBuffer();
 
-    glBindVertexArray(cannonVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cannonVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cannonVertices), cannonVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    RenderBackend::bufferData(cannonVBO, sizeof(cannonVertices), cannonVertices, GL_STATIC_DRAW);
+    RenderBackend::vertexAttribute(cannonVAO, 0, cannonVBO, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
 }
 void ProjectileSimulation::setupTargetBuffers(){
     //target vertices
@@ -67,27 +118,615 @@ void ProjectileSimulation::setupTargetBuffers(){
         targetVertices.push_back(radius * sin(angle));
     }
     // cannon buffers
-    glGenVertexArrays(1, &targetVAO);
-    glGenBuffers(1, &targetVBO);
+    targetVAO = RenderBackend::createVertexArray();
+    targetVBO = RenderBackend::createBuffer();
+
+    RenderBackend::bufferData(targetVBO, targetVertices.size() * sizeof(float), targetVertices.data(),
+                              GL_STATIC_DRAW);
+    RenderBackend::vertexAttribute(targetVAO, 0, targetVBO, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+}
+
+void ProjectileSimulation::setupTrajectoryBuffers() {
+    try {
+        trajectoryProgram = ShaderUtils::make_feedback_shader(TRAJECTORY_SHADER_PATH, "", { "outPosition" });
+    } catch (const std::exception& e) {
+        std::cerr << "GPU trajectories unavailable: " << e.what() << std::endl;
+        trajectoryProgram = 0;
+    }
+
+    // Captured samples, drawn like the CPU path
+    trajectoryVAO = RenderBackend::createVertexArray();
+    trajectoryVBO = RenderBackend::createBuffer();
+    RenderBackend::bindVertexArray(trajectoryVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, trajectoryVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // The sampling pass reads nothing but gl_VertexID
+    feedbackVAO = RenderBackend::createVertexArray();
+    RenderBackend::bindVertexArray(0);
+}
+
+void ProjectileSimulation::setupAnalyticBuffers() {
+    try {
+        analyticProgram = ShaderUtils::make_shader(ANALYTIC_SHADER_PATH, FRAGMENT_SHADER_PATH);
+    } catch (const std::exception& e) {
+        std::cerr << "Analytic paths unavailable: " << e.what() << std::endl;
+        analyticProgram = 0;
+    }
+
+    // Arcs are per-instance; the history buckets are pointed at their
+    // arcs when the history is rebuilt (see pointArcs)
+    historyVBO = RenderBackend::createBuffer();
+    liveArcVBO = RenderBackend::createBuffer();
+    for (int b = 0; b <= ARC_BUCKETS; b++) {
+        GLuint& vao = b < ARC_BUCKETS ? historyVAOs[b] : liveArcVAO;
+        vao = RenderBackend::createVertexArray();
+        RenderBackend::bindVertexArray(vao);
+        for (GLuint attribute = 0; attribute < 3; attribute++) {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 1);
+        }
+    }
+    pointArcs(liveArcVAO, liveArcVBO, 0);
+    RenderBackend::bindVertexArray(0);
+}
+
+int ProjectileSimulation::arcSegments(float duration, int viewportHeight) const {
+    // A parabola's chord over time dt sags g dt^2 / 8 from the curve
+    float tolerance = historyTolerance * (25.0f - VIEW_BOTTOM) / std::max(viewportHeight, 1);
+    float segmentTime = sqrtf(8.0f * tolerance / GRAVITY);
+    return std::min(std::max(static_cast<int>(ceilf(duration / segmentTime)), 1), MAX_ARC_SEGMENTS);
+}
+
+void ProjectileSimulation::rebuildHistory(int viewportHeight) {
+    historyDirty = false;
+    historyViewportHeight = viewportHeight;
+
+    // Counting sort by power-of-two segment count, so each bucket is one
+    // contiguous run of the buffer
+    std::vector<uint8_t> bucketOf(shotHistory.size());
+    size_t starts[ARC_BUCKETS + 1] = {};
+    for (size_t i = 0; i < shotHistory.size(); i++) {
+        int segments = arcSegments(shotHistory[i].duration, viewportHeight);
+        int bucket = 0;
+        while ((1 << bucket) < segments) bucket++;
+        bucketOf[i] = static_cast<uint8_t>(bucket);
+        starts[bucket + 1]++;
+    }
+    for (int b = 0; b < ARC_BUCKETS; b++) starts[b + 1] += starts[b];
+
+    historyBuckets.clear();
+    historyVertices = 0;
+    for (int b = 0; b < ARC_BUCKETS; b++) {
+        size_t count = starts[b + 1] - starts[b];
+        if (count == 0) continue;
+        historyBuckets.push_back({ 1 << b, starts[b], count, historyVAOs[b] });
+        historyVertices += count * ((1 << b) + 1);
+    }
+    std::vector<Arc> sorted(shotHistory.size());
+    for (size_t i = 0; i < shotHistory.size(); i++) sorted[starts[bucketOf[i]]++] = shotHistory[i];
+
+    RenderBackend::bufferData(historyVBO, sorted.size() * sizeof(Arc), sorted.data(), GL_STATIC_DRAW);
+    for (const ArcBucket& bucket : historyBuckets) {
+        pointArcs(bucket.vertexArray, historyVBO, bucket.first);
+    }
+}
+
+void ProjectileSimulation::pointArcs(GLuint arcVAO, GLuint arcVBO, size_t first) {
+    // GL 3.3 has no base instance, so the pointers start at the first arc
+    RenderBackend::bindVertexArray(arcVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, arcVBO);
+    const char* base = reinterpret_cast<const char*>(first * sizeof(Arc));
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Arc), base + offsetof(Arc, start));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Arc), base + offsetof(Arc, velocity));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Arc), base + offsetof(Arc, duration));
+}
+
+void ProjectileSimulation::addRandomShots(int count) {
+    // Flat-ground arcs from the cannon, for trying out a long history
+    std::minstd_rand random(static_cast<unsigned>(shotHistory.size()) + 1);
+    std::uniform_real_distribution<float> angle(glm::radians(10.0f), glm::radians(80.0f));
+    std::uniform_real_distribution<float> speed(5.0f, 20.0f);
+    for (int i = 0; i < count; i++) {
+        float a = angle(random), s = speed(random);
+        glm::vec2 velocity = s * glm::vec2(cosf(a), sinf(a));
+        shotHistory.push_back({ view->projectile.startPosition, velocity, 2.0f * velocity.y / GRAVITY });
+    }
+    historyDirty = true;
+}
+
+void ProjectileSimulation::setupTerrainBuffers() {
+    terrainVAO = RenderBackend::createVertexArray();
+    terrainVBO = RenderBackend::createBuffer();
+    RenderBackend::bindVertexArray(terrainVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, terrainVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
 
-    glBindVertexArray(targetVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, targetVBO);
-    glBufferData(GL_ARRAY_BUFFER, targetVertices.size() * sizeof(float), targetVertices.data(), GL_STATIC_DRAW);
+    impactVAO = RenderBackend::createVertexArray();
+    impactVBO = RenderBackend::createBuffer();
+    RenderBackend::bindVertexArray(impactVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, impactVBO);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    RenderBackend::bindVertexArray(0);
+}
+
+void ProjectileSimulation::buildTerrain() {
+    terrainError.clear();
+    if (terrainPreset == HeightmapFile) {
+        try {
+            terrain.loadPgm(heightmapPath, TERRAIN_LEFT, TERRAIN_RIGHT, -4.0f, 8.0f);
+        } catch (const std::exception& e) {
+            terrainError = e.what();
+            terrainPreset = FlatGround;
+        }
+    }
+    if (terrainPreset != HeightmapFile) {
+        std::vector<float> samples(terrainSamples);
+        for (int i = 0; i < terrainSamples; i++) {
+            float x = TERRAIN_LEFT + (TERRAIN_RIGHT - TERRAIN_LEFT) * i / (terrainSamples - 1);
+            float y = 0.0f;
+            if (terrainPreset == Hills) {
+                // Rolling hills with fine bumps, so every sample matters
+                y = 1.2f * sin(0.35f * x) + 0.8f * sin(0.9f * x + 1.0f) + 0.05f * sin(37.0f * x) * sin(11.0f * x);
+            } else if (terrainPreset == Trenches) {
+                // Steep-walled trenches cut into flat ground
+                const float centers[] = { 0.0f, 8.0f, 18.0f };
+                for (float center : centers) {
+                    float wall = glm::smoothstep(1.25f, 1.2f, fabsf(x - center));
+                    y = std::min(y, -3.0f * wall);
+                }
+            } else if (terrainPreset == Cliffs) {
+                // A plateau with sheer faces, then a slope climbing away
+                y = 4.0f * glm::smoothstep(-4.0f, -3.9f, x) - 5.0f * glm::smoothstep(6.0f, 6.1f, x);
+                y += 0.25f * std::max(0.0f, x - 10.0f);
+            }
+            samples[i] = y;
+        }
+        terrain.setSamples(std::move(samples), TERRAIN_LEFT, TERRAIN_RIGHT);
+    }
+
+    // Draw from the pyramid level with a few thousand nodes: one column per
+    // node from its highest sample down below the view, so no peak is lost
+    int level = 0;
+    while (level + 1 < terrain.getLevelCount() && terrain.getLevel(level).size() > 4096) level++;
+    const std::vector<glm::vec2>& nodes = terrain.getLevel(level);
+    float nodeWidth = terrain.getSpacing() * (1 << level);
+    terrainVertices.clear();
+    terrainVertices.reserve(nodes.size() * 4);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        float x = std::min(TERRAIN_LEFT + (i + 0.5f) * nodeWidth, TERRAIN_RIGHT);
+        terrainVertices.insert(terrainVertices.end(), { x, nodes[i].y, x, VIEW_BOTTOM - 1.0f });
+    }
+    terrainVertexCount = static_cast<int>(terrainVertices.size() / 2);
+    terrainDirty = true;
+
+    impactPoints.clear();
+}
+
+float ProjectileSimulation::flightTime(const glm::vec2& start, const glm::vec2& velocity, bool& hit) const {
+    float time = 0.0f;
+    hit = terrain.intersectTrajectory(start, velocity, GRAVITY, time);
+    if (hit) return time;
+
+    // Flew off the end of the terrain: let it fall out of sight
+    float drop = start.y - std::min(terrain.getMinHeight(), VIEW_BOTTOM) + 1.0f;
+    return (velocity.y + sqrtf(velocity.y * velocity.y + 2.0f * GRAVITY * drop)) / GRAVITY;
+}
+
+void ProjectileSimulation::fireTestShots() {
+    impactPoints.resize(testShotCount);
+    std::vector<int> nodesVisited(testShotCount);
+    auto launchVelocity = [&](int shot) {
+        float angle = glm::radians(90.0f * (shot + 0.5f) / testShotCount);
+        return controls.launchSpeed * glm::vec2(cos(angle), sin(angle));
+    };
+
+    double start = glfwGetTime();
+    parallelFor(testShotCount, 256, [&](size_t shot) {
+        glm::vec2 velocity = launchVelocity(static_cast<int>(shot));
+        float time = 0.0f;
+        if (terrain.intersectTrajectory(view->projectile.startPosition, velocity, GRAVITY, time, &nodesVisited[shot])) {
+            impactPoints[shot] = view->projectile.startPosition + velocity * time - glm::vec2(0.0f, 0.5f * GRAVITY * time * time);
+        } else {
+            impactPoints[shot] = glm::vec2(TERRAIN_RIGHT * 2.0f, 0.0f);  // off screen
+        }
+    });
+    testShotMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0);
+
+    long long totalNodes = 0;
+    for (int nodes : nodesVisited) totalNodes += nodes;
+    testShotNodes = static_cast<float>(totalNodes) / testShotCount;
+
+    // Cell-by-cell scans are far slower, so time a sample and scale up
+    const int LINEAR_STRIDE = 64;
+    int sampled = 0;
+    start = glfwGetTime();
+    for (int shot = 0; shot < testShotCount; shot += LINEAR_STRIDE, sampled++) {
+        float time = 0.0f;
+        terrain.intersectTrajectoryLinear(view->projectile.startPosition, launchVelocity(shot), GRAVITY, time);
+    }
+    linearShotMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0) * testShotCount / sampled;
+
+    impactsDirty = true;
+}
+
+void ProjectileSimulation::buildObstacles() {
+    // A thin wall standing on the terrain, a slanted plank and a triangle
+    obstacles.clear();
+    float wallBase = terrain.heightAt(2.0f) - 1.0f;
+    obstacles.addPolygon({ glm::vec2(1.95f, wallBase), glm::vec2(2.05f, wallBase),
+                           glm::vec2(2.05f, wallBase + 9.0f), glm::vec2(1.95f, wallBase + 9.0f) });
+    obstacles.addPolygon({ glm::vec2(6.0f, 12.0f), glm::vec2(11.0f, 14.0f),
+                           glm::vec2(11.0f, 14.08f), glm::vec2(6.0f, 12.08f) });
+    obstacles.addPolygon({ glm::vec2(-5.0f, 10.0f), glm::vec2(-3.0f, 10.0f), glm::vec2(-4.0f, 12.0f) });
+    obstacles.build();
+    obstaclesDirty = true;
+}
+
+void ProjectileSimulation::uploadPendingBuffers() {
+    if (terrainDirty) {
+        terrainDirty = false;
+        RenderBackend::bufferData(terrainVBO, terrainVertices.size() * sizeof(float), terrainVertices.data(),
+                                  GL_STATIC_DRAW);
+    }
+    if (impactsDirty) {
+        impactsDirty = false;
+        RenderBackend::bufferData(impactVBO, impactPoints.size() * sizeof(glm::vec2), impactPoints.data(),
+                                  GL_DYNAMIC_DRAW);
+    }
+    if (obstaclesDirty) {
+        obstaclesDirty = false;
+        if (!obstacleVAO) {
+            obstacleVAO = RenderBackend::createVertexArray();
+            obstacleVBO = RenderBackend::createBuffer();
+            RenderBackend::vertexAttribute(obstacleVAO, 0, obstacleVBO, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+        }
+        const std::vector<glm::vec2>& edges = obstacles.getEdgePoints();
+        RenderBackend::bufferData(obstacleVBO, edges.size() * sizeof(glm::vec2), edges.data(), GL_STATIC_DRAW);
+    }
+    if (overlayDirty) {
+        overlayDirty = false;
+        if (!overlayVAO) {
+            overlayVAO = RenderBackend::createVertexArray();
+            overlayVBO = RenderBackend::createBuffer();
+            RenderBackend::vertexAttribute(overlayVAO, 0, overlayVBO, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+        }
+        RenderBackend::bufferData(overlayVBO, overlayVertices.size() * sizeof(glm::vec2), overlayVertices.data(),
+                                  GL_STATIC_DRAW);
+    }
+}
+
+bool ProjectileSimulation::findObstacleContact(const glm::vec2& from, const glm::vec2& to, float radius,
+                                               float& fraction, glm::vec2& normal, glm::vec2& contact) const {
+    if (!settings.showObstacles) return false;
+    if (settings.continuousCollision) {
+        SweepHit hit;
+        if (!obstacles.sweep(from, to, radius, hit)) return false;
+        fraction = hit.time;
+        normal = hit.normal;
+        contact = from + (to - from) * hit.time + normal * CONTACT_OFFSET;
+        return true;
+    }
+
+    // Discrete: only where the move ends is checked, so thin walls get skipped
+    float depth = 0.0f;
+    if (!obstacles.overlap(to, radius, normal, depth)) return false;
+    fraction = 1.0f;
+    contact = to + normal * (depth + CONTACT_OFFSET);
+    return true;
+}
+
+glm::vec2 ProjectileSimulation::arcPosition(float time) const {
+    return projectile.arcStart + projectile.arcVelocity * time - glm::vec2(0.0f, 0.5f * GRAVITY * time * time);
+}
+
+void ProjectileSimulation::setupBodyBuffers() {
+    bodyVAO = RenderBackend::createVertexArray();
+    bodyVBO = RenderBackend::createBuffer();
+    RenderBackend::bindVertexArray(bodyVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, bodyVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    RenderBackend::bindVertexArray(0);
+}
+
+void ProjectileSimulation::setupParticleBuffers() {
+    try {
+        particleProgram = ShaderUtils::make_shader(PARTICLE_VERTEX_SHADER_PATH, PARTICLE_FRAGMENT_SHADER_PATH);
+    } catch (const std::exception& e) {
+        std::cerr << "Impact effects unavailable: " << e.what() << std::endl;
+        particleProgram = 0;
+        return;
+    }
+    particles.reserve(MAX_PARTICLES);
+    particleVertices.resize(MAX_PARTICLES * 3);
+
+    particleVAO = RenderBackend::createVertexArray();
+    particleVBO = RenderBackend::createBuffer();
+    RenderBackend::bufferData(particleVBO, MAX_PARTICLES * 3 * sizeof(float), nullptr, GL_STREAM_DRAW);
+    RenderBackend::vertexAttribute(particleVAO, 0, particleVBO, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+    RenderBackend::vertexAttribute(particleVAO, 1, particleVBO, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
+                                   2 * sizeof(float));
+}
+
+void ProjectileSimulation::burstAt(const glm::vec2& point, const glm::vec2& normal, float speed, size_t count) {
+    // Particles bounce off a flat floor at the impact height
+    particles.burst(ParticlePool::Dust, point, normal, speed, count, point.y, particleRandom);
+    particles.burst(ParticlePool::Debris, point, normal, speed, count / 3, point.y, particleRandom);
+    particles.burst(ParticlePool::Spark, point, normal, speed, count / 6, point.y, particleRandom);
+}
+
+void ProjectileSimulation::emitImpactParticles(const Snapshot& state) {
+    bool emit = impactEffects && particleProgram;
+    if (state.launch != sparkLaunch) {
+        sparkLaunch = state.launch;
+        sparkBounces = 0;
+    }
+
+    // Snapshots only show the latest bounce, so several in one frame make
+    // one shower of sparks, thrown along the rebound
+    if (state.projectile.bounces > sparkBounces) {
+        sparkBounces = state.projectile.bounces;
+        glm::vec2 rebound = state.projectile.arcVelocity;
+        float speed = glm::length(rebound);
+        if (emit && speed > 1e-3f) {
+            particles.burst(ParticlePool::Spark, state.projectile.arcStart, rebound / speed, speed,
+                            particlesPerImpact / 4, terrain.heightAt(state.projectile.arcStart.x),
+                            particleRandom);
+        }
+    }
+
+    if (state.completed && state.launch != impactLaunch) {
+        impactLaunch = state.launch;
+        if (!emit) return;
+        glm::vec2 point = state.projectile.position;
+        glm::vec2 velocity = state.projectile.arcVelocity - glm::vec2(0.0f, GRAVITY * state.projectile.arcTime);
+
+        // Thrown off the slope when it landed on terrain, straight up otherwise
+        glm::vec2 normal(0.0f, 1.0f);
+        float step = terrain.getSpacing();
+        if (fabsf(point.y - terrain.heightAt(point.x)) < 0.05f && step > 0.0f) {
+            float slope = (terrain.heightAt(point.x + step) - terrain.heightAt(point.x - step)) / (2.0f * step);
+            normal = glm::normalize(glm::vec2(-slope, 1.0f));
+        }
+        burstAt(point, normal, glm::length(velocity), particlesPerImpact);
+    }
+}
+
+void ProjectileSimulation::drawParticles(CommandList& commands, const glm::mat4& projection) {
+    if (!particleProgram || particles.size() == 0) return;
+    commands.setLayer(EffectsLayer);
+    commands.useProgram(particleProgram);
+    commands.uniform("projection", projection);
+    commands.uniform("pixelsPerUnit", commands.getViewportHeight() / (25.0f - VIEW_BOTTOM));
+    commands.bindVertexArray(particleVAO);
+    commands.drawArrays(GL_POINTS, 0, static_cast<GLsizei>(particles.size()));
+}
+
+void ProjectileSimulation::spawnSwarm() {
+    bodies.clear();
+
+    // Staggered rows of pegs
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 7; column++) {
+            glm::vec2 position(-9.0f + 3.0f * column + 1.5f * (row % 2), 4.0f + 4.0f * row);
+            bodies.add(position, glm::vec2(0.0f), 0.5f, 0.0f);
+        }
+    }
+    pegCount = bodies.size();
+
+    // Balls rain down over the top of the view, moving the way the cannon points
+    std::minstd_rand random(7);
+    std::uniform_real_distribution<float> spreadX(-VIEW_HALF_WIDTH + settings.bodyRadius, VIEW_HALF_WIDTH - settings.bodyRadius);
+    std::uniform_real_distribution<float> spreadY(16.0f, 25.0f);
+    std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+    float angle = glm::radians(settings.cannonAngle);
+    glm::vec2 launch = 0.2f * settings.launchSpeed * glm::vec2(cos(angle), sin(angle));
+    for (int i = 0; i < settings.swarmSize; i++) {
+        glm::vec2 position(spreadX(random), spreadY(random));
+        bodies.add(position, launch + 2.0f * glm::vec2(jitter(random), jitter(random)), settings.bodyRadius, 1.0f);
+    }
+    reserveSwarm();
+    swarmRunning = true;
+}
+
+void ProjectileSimulation::reserveSwarm() {
+    // Sized here, so the steps that follow allocate nothing
+    hashGrid.reserve(bodies.size());
+    sweepAndPrune.reserve(bodies.size());
+    contactPairs.reserve(bodies.size() * Broadphase::PAIRS_PER_BODY);
+}
+
+void ProjectileSimulation::stepSwarm(float deltaTime) {
+    float h = std::min(deltaTime, 1.0f / 30.0f) / settings.swarmSubsteps;
+    size_t count = bodies.size();
+    Broadphase& broadphase = settings.broadphaseType == HashGridBroadphase ? static_cast<Broadphase&>(hashGrid)
+                                                                   : static_cast<Broadphase&>(sweepAndPrune);
+    integrateMilliseconds = broadphaseMilliseconds = responseMilliseconds = 0.0f;
+
+    for (int substep = 0; substep < settings.swarmSubsteps; substep++) {
+        // Bodies are independent until the contacts, so integrate in parallel
+        double start = glfwGetTime();
+        parallelFor(count, 1024, [&](size_t i) {
+            if (bodies.inverseMass[i] == 0.0f) return;
+            float r = bodies.radius[i];
+            glm::vec2 from(bodies.x[i], bodies.y[i]);
+            bodies.vy[i] -= GRAVITY * h;
+            bodies.x[i] += bodies.vx[i] * h;
+            bodies.y[i] += bodies.vy[i] * h;
+
+            float fraction;
+            glm::vec2 normal, contact;
+            if (findObstacleContact(from, glm::vec2(bodies.x[i], bodies.y[i]), r, fraction, normal, contact)) {
+                glm::vec2 velocity = bounceOff(glm::vec2(bodies.vx[i], bodies.vy[i]), normal, settings.restitution);
+                bodies.x[i] = contact.x;
+                bodies.y[i] = contact.y;
+                bodies.vx[i] = velocity.x;
+                bodies.vy[i] = velocity.y;
+            }
+
+            // Side walls and terrain
+            if (bodies.x[i] < -VIEW_HALF_WIDTH + r) {
+                bodies.x[i] = -VIEW_HALF_WIDTH + r;
+                bodies.vx[i] = fabsf(bodies.vx[i]) * settings.restitution;
+            } else if (bodies.x[i] > VIEW_HALF_WIDTH - r) {
+                bodies.x[i] = VIEW_HALF_WIDTH - r;
+                bodies.vx[i] = -fabsf(bodies.vx[i]) * settings.restitution;
+            }
+            float ground = terrain.heightAt(bodies.x[i]) + r;
+            if (bodies.y[i] < ground) {
+                bodies.y[i] = ground;
+                if (bodies.vy[i] < 0.0f) {
+                    bodies.vy[i] = bodies.vy[i] < -RESTING_SPEED ? -bodies.vy[i] * settings.restitution : 0.0f;
+                }
+            }
+        });
+        double built = glfwGetTime();
+        integrateMilliseconds += static_cast<float>((built - start) * 1000.0);
+
+        broadphase.build(bodies.x.data(), bodies.y.data(), bodies.radius.data(), count);
+        broadphase.findPairs(contactPairs);
+        double found = glfwGetTime();
+        broadphaseMilliseconds += static_cast<float>((found - built) * 1000.0);
+
+        resolveContacts();
+        responseMilliseconds += static_cast<float>((glfwGetTime() - found) * 1000.0);
+    }
+}
+
+void ProjectileSimulation::resolveContacts() {
+    // Sequential impulses in pair order: each pair is separated along its
+    // normal and, if closing, given a settings.restitution impulse. Pairs share
+    // bodies, so this part stays on one thread.
+    for (const BodyPair& pair : contactPairs) {
+        uint32_t a = pair.a, b = pair.b;
+        float wa = bodies.inverseMass[a], wb = bodies.inverseMass[b];
+        float w = wa + wb;
+        if (w == 0.0f) continue;
+
+        float dx = bodies.x[b] - bodies.x[a], dy = bodies.y[b] - bodies.y[a];
+        float reach = bodies.radius[a] + bodies.radius[b];
+        float distance2 = dx * dx + dy * dy;
+        if (distance2 >= reach * reach) continue;
+        float distance = sqrtf(distance2);
+        float nx = 0.0f, ny = 1.0f;
+        if (distance > 1e-6f) {
+            nx = dx / distance;
+            ny = dy / distance;
+        }
+
+        float push = (reach - distance) / w;
+        bodies.x[a] -= nx * push * wa;
+        bodies.y[a] -= ny * push * wa;
+        bodies.x[b] += nx * push * wb;
+        bodies.y[b] += ny * push * wb;
+
+        float closing = (bodies.vx[b] - bodies.vx[a]) * nx + (bodies.vy[b] - bodies.vy[a]) * ny;
+        if (closing >= 0.0f) continue;
+        float bounce = closing < -RESTING_SPEED ? settings.restitution : 0.0f;
+        float impulse = -(1.0f + bounce) * closing / w;
+        bodies.vx[a] -= impulse * wa * nx;
+        bodies.vy[a] -= impulse * wa * ny;
+        bodies.vx[b] += impulse * wb * nx;
+        bodies.vy[b] += impulse * wb * ny;
+    }
+}
+
+void ProjectileSimulation::evaluateTrajectory(const Snapshot& state) {
+    // Sample the whole flight from launch to impact
+    float flightTime = state.impactTime;
+    trajectoryTimeStep = flightTime / (trajectorySamples - 1);
+    if (trajectoryTimeStep <= 0.0f) return;
+
+    // Buffers only grow, so launches at the same sample count reuse them
+    if (trajectorySamples > trajectoryCapacity) {
+        trajectoryCapacity = trajectorySamples;
+        RenderBackend::bufferData(trajectoryVBO, trajectoryCapacity * 2 * sizeof(float), nullptr,
+                                  GL_DYNAMIC_COPY);
+        referenceXs.resize(trajectoryCapacity);
+        referenceYs.resize(trajectoryCapacity);
+    }
+
+    // CPU reference over the same samples, structure-of-arrays so the loop vectorises
+    double start = glfwGetTime();
+    float* xs = referenceXs.data();
+    float* ys = referenceYs.data();
+    for (int i = 0; i < trajectorySamples; i++) {
+        float t = i * trajectoryTimeStep;
+        xs[i] = state.projectile.startPosition.x + state.projectile.velocity.x * t;
+        ys[i] = state.projectile.startPosition.y + state.projectile.velocity.y * t - 0.5f * GRAVITY * t * t;
+    }
+    cpuTrajectoryMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0);
+
+    glFinish();
+    start = glfwGetTime();
+    RenderBackend::useProgram(trajectoryProgram);
+    glUniform2fv(glGetUniformLocation(trajectoryProgram, "startPosition"), 1, &state.projectile.startPosition[0]);
+    glUniform2fv(glGetUniformLocation(trajectoryProgram, "launchVelocity"), 1, &state.projectile.velocity[0]);
+    glUniform1f(glGetUniformLocation(trajectoryProgram, "gravity"), GRAVITY);
+    glUniform1f(glGetUniformLocation(trajectoryProgram, "timeStep"), trajectoryTimeStep);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, trajectoryVBO);
+    RenderBackend::bindVertexArray(feedbackVAO);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, trajectorySamples);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glFinish();
+    gpuTrajectoryMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0);
 }
 
 void ProjectileSimulation::updatePhysics(float deltaTime) {
     if (!simulationRunning) return;
 
-    constexpr float GRAVITY = 9.81f;
-    
+    // Follow the current arc. A wall contact starts a new arc from the
+    // contact point with the reflected velocity, and the rest of the frame
+    // carries on along that.
+    float remaining = deltaTime;
+    bool settled = false;
+    for (int contacts = 0; contacts < MAX_CONTACTS_PER_STEP && remaining > 0.0f; contacts++) {
+        float step = std::min(remaining, impactTime - projectile.arcTime);
+        glm::vec2 from = arcPosition(projectile.arcTime);
+        glm::vec2 to = arcPosition(projectile.arcTime + step);
+        float fraction;
+        glm::vec2 normal, contact;
+        if (!findObstacleContact(from, to, settings.projectileRadius, fraction, normal, contact)) {
+            projectile.arcTime += step;
+            break;
+        }
+
+        // A frame's move is short, so its chord stands in for the arc when
+        // timing the contact
+        float contactTime = projectile.arcTime + step * fraction;
+        glm::vec2 velocity = projectile.arcVelocity - glm::vec2(0.0f, GRAVITY * contactTime);
+        pathPoints.push_back(contact);
+        projectile.bounces++;
+        remaining -= step * fraction;
+        shotArcs.back().duration = contactTime;
+
+        // Settled on top of something: the shot ends here
+        if (normal.y > 0.7f && -glm::dot(velocity, normal) < RESTING_SPEED) {
+            projectile.arcStart = contact;
+            projectile.arcVelocity = glm::vec2(0.0f);
+            projectile.arcTime = impactTime = 0.0f;
+            hitTerrain = true;
+            settled = true;
+            break;
+        }
+        projectile.arcStart = contact;
+        projectile.arcVelocity = bounceOff(velocity, normal, settings.wallRestitution);
+        projectile.arcTime = 0.0f;
+        impactTime = flightTime(contact, projectile.arcVelocity, hitTerrain);
+        shotArcs.push_back({ contact, projectile.arcVelocity, 0.0f });
+    }
+    if (!settled) shotArcs.back().duration = projectile.arcTime;
     projectile.time += deltaTime;
-    projectile.position.x = projectile.startPosition.x + projectile.velocity.x * projectile.time;
-    projectile.position.y = projectile.startPosition.y + 
-                           (projectile.velocity.y * projectile.time) - 
-                           (0.5f * GRAVITY * projectile.time * projectile.time);
+    projectile.position = arcPosition(projectile.arcTime);
 
     // Update statistics
     currentHeight = projectile.position.y;
@@ -96,96 +735,264 @@ void ProjectileSimulation::updatePhysics(float deltaTime) {
     // Store path points (keep entire path)
     pathPoints.push_back(projectile.position);
 
-    // Check for landing
-    if (projectile.position.y <= 0.0f) {
+    // Check for landing (the impact time was found at launch or the last bounce)
+    if (projectile.arcTime >= impactTime) {
         simulationRunning = false;
         simulationCompleted = true;  // Mark simulation as completed
         totalDistance = projectile.position.x - projectile.startPosition.x;
-        distanceFromTarget = glm::abs(projectile.position.x - targetPosition.x);
+        distanceFromTarget = fabsf(projectile.position.x - targetPosition.x);
     }
 }
 
-void ProjectileSimulation::render(float deltaTime) {
-    // Update physics if simulation is running
-    if (simulationRunning) {
-        updatePhysics(deltaTime);
+void ProjectileSimulation::update(float deltaTime) {
+    // Physics runs on its own thread; pick up whatever it published last
+    view = &snapshots.read();
+    const Snapshot& state = *view;
+
+    // Events first: a launch, a landing, an impact, a rebuild. These may
+    // allocate; the per-frame work after them must not.
+    if (state.launch != evaluatedLaunch) {
+        evaluatedLaunch = state.launch;
+        trajectoryTimeStep = 0.0f;
+        if (gpuTrajectory && state.projectile.bounces == 0) {
+            evaluateTrajectory(state);
+        }
     }
 
-    // Update vertex data with entire path
-    std::vector<float> vertices;
-    for (const auto& point : pathPoints) {
-        vertices.push_back(point.x);
-        vertices.push_back(point.y);
+    // A landed shot joins the history (replays re-fly old shots, so not those)
+    if (state.completed && !state.replaying && state.launch != archivedLaunch) {
+        archivedLaunch = state.launch;
+        shotHistory.insert(shotHistory.end(), state.shotArcs.begin(), state.shotArcs.end());
+        historyDirty = true;
+    }
+    emitImpactParticles(state);
+    uploadPendingBuffers();
+    if (state.replayFailures != shownReplayFailures) {
+        shownReplayFailures = state.replayFailures;
+        sessionError = state.replayError;
+    }
+    // Logs that failed to write (a full disk) are stopped rather than left
+    // to look like they are still recording
+    if (state.trajectoryLogging && trajectoryWriter.hasFailed()) {
+        stopTrajectoryLog();
+    }
+    if (state.recording && recorder.hasFailed()) {
+        stopRecording();
     }
 
-    // Add ground path vertices
-    
-        vertices.push_back(pathPoints.front().x);
-        vertices.push_back(projectile.startPosition.y); // Ground level
-        vertices.push_back(pathPoints.back().x);
-        vertices.push_back(projectile.startPosition.y); // Ground level
-    
+    bool drawAnalytic = analyticPaths && analyticProgram;
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (drawAnalytic && (historyDirty || viewport[3] != historyViewportHeight)) {
+        rebuildHistory(viewport[3]);
+    }
 
-    // Update VBO
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    AllocTracker::HotRegion hot;
 
-     // Clear and set up rendering
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(shaderProgram);
+    // A long pause between frames (the window idling) must not fling the
+    // particles, so their step is capped
+    if (particles.size() > 0) {
+        double start = glfwGetTime();
+        particles.update(std::min(deltaTime, 0.05f), GRAVITY);
+        particles.writeVertices(particleVertices.data());
+        particleMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0);
 
-        // Get uniform locations
-    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLint colorLoc = glGetUniformLocation(shaderProgram, "color");
+        // Orphaning the buffer first lets the driver hand out fresh storage
+        // instead of waiting for last frame's draw to finish with it
+        if (particleProgram) {
+            RenderBackend::bufferData(particleVBO, MAX_PARTICLES * 3 * sizeof(float), nullptr, GL_STREAM_DRAW);
+            RenderBackend::bufferSubData(particleVBO, 0, particles.size() * 3 * sizeof(float),
+                                         particleVertices.data());
+        }
+    }
 
-        // Set projection matrix
-    glm::mat4 projection = glm::ortho(-15.0f, 15.0f, -5.0f, 25.0f, -1.0f, 1.0f);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
+    // Upload vertex data only for a snapshot not seen before: the path
+    // points straight from the snapshot, then the two ends of the ground
+    // line. Analytic paths need only the ball from the path.
+    size_t firstPathVertex = drawAnalytic ? state.pathPoints.size() - 1 : 0;
+    if (state.id != uploadedSnapshot && !state.pathPoints.empty()) {
+        uploadedSnapshot = state.id;
+        size_t pathCount = state.pathPoints.size() - firstPathVertex;
+        glm::vec2 ground[2] = {
+            glm::vec2(state.pathPoints.front().x, state.projectile.startPosition.y),
+            glm::vec2(state.pathPoints.back().x, state.projectile.startPosition.y),
+        };
+        RenderBackend::bufferData(VBO, (pathCount + 2) * sizeof(glm::vec2), nullptr, GL_DYNAMIC_DRAW);
+        RenderBackend::bufferSubData(VBO, 0, pathCount * sizeof(glm::vec2), &state.pathPoints[firstPathVertex]);
+        RenderBackend::bufferSubData(VBO, pathCount * sizeof(glm::vec2), sizeof(ground), ground);
 
-    // Draw cannon
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(projectile.startPosition, 0.0f));
-    model = glm::rotate(model, glm::radians(cannonAngle), glm::vec3(0.0f, 0.0f, 1.0f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]);
-    
-    glBindVertexArray(cannonVAO);
-    
-    // Draw barrel
-    glUniform3f(colorLoc, 0.4f, 0.4f, 0.4f); // Dark gray for barrel
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-    
-    // Draw base
-    glUniform3f(colorLoc, 0.6f, 0.3f, 0.1f); // Brown for base
-    glDrawArrays(GL_TRIANGLE_FAN, 4, 4);
-    
-    
-    
+        if (state.swarmRunning) {
+            RenderBackend::bufferData(bodyVBO, state.bodyVertices.size() * sizeof(float), state.bodyVertices.data(),
+                                      GL_STREAM_DRAW);
+        }
+    }
 
-        // Draw target
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(targetPosition, 0.0f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]);
-    glUniform3f(colorLoc, 1.0f, 0.0f, 0.0f); // Red
-    glBindVertexArray(targetVAO);
-    glDrawArrays(GL_LINE_LOOP, 0, 32);
+    // The shot in flight: a handful of arcs, re-sent every frame and drawn
+    // as one instanced strip at the finest arc's segment count
+    liveArcSegments = 0;
+    if (drawAnalytic && (state.running || state.completed)) {
+        RenderBackend::bufferData(liveArcVBO, state.shotArcs.size() * sizeof(Arc), state.shotArcs.data(),
+                                  GL_STREAM_DRAW);
+        for (const Arc& arc : state.shotArcs) {
+            liveArcSegments = std::max(liveArcSegments, arcSegments(arc.duration, viewport[3]));
+        }
+    }
+}
+
+void ProjectileSimulation::render(CommandList& commands) {
+    const Snapshot& state = *view;
+    bool drawAnalytic = analyticPaths && analyticProgram;
+    size_t firstPathVertex = drawAnalytic ? state.pathPoints.size() - 1 : 0;
+
+    // Room for every draw below, so recording them allocates nothing
+    Flight prediction;
+    commands.reserve(24 + historyBuckets.size() + overlayFirst.size() + state.pegs.size(),
+                     { shaderProgram, analyticProgram, particleProgram });
+    {
+        AllocTracker::HotRegion hot;
+
+         // Clear and set up rendering
+        commands.clearColor(glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+        commands.useProgram(shaderProgram);
 
-        // Draw projectile path
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE,  &glm::mat4(1.0f)[0][0]);
-    glUniform3f(colorLoc, 0.0f, 1.0f, 0.0f); // Green for path
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_LINE_STRIP, 0, pathPoints.size());
-    glDrawArrays(GL_POINTS, pathPoints.size() - 1, 1);
+            // Set projection matrix
+        glm::mat4 projection = glm::ortho(-15.0f, 15.0f, VIEW_BOTTOM, 25.0f, -1.0f, 1.0f);
+        commands.uniform("projection", projection);
 
+        // Draw terrain
+        commands.setLayer(GroundLayer);
+        commands.uniform("model", glm::mat4(1.0f));
+        commands.uniform("color", glm::vec3(0.35f, 0.3f, 0.2f));
+        commands.bindVertexArray(terrainVAO);
+        commands.drawArrays(GL_TRIANGLE_STRIP, 0, terrainVertexCount);
 
+        // Draw cannon
+        commands.setLayer(SceneLayer);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(state.projectile.startPosition, 0.0f));
+        model = glm::rotate(model, glm::radians(controls.cannonAngle), glm::vec3(0.0f, 0.0f, 1.0f));
+        commands.uniform("model", model);
 
- 
+        commands.bindVertexArray(cannonVAO);
 
-  
+        // Draw barrel
+        commands.uniform("color", glm::vec3(0.4f, 0.4f, 0.4f)); // Dark gray for barrel
+        commands.drawArrays(GL_TRIANGLE_FAN, 0, 4);
 
-    // Draw ground path
-     if (!pathPoints.empty()) {
-        glUniform3f(colorLoc, 0.5f, 0.5f, 0.5f); // Gray for ground
-        glDrawArrays(GL_LINES, pathPoints.size(), 2);
+        // Draw base
+        commands.uniform("color", glm::vec3(0.6f, 0.3f, 0.1f)); // Brown for base
+        commands.drawArrays(GL_TRIANGLE_FAN, 4, 4);
+
+        if (controls.showObstacles) {
+            commands.uniform("model", glm::mat4(1.0f));
+            commands.uniform("color", glm::vec3(0.6f, 0.8f, 1.0f));
+            commands.bindVertexArray(obstacleVAO);
+            commands.drawArrays(GL_LINES, 0, obstacles.getEdgePoints().size());
+        }
+
+            // Draw target
+        commands.setLayer(OverlayLayer);
+        model = glm::translate(glm::mat4(1.0f), glm::vec3(state.targetPosition, 0.0f));
+        commands.uniform("model", model);
+        commands.uniform("color", glm::vec3(1.0f, 0.0f, 0.0f)); // Red
+        commands.bindVertexArray(targetVAO);
+        commands.drawArrays(GL_LINE_LOOP, 0, 32);
+
+            // Draw projectile path
+        commands.uniform("model", glm::mat4(1.0f));
+        commands.uniform("color", glm::vec3(0.0f, 1.0f, 0.0f)); // Green for path
+        if (gpuTrajectory && trajectoryTimeStep > 0.0f && state.projectile.bounces == 0 &&
+            (state.running || state.completed)) {
+            // Only the samples flown so far (the GPU samples one unbroken arc)
+            int flown = std::min(trajectorySamples,
+                                 static_cast<int>(state.projectile.time / trajectoryTimeStep) + 1);
+            commands.bindVertexArray(trajectoryVAO);
+            commands.drawArrays(GL_LINE_STRIP, 0, flown);
+        } else if (drawAnalytic) {
+            // update() rebuilt the history and sent the live arcs
+            commands.useProgram(analyticProgram);
+            commands.uniform("projection", projection);
+            commands.uniform("gravity", GRAVITY);
+            commands.uniform("color", glm::vec3(0.3f, 0.55f, 0.3f));
+            for (const ArcBucket& bucket : historyBuckets) {
+                commands.uniform("segments", bucket.segments);
+                commands.bindVertexArray(bucket.vertexArray);
+                commands.drawArraysInstanced(GL_LINE_STRIP, 0, bucket.segments + 1, static_cast<GLsizei>(bucket.count));
+            }
+            if (liveArcSegments > 0) {
+                commands.uniform("color", glm::vec3(0.0f, 1.0f, 0.0f));
+                commands.uniform("segments", liveArcSegments);
+                commands.bindVertexArray(liveArcVAO);
+                commands.drawArraysInstanced(GL_LINE_STRIP, 0, liveArcSegments + 1,
+                                             static_cast<GLsizei>(state.shotArcs.size()));
+            }
+            commands.useProgram(shaderProgram);
+        } else {
+            commands.bindVertexArray(VAO);
+            commands.drawArrays(GL_LINE_STRIP, 0, state.pathPoints.size());
+        }
+        commands.uniform("color", glm::vec3(0.0f, 1.0f, 0.0f));
+        commands.bindVertexArray(VAO);
+        commands.drawArrays(GL_POINTS, state.pathPoints.size() - 1 - firstPathVertex, 1);
+
+        // Predicted landing point; the tables assume flat ground
+        bool aiming = !state.running && !state.completed && !state.replaying;
+        if (showPrediction && aiming && predictionTable) {
+            prediction = predictionTable->sample(controls.cannonAngle, controls.launchSpeed,
+                                                 static_cast<RangeTable::Interpolation>(predictionInterpolation));
+        }
+        if (showPrediction && aiming && predictionTable && prediction.landed) {
+            glm::vec2 landing = state.projectile.startPosition + glm::vec2(prediction.range, 0.0f);
+            glm::mat4 marker = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(landing, 0.0f)), glm::vec3(0.5f));
+            commands.uniform("model", marker);
+            commands.uniform("color", glm::vec3(0.3f, 0.9f, 1.0f));
+            commands.bindVertexArray(targetVAO);
+            commands.drawArrays(GL_LINE_LOOP, 0, 32);
+            commands.uniform("model", glm::mat4(1.0f));
+        }
+
+        if (!impactPoints.empty()) {
+            commands.uniform("color", glm::vec3(1.0f, 1.0f, 0.0f));
+            commands.bindVertexArray(impactVAO);
+            commands.drawArrays(GL_POINTS, 0, impactPoints.size());
+        }
+
+        // One strip per shot; the queue folds them into a single call
+        if (!overlayFirst.empty()) {
+            commands.uniform("color", glm::vec3(0.8f, 0.5f, 0.9f));
+            commands.bindVertexArray(overlayVAO);
+            for (size_t i = 0; i < overlayFirst.size(); i++) {
+                commands.drawArrays(GL_LINE_STRIP, overlayFirst[i], overlayCount[i]);
+            }
+        }
+
+        // Draw swarm: pegs as outlines, balls as points one diameter across
+        if (state.swarmRunning) {
+            commands.uniform("color", glm::vec3(1.0f, 1.0f, 1.0f));
+            commands.bindVertexArray(targetVAO);
+            for (const glm::vec3& peg : state.pegs) {
+                glm::mat4 pegModel = glm::translate(glm::mat4(1.0f), glm::vec3(peg.x, peg.y, 0.0f));
+                pegModel = glm::scale(pegModel, glm::vec3(peg.z / 0.5f));
+                commands.uniform("model", pegModel);
+                commands.drawArrays(GL_LINE_LOOP, 0, 32);
+            }
+            commands.uniform("model", glm::mat4(1.0f));
+
+            // The shader's fixed gl_PointSize is for the projectile; size balls from here
+            commands.setPointSize(std::max(1.0f, 2.0f * controls.bodyRadius * commands.getViewportHeight() / 30.0f));
+            commands.uniform("color", glm::vec3(0.9f, 0.6f, 0.2f));
+            commands.bindVertexArray(bodyVAO);
+            commands.drawArrays(GL_POINTS, 0, state.bodyVertices.size() / 2);
+            commands.setPointSize(0.0f);
+        }
+
+        // Draw ground path
+         if (!state.pathPoints.empty()) {
+            commands.uniform("color", glm::vec3(0.5f, 0.5f, 0.5f)); // Gray for ground
+            commands.bindVertexArray(VAO);
+            commands.drawArrays(GL_LINES, state.pathPoints.size() - firstPathVertex, 2);
+        }
+
+        drawParticles(commands, projection);
     }
 
     // Enhanced UI with initial conditions section
@@ -197,36 +1004,109 @@ void ProjectileSimulation::render(float deltaTime) {
     ImGui::Separator();
     ImGui::Spacing();
 
+    // Any edit below is sent to the physics thread at the end of the frame
+    bool controlsChanged = false;
+
     // Only show controls when simulation is ready for new input
-    if (!simulationRunning && !simulationCompleted) {
-        ImGui::SliderFloat("Cannon Angle", &cannonAngle, 0.0f, 90.0f);
-        ImGui::SliderFloat("Launch Speed", &launchSpeed, 0.0f, 50.0f);
+    if (state.replaying) {
+        ImGui::Text("Playing back a recorded session.");
+    } else if (!state.running && !state.completed) {
+        controlsChanged |= ImGui::SliderFloat("Cannon Angle", &controls.cannonAngle, 0.0f, 90.0f);
+        controlsChanged |= ImGui::SliderFloat("Launch Speed", &controls.launchSpeed, 0.0f, 50.0f);
+        controlsChanged |= ImGui::SliderFloat("Target Distance", &controls.targetDistance, 0.0f, 25.0f);
 
-            // Modified target distance input
-    if (ImGui::SliderFloat("Target Distance", &targetDistance,0.0f,25.0f)) {
-        targetPosition.x = projectile.startPosition.x + targetDistance;
-    }
+        ImGui::Checkbox("Predict Landing", &showPrediction);
+        if (showPrediction) {
+            const char* interpolationNames[] = { "Bilinear", "Bicubic" };
+            ImGui::Combo("Interpolation", &predictionInterpolation, interpolationNames, 2);
+            ImGui::SliderFloat("Drag", &predictionModel.drag, 0.0f, 0.05f, "%.4f");
+            bool modelChanged = ImGui::IsItemDeactivatedAfterEdit();
+            ImGui::SliderFloat("Wind", &predictionModel.wind, -20.0f, 20.0f, "%.1f m/s");
+            modelChanged |= ImGui::IsItemDeactivatedAfterEdit();
+            if (modelChanged) {
+                selectPredictionModel();
+            }
+            if (predictionTable && !prediction.landed) {
+                ImGui::TextDisabled("Predicted: does not land within the table's flight time");
+            } else if (predictionTable) {
+                float miss = fabsf(prediction.range - controls.targetDistance);
+                ImGui::Text("Predicted: %.2f m, apex %.2f m, %.2f s", prediction.range, prediction.apex, prediction.time);
+                if (miss < 0.5f) {
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(0, 1, 0, 1), "HIT");
+                } else {
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(1, 0, 0, 1), "MISS by %.2f m", miss);
+                }
+                if (terrainPreset != FlatGround || controls.showObstacles) {
+                    ImGui::TextDisabled("Assumes flat ground without obstacles");
+                }
+                if (predictionModel.drag > 0.0f) {
+                    ImGui::TextDisabled("The cannon itself flies without drag");
+                }
+            }
+            if (!predictionError.empty()) {
+                ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%s", predictionError.c_str());
+            }
+        }
+
+        const char* terrainNames[] = { "Flat", "Hills", "Trenches", "Cliffs", "Heightmap (PGM)" };
+        bool terrainChanged = ImGui::Combo("Terrain", &terrainPreset, terrainNames, TerrainPresetCount);
+        if (terrainPreset == HeightmapFile) {
+            ImGui::InputText("Heightmap", heightmapPath, sizeof(heightmapPath));
+            terrainChanged |= ImGui::Button("Load Heightmap");
+        } else {
+            // A rebuild stops physics and redoes the pyramid, so only once
+            // the drag is over
+            ImGui::SliderInt("Terrain Samples", &terrainSamples, 2, MAX_TERRAIN_SAMPLES, "%d",
+                             ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_AlwaysClamp);
+            terrainChanged |= ImGui::IsItemDeactivatedAfterEdit();
+        }
+        if (terrainChanged) {
+            rebuildTerrain();
+        }
+        if (!terrainError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%s", terrainError.c_str());
+        }
+        
+        controlsChanged |= ImGui::Checkbox("Obstacles", &controls.showObstacles);
+        if (controls.showObstacles) {
+            controlsChanged |= ImGui::Checkbox("Continuous Collision", &controls.continuousCollision);
+            controlsChanged |= ImGui::SliderFloat("Projectile Radius", &controls.projectileRadius, 0.0f, 0.5f);
+            controlsChanged |= ImGui::SliderFloat("Wall Restitution", &controls.wallRestitution, 0.0f, 1.0f);
+        }
+
+        if (trajectoryProgram) {
+            ImGui::Checkbox("GPU Trajectory (transform feedback)", &gpuTrajectory);
+            if (gpuTrajectory) {
+                ImGui::SliderInt("Trajectory Samples", &trajectorySamples, 16, 1 << 20, "%d",
+                                 ImGuiSliderFlags_Logarithmic);
+            }
+        }
         
         if (ImGui::Button("Fire Cannon!", ImVec2(150, 30))) {
-            float angleRad = glm::radians(cannonAngle);
-            projectile.velocity.x = launchSpeed * cos(angleRad);
-            projectile.velocity.y = launchSpeed * sin(angleRad);
-            targetPosition.x = projectile.startPosition.x + targetDistance;
-            simulationRunning = true;
+            sendCommand(Fire);
+            controlsChanged = false;
         }
     }
-    else if (simulationCompleted) {
+    else if (state.completed) {
         ImGui::Text("Simulation completed! Press Reset to start new simulation.");
-        if (distanceFromTarget < 0.5f)
+        if (state.distanceFromTarget < 0.5f)
         {
-            ImGui::TextColored(ImVec4(0,1,0,1), "Target Hit, Your point %.2f",std::max(0.0,10.0 - distanceFromTarget));
+            ImGui::TextColored(ImVec4(0,1,0,1), "Target Hit, Your point %.2f",std::max(0.0,10.0 - state.distanceFromTarget));
         }
         else
         {
-            ImGui::TextColored(ImVec4(1,0,0,1), "Target Missed, Your point %.2f",std::max(0.0,10.0 - distanceFromTarget));
+            ImGui::TextColored(ImVec4(1,0,0,1), "Target Missed, Your point %.2f",std::max(0.0,10.0 - state.distanceFromTarget));
         }
         
-        ImGui::Text("Distance from Target: %.2f m", distanceFromTarget);
+        ImGui::Text("Distance from Target: %.2f m", state.distanceFromTarget);
+        if (!state.hitTerrain) {
+            ImGui::Text("The shot flew past the end of the terrain.");
+        }
+        if (state.projectile.bounces > 0) {
+            ImGui::Text("Bounced off obstacles %d times", state.projectile.bounces);
+        }
 
     }
 
@@ -236,11 +1116,170 @@ void ProjectileSimulation::render(float deltaTime) {
 
     // Statistics Section
     ImGui::TextColored(ImVec4(1,1,0,1), "STATISTICS");
-    ImGui::Text("Current Height: %.2f m", currentHeight);
-    ImGui::Text("Max Height: %.2f m", maxHeight);
-    ImGui::Text("Total Distance: %.2f m", totalDistance);
-    ImGui::Text("Current Velocity: (%.2f, %.2f) m/s", projectile.velocity.x, projectile.velocity.y);
+    ImGui::Text("Current Height: %.2f m", state.currentHeight);
+    ImGui::Text("Max Height: %.2f m", state.maxHeight);
+    ImGui::Text("Total Distance: %.2f m", state.totalDistance);
+    ImGui::Text("Current Velocity: (%.2f, %.2f) m/s", state.projectile.velocity.x, state.projectile.velocity.y);
+    ImGui::Text("Physics: %d Hz, last step %.2f ms", PHYSICS_RATE, state.stepMilliseconds);
+    if (gpuTrajectory && trajectoryTimeStep > 0.0f) {
+        ImGui::Text("Trajectory (%d samples): GPU %.3f ms, CPU %.3f ms", trajectorySamples,
+                    gpuTrajectoryMilliseconds, cpuTrajectoryMilliseconds);
+    }
     
+    ImGui::Text("Terrain: %zu samples, %d pyramid levels", terrain.getSamples().size(), terrain.getLevelCount());
+    ImGui::SliderInt("Test Shots", &testShotCount, 16, 1 << 16, "%d", ImGuiSliderFlags_Logarithmic);
+    if (ImGui::Button("Fire Test Shots")) {
+        fireTestShots();
+    }
+    if (!impactPoints.empty()) {
+        ImGui::Text("Pyramid: %.3f ms (%.1f nodes/shot)", testShotMilliseconds, testShotNodes);
+        ImGui::Text("Linear scan: ~%.1f ms", linearShotMilliseconds);
+    }
+
+    if (ImGui::CollapsingHeader("Swarm")) {
+        ImGui::SliderInt("Bodies", &controls.swarmSize, 100, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Body Radius", &controls.bodyRadius, 0.02f, 0.5f);
+        controlsChanged |= ImGui::SliderFloat("Restitution", &controls.restitution, 0.0f, 1.0f);
+        controlsChanged |= ImGui::SliderInt("Substeps", &controls.swarmSubsteps, 1, 8);
+        const char* broadphaseNames[] = { "Spatial Hash", "Sweep and Prune" };
+        controlsChanged |= ImGui::Combo("Broadphase", &controls.broadphaseType, broadphaseNames, 2);
+        if (ImGui::Button("Spawn Swarm")) {
+            sendCommand(SpawnSwarm);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Swarm")) {
+            sendCommand(ClearSwarm);
+        }
+        if (state.swarmRunning) {
+            ImGui::Text("%zu bodies, %zu contacts", state.bodyCount, state.contactCount);
+            ImGui::Text("Integrate %.2f ms, broadphase %.2f ms, response %.2f ms", state.integrateMilliseconds,
+                        state.broadphaseMilliseconds, state.responseMilliseconds);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Impact Effects")) {
+        if (particleProgram) {
+            ImGui::Checkbox("Dust, Debris and Sparks", &impactEffects);
+            ImGui::SliderInt("Particles per Impact", &particlesPerImpact, 100, 200000, "%d",
+                             ImGuiSliderFlags_Logarithmic);
+            if (ImGui::Button("Burst 1M")) {
+                burstAt(state.targetPosition, glm::vec2(0.0f, 1.0f), controls.launchSpeed, MAX_PARTICLES * 2 / 3);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Clear Particles")) {
+                particles.clear();
+            }
+            ImGui::Text("%zu / %zu particles (peak %zu)", particles.size(), particles.capacity(),
+                        particles.getHighWaterMark());
+            ImGui::Text("Update %.2f ms", particleMilliseconds);
+        } else {
+            ImGui::TextDisabled("Particle shaders failed to load");
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Shot History")) {
+        if (analyticProgram) {
+            if (ImGui::Checkbox("Analytic Paths (vertex shader)", &analyticPaths)) {
+                uploadedSnapshot = 0;
+            }
+        }
+        if (ImGui::SliderFloat("Tolerance (px)", &historyTolerance, 0.05f, 4.0f, "%.2f",
+                               ImGuiSliderFlags_Logarithmic)) {
+            historyDirty = true;
+        }
+        if (ImGui::Button("Add 1000 Shots")) {
+            addRandomShots(1000);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear History")) {
+            shotHistory.clear();
+            historyDirty = true;
+        }
+        ImGui::Text("%zu arcs, %.1f KB", shotHistory.size(), shotHistory.size() * sizeof(Arc) / 1024.0);
+        if (analyticPaths) {
+            ImGui::Text("%zu draws, %zu vertices generated", historyBuckets.size(), historyVertices);
+        } else {
+            ImGui::TextDisabled("History is only drawn with analytic paths");
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Trajectory Log")) {
+        ImGui::InputText("Log File", trajectoryPath, sizeof(trajectoryPath));
+        if (state.trajectoryLogging) {
+            ImGui::Text("%llu samples, %.1f MB written", state.trajectoryRows,
+                        state.trajectoryBytes / (1024.0 * 1024.0));
+            if (ImGui::Button("Stop Logging")) {
+                stopTrajectoryLog();
+            }
+        } else {
+            ImGui::Checkbox("Include Swarm", &logSwarm);
+            if (ImGui::Button("Start Logging")) {
+                startTrajectoryLog();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Load Shots")) {
+                loadTrajectoryOverlay();
+            }
+            if (!overlayFirst.empty()) {
+                ImGui::SameLine();
+                if (ImGui::Button("Clear Shots")) {
+                    overlayFirst.clear();
+                    overlayCount.clear();
+                    overlaySummary.clear();
+                }
+            }
+        }
+        if (!overlaySummary.empty()) {
+            ImGui::Text("%s", overlaySummary.c_str());
+        }
+        if (!trajectoryError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%s", trajectoryError.c_str());
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Record / Replay")) {
+        ImGui::InputText("Session File", sessionPath, sizeof(sessionPath));
+        if (state.replaying) {
+            int last = static_cast<int>(state.lastStep - state.firstStep);
+            int scrub = static_cast<int>(state.replayStep - state.firstStep);
+            if (ImGui::SliderInt("Step", &scrub, 0, last)) {
+                sendCommand(Seek, state.firstStep + scrub);
+            }
+            ImGui::Text("%.2f s of %.2f s", static_cast<float>(scrub) / PHYSICS_RATE,
+                        static_cast<float>(last) / PHYSICS_RATE);
+            if (ImGui::Button(state.replayPaused ? "Resume" : "Pause")) {
+                sendCommand(SetPaused, state.replayPaused ? 0 : 1);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Stop Playback")) {
+                stopPlayback();
+            }
+            if (state.mismatchStep) {
+                ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Replay diverged at step %llu (%.2f s)",
+                                   state.mismatchStep - state.firstStep,
+                                   static_cast<float>(state.mismatchStep - state.firstStep) / PHYSICS_RATE);
+            } else {
+                ImGui::Text("State hashes match the recording");
+            }
+        } else if (state.recording) {
+            ImGui::Text("Recording, %.1f KB so far", state.recordedBytes / 1024.0f);
+            if (ImGui::Button("Stop Recording")) {
+                stopRecording();
+            }
+        } else {
+            if (ImGui::Button("Record")) {
+                startRecording();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Play")) {
+                startPlayback();
+            }
+        }
+        if (!sessionError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%s", sessionError.c_str());
+        }
+    }
+
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
@@ -248,26 +1287,34 @@ void ProjectileSimulation::render(float deltaTime) {
     // Controls Section
     ImGui::TextColored(ImVec4(1,1,0,1), "CONTROLS");
     if (ImGui::Button("Reset Simulation", ImVec2(150, 30))) {
-        resetSimulation();
+        sendCommand(Reset);
+        controlsChanged = false;
     }
-        // Update target position when distance changes
-    if (ImGui::IsItemDeactivatedAfterEdit()) {
-        targetPosition.x = projectile.startPosition.x + targetDistance;
+    if (controlsChanged) {
+        sendCommand(ApplySettings);
     }
     
     ImGui::End();
 }
 
 void ProjectileSimulation::resetSimulation() {
+    glm::vec2 cannonPosition(-10.0f, terrain.heightAt(-10.0f));
     projectile = {
-        .startPosition = glm::vec2(-10.0f, 0.0f),
-        .position = glm::vec2(-10.0f, 0.0f),
+        .startPosition = cannonPosition,
+        .position = cannonPosition,
         .velocity = glm::vec2(0.0f, 0.0f),
-        .time = 0.0f
+        .time = 0.0f,
+        .arcStart = cannonPosition,
+        .arcVelocity = glm::vec2(0.0f, 0.0f),
+        .arcTime = 0.0f,
+        .bounces = 0
     };
-    targetPosition = glm::vec2(projectile.startPosition.x + targetDistance, 0.0f);
+    float targetX = projectile.startPosition.x + settings.targetDistance;
+    targetPosition = glm::vec2(targetX, terrain.heightAt(targetX));
+    impactTime = 0.0f;
     pathPoints.clear();
     pathPoints.push_back(projectile.position);
+    shotArcs.clear();
     simulationRunning = false;
     simulationCompleted = false;  // Reset completion flag
     maxHeight = 0.0f;
@@ -275,19 +1322,707 @@ void ProjectileSimulation::resetSimulation() {
     currentHeight = 0.0f;
 }
 
+void ProjectileSimulation::launch() {
+    // A second Fire queued before the UI saw the first one land is dropped
+    if (simulationRunning || simulationCompleted) return;
+    float angleRad = glm::radians(settings.cannonAngle);
+    projectile.velocity.x = settings.launchSpeed * cos(angleRad);
+    projectile.velocity.y = settings.launchSpeed * sin(angleRad);
+    targetPosition.x = projectile.startPosition.x + settings.targetDistance;
+    targetPosition.y = terrain.heightAt(targetPosition.x);
+    impactTime = flightTime(projectile.startPosition, projectile.velocity, hitTerrain);
+    projectile.arcStart = projectile.startPosition;
+    projectile.arcVelocity = projectile.velocity;
+    projectile.arcTime = 0.0f;
+    projectile.bounces = 0;
+    shotArcs.assign(1, Arc{ projectile.startPosition, projectile.velocity, 0.0f });
+
+    // Room for the flight up front, so the steps themselves do not grow
+    // these; twice the first arc leaves room for most bounces
+    size_t flightSteps = static_cast<size_t>(std::min(impactTime * PHYSICS_RATE, 1e6f));
+    pathPoints.reserve(pathPoints.size() + 2 * flightSteps + 2);
+    shotArcs.reserve(16);
+    simulationRunning = true;
+    launchCount++;
+}
+
+void ProjectileSimulation::applyCommand(const Command& command) {
+    // Also what replays call, so it may only depend on the command and the
+    // physics thread's own state
+    settings = command.settings;
+    switch (command.type) {
+        case ApplySettings:
+            // The target follows its slider until the next shot is fired
+            if (!simulationRunning && !simulationCompleted) {
+                targetPosition.x = projectile.startPosition.x + settings.targetDistance;
+                targetPosition.y = terrain.heightAt(targetPosition.x);
+            }
+            break;
+        case Fire:
+            launch();
+            break;
+        case Reset:
+            resetSimulation();
+            break;
+        case SpawnSwarm:
+            spawnSwarm();
+            break;
+        case ClearSwarm:
+            swarmRunning = false;
+            bodies.clear();
+            pegCount = 0;
+            contactPairs.clear();
+            break;
+        case Seek:
+        case SetPaused:
+            break;
+    }
+}
+
+bool ProjectileSimulation::simulateStep() {
+    // The part of a step that replays repeat exactly
+    bool moved = false;
+    if (simulationRunning) {
+        updatePhysics(PHYSICS_STEP);
+        moved = true;
+    }
+    if (swarmRunning) {
+        stepSwarm(PHYSICS_STEP);
+        moved = true;
+    }
+    return moved;
+}
+
+void ProjectileSimulation::stepPhysics() {
+    // Runs on the physics thread. Nothing is published while nothing moves
+    // and no command arrived, so an idle scene costs no copying.
+    AllocTracker::Scope allocScope(AllocTracker::Physics);
+    double start = glfwGetTime();
+    bool changed = false;
+    bool seek = false;
+    unsigned long long seekStep = 0;
+    if (!replaying) physicsStep++;
+
+    Command command;
+    while (commands.pop(command)) {
+        commandsApplied++;
+        changed = true;
+        if (command.type == Seek) {
+            // Only the last of a burst of scrubs matters
+            seek = true;
+            seekStep = command.argument;
+        } else if (command.type == SetPaused) {
+            replayPaused = command.argument != 0;
+        } else if (!replaying) {
+            // The UI's own commands are ignored while a recording plays
+            applyCommand(command);
+            if (recorder.isOpen()) {
+                encodeCommand(command, logBytes);
+                recorder.command(physicsStep, logBytes);
+            }
+        }
+    }
+
+    if (replaying) {
+        // A corrupt or truncated record ends the playback, not the program;
+        // the live simulation carries on from wherever it got to, and the
+        // UI picks the message up from the snapshot
+        try {
+            if (seek) {
+                seekReplay(seekStep);
+            } else if (!replayPaused) {
+                advanceReplay();
+                changed = true;
+            }
+        } catch (const std::exception& e) {
+            replaying = false;
+            player.close();
+            replayError = e.what();
+            replayFailures++;
+            changed = true;
+        }
+    } else {
+        bool flying = simulationRunning;
+        if (simulationRunning) {
+            // A step adds at most a point and an arc per contact, and the
+            // end point; the room for that is made here, outside the region
+            size_t room = MAX_CONTACTS_PER_STEP + 1;
+            if (pathPoints.capacity() - pathPoints.size() < room) {
+                pathPoints.reserve(2 * pathPoints.capacity() + room);
+            }
+            if (shotArcs.capacity() - shotArcs.size() < room) {
+                shotArcs.reserve(2 * shotArcs.capacity() + room);
+            }
+        }
+        {
+            // Commands may allocate (a new swarm, say); plain steps must not
+            AllocTracker::HotRegion hot;
+            changed |= simulateStep();
+        }
+        if (trajectoryWriter.isOpen()) {
+            logTrajectories(flying);
+        }
+        if (changed && recorder.isOpen()) {
+            recorder.hash(physicsStep, stateHash());
+            if (physicsStep - recorder.getLastKeyframeStep() >= KEYFRAME_STEPS) {
+                encodeKeyframe(logBytes);
+                recorder.keyframe(physicsStep, logBytes);
+            }
+        }
+    }
+
+    if (changed) {
+        publishSnapshot(static_cast<float>((glfwGetTime() - start) * 1000.0));
+    }
+}
+
+void ProjectileSimulation::publishSnapshot(float stepMilliseconds) {
+    // Slots are reused, so every field is written, and the vectors keep
+    // their capacity from the last time round
+    Snapshot& out = snapshots.back();
+    out.id = ++snapshotCount;
+    out.commandsApplied = commandsApplied;
+    out.launch = launchCount;
+    out.projectile = projectile;
+    out.targetPosition = targetPosition;
+    out.running = simulationRunning;
+    out.completed = simulationCompleted;
+    out.hitTerrain = hitTerrain;
+    out.impactTime = impactTime;
+    out.maxHeight = maxHeight;
+    out.totalDistance = totalDistance;
+    out.currentHeight = currentHeight;
+    out.distanceFromTarget = distanceFromTarget;
+    out.pathPoints.assign(pathPoints.begin(), pathPoints.end());
+    out.shotArcs.assign(shotArcs.begin(), shotArcs.end());
+
+    // Pegs are drawn as outlines, balls as points from ready-made vertices
+    out.swarmRunning = swarmRunning;
+    out.pegs.resize(pegCount);
+    for (size_t i = 0; i < pegCount; i++) {
+        out.pegs[i] = glm::vec3(bodies.x[i], bodies.y[i], bodies.radius[i]);
+    }
+    size_t balls = bodies.size() - pegCount;
+    out.bodyVertices.resize(balls * 2);
+    parallelFor(balls, 4096, [&](size_t i) {
+        out.bodyVertices[2 * i] = bodies.x[pegCount + i];
+        out.bodyVertices[2 * i + 1] = bodies.y[pegCount + i];
+    });
+    out.bodyCount = bodies.size();
+    out.contactCount = contactPairs.size();
+    out.integrateMilliseconds = integrateMilliseconds;
+    out.broadphaseMilliseconds = broadphaseMilliseconds;
+    out.responseMilliseconds = responseMilliseconds;
+    out.stepMilliseconds = stepMilliseconds;
+    out.recording = recorder.isOpen();
+    out.recordedBytes = recorder.getBytesWritten();
+    out.replaying = replaying;
+    out.replayPaused = replayPaused;
+    out.replayStep = replayStep;
+    out.firstStep = replaying ? player.getFirstStep() : 0;
+    out.lastStep = replaying ? player.getLastStep() : 0;
+    out.mismatchStep = mismatchStep;
+    out.replayFailures = replayFailures;
+    out.replayError = replayError;
+    out.trajectoryLogging = trajectoryWriter.isOpen();
+    out.trajectoryRows = trajectoryWriter.getRowCount();
+    out.trajectoryBytes = trajectoryWriter.getBytesWritten();
+    snapshots.publish();
+}
+
+void ProjectileSimulation::sendCommand(CommandType type, unsigned long long argument) {
+    // The physics thread drains the queue every step, so it is only ever
+    // full if that thread is stuck; wait for room rather than drop input
+    Command command;
+    command.type = type;
+    command.settings = controls;
+    command.argument = argument;
+    while (!commands.push(command)) {
+        std::this_thread::yield();
+    }
+    commandsSent++;
+}
+
+void ProjectileSimulation::rebuildTerrain() {
+    // Physics reads the terrain and obstacles every step, so they are only
+    // swapped out with the physics thread stopped. A recording is only good
+    // for the terrain it started on.
+    physicsThread.stop();
+    recorder.close();
+    buildTerrain();
+    buildObstacles();
+    resetSimulation();
+    publishSnapshot(0.0f);
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
+}
+
+void ProjectileSimulation::packSettings(const PhysicsSettings& values, uint32_t* words) {
+    auto bits = [](float value) {
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        return word;
+    };
+    words[0] = bits(values.cannonAngle);
+    words[1] = bits(values.launchSpeed);
+    words[2] = bits(values.targetDistance);
+    words[3] = values.showObstacles;
+    words[4] = values.continuousCollision;
+    words[5] = bits(values.projectileRadius);
+    words[6] = bits(values.wallRestitution);
+    words[7] = static_cast<uint32_t>(values.swarmSize);
+    words[8] = bits(values.bodyRadius);
+    words[9] = bits(values.restitution);
+    words[10] = static_cast<uint32_t>(values.swarmSubsteps);
+    words[11] = static_cast<uint32_t>(values.broadphaseType);
+}
+
+void ProjectileSimulation::unpackSettings(const uint32_t* words, PhysicsSettings& values) {
+    auto value = [](uint32_t word) {
+        float result;
+        std::memcpy(&result, &word, sizeof(result));
+        return result;
+    };
+    values.cannonAngle = value(words[0]);
+    values.launchSpeed = value(words[1]);
+    values.targetDistance = value(words[2]);
+    values.showObstacles = words[3] != 0;
+    values.continuousCollision = words[4] != 0;
+    values.projectileRadius = value(words[5]);
+    values.wallRestitution = value(words[6]);
+    values.swarmSize = static_cast<int>(words[7]);
+    values.bodyRadius = value(words[8]);
+    values.restitution = value(words[9]);
+    values.swarmSubsteps = static_cast<int>(words[10]);
+    values.broadphaseType = static_cast<int>(words[11]);
+}
+
+void ProjectileSimulation::encodeCommand(const Command& command, std::vector<uint8_t>& out) {
+    // Type, a mask of the settings that changed since the last logged
+    // command, then each changed word as a zigzagged delta. Dragging one
+    // slider costs a handful of bytes per command.
+    uint32_t words[SETTINGS_WORDS];
+    packSettings(command.settings, words);
+    uint32_t changed = 0;
+    for (int i = 0; i < SETTINGS_WORDS; i++) {
+        if (words[i] != loggedSettings[i]) changed |= 1u << i;
+    }
+    out.clear();
+    ByteWriter writer(out);
+    writer.putByte(static_cast<uint8_t>(command.type));
+    writer.putVarint(changed);
+    for (int i = 0; i < SETTINGS_WORDS; i++) {
+        if (changed & (1u << i)) {
+            writer.putSigned(static_cast<int32_t>(words[i] - loggedSettings[i]));
+            loggedSettings[i] = words[i];
+        }
+    }
+}
+
+ProjectileSimulation::Command ProjectileSimulation::decodeCommand(const SessionReader::Record& record) {
+    ByteReader reader(record.data, record.size);
+    Command command;
+    command.type = static_cast<CommandType>(reader.getByte());
+    uint64_t changed = reader.getVarint();
+    for (int i = 0; i < SETTINGS_WORDS; i++) {
+        if (changed & (1u << i)) {
+            loggedSettings[i] += static_cast<uint32_t>(reader.getSigned());
+        }
+    }
+    unpackSettings(loggedSettings, command.settings);
+    return command;
+}
+
+void ProjectileSimulation::encodeKeyframe(std::vector<uint8_t>& out) {
+    // Everything the physics thread carries from one step to the next.
+    // Contact pairs are rebuilt before use, so they are left out.
+    out.clear();
+    ByteWriter writer(out);
+    packSettings(settings, loggedSettings);
+    for (uint32_t word : loggedSettings) writer.putU32(word);
+    writer.putBytes(&projectile, sizeof(projectile));
+    writer.putBytes(&targetPosition, sizeof(targetPosition));
+    writer.putByte(simulationRunning);
+    writer.putByte(simulationCompleted);
+    writer.putByte(hitTerrain);
+    writer.putFloat(impactTime);
+    writer.putFloat(maxHeight);
+    writer.putFloat(totalDistance);
+    writer.putFloat(currentHeight);
+    writer.putFloat(distanceFromTarget);
+    writer.putVarint(pathPoints.size());
+    writer.putBytes(pathPoints.data(), pathPoints.size() * sizeof(glm::vec2));
+    writer.putByte(swarmRunning);
+    writer.putVarint(pegCount);
+    writer.putFloats(bodies.x);
+    writer.putFloats(bodies.y);
+    writer.putFloats(bodies.vx);
+    writer.putFloats(bodies.vy);
+    writer.putFloats(bodies.radius);
+    writer.putFloats(bodies.inverseMass);
+}
+
+void ProjectileSimulation::restoreKeyframe(const SessionReader::Record& record) {
+    // Decoded and checked in full before any of it is applied, so a bad
+    // record throws with the running state untouched
+    ByteReader reader(record.data, record.size);
+    uint32_t words[SETTINGS_WORDS];
+    for (uint32_t& word : words) word = reader.getU32();
+    Projectile restoredProjectile;
+    glm::vec2 restoredTarget;
+    std::memcpy(&restoredProjectile, reader.getBytes(sizeof(restoredProjectile)), sizeof(restoredProjectile));
+    std::memcpy(&restoredTarget, reader.getBytes(sizeof(restoredTarget)), sizeof(restoredTarget));
+    bool running = reader.getByte() != 0;
+    bool completed = reader.getByte() != 0;
+    bool terrainHit = reader.getByte() != 0;
+    float restoredImpactTime = reader.getFloat();
+    float restoredMaxHeight = reader.getFloat();
+    float restoredDistance = reader.getFloat();
+    float restoredHeight = reader.getFloat();
+    float restoredMiss = reader.getFloat();
+    size_t pathSize = static_cast<size_t>(reader.getVarint());
+    if (pathSize > reader.remaining() / sizeof(glm::vec2)) throw std::runtime_error("Unexpected end of data");
+    const uint8_t* path = reader.getBytes(pathSize * sizeof(glm::vec2));
+    std::vector<glm::vec2> restoredPath(pathSize);
+    if (pathSize) std::memcpy(restoredPath.data(), path, pathSize * sizeof(glm::vec2));
+    bool swarm = reader.getByte() != 0;
+    size_t pegs = static_cast<size_t>(reader.getVarint());
+    BodySet restoredBodies;
+    reader.getFloats(restoredBodies.x);
+    reader.getFloats(restoredBodies.y);
+    reader.getFloats(restoredBodies.vx);
+    reader.getFloats(restoredBodies.vy);
+    reader.getFloats(restoredBodies.radius);
+    reader.getFloats(restoredBodies.inverseMass);
+    size_t count = restoredBodies.size();
+    for (const std::vector<float>* column : { &restoredBodies.y, &restoredBodies.vx, &restoredBodies.vy,
+                                              &restoredBodies.radius, &restoredBodies.inverseMass }) {
+        if (column->size() != count) throw std::runtime_error("Corrupt keyframe: body arrays differ in length");
+    }
+    if (pegs > count) throw std::runtime_error("Corrupt keyframe: more pegs than bodies");
+
+    std::copy(words, words + SETTINGS_WORDS, loggedSettings);
+    unpackSettings(loggedSettings, settings);
+    projectile = restoredProjectile;
+    targetPosition = restoredTarget;
+    simulationRunning = running;
+    simulationCompleted = completed;
+    hitTerrain = terrainHit;
+    impactTime = restoredImpactTime;
+    maxHeight = restoredMaxHeight;
+    totalDistance = restoredDistance;
+    currentHeight = restoredHeight;
+    distanceFromTarget = restoredMiss;
+    pathPoints.swap(restoredPath);
+    // Not logged: earlier arcs of a bouncing shot are only drawn from the path
+    shotArcs.clear();
+    if (simulationRunning || simulationCompleted) {
+        shotArcs.push_back({ projectile.arcStart, projectile.arcVelocity, projectile.arcTime });
+    }
+    swarmRunning = swarm;
+    pegCount = pegs;
+    std::swap(bodies, restoredBodies);
+    contactPairs.clear();
+    reserveSwarm();
+
+    // The shot may be a different one now, so the GPU path is resampled
+    launchCount++;
+}
+
+uint64_t ProjectileSimulation::stateHash() const {
+    uint64_t hash = hashBytes(&projectile, sizeof(projectile));
+    uint32_t flags = simulationRunning | simulationCompleted << 1 | swarmRunning << 2;
+    hash = hashBytes(&flags, sizeof(flags), hash);
+    size_t count = bodies.size();
+    if (count) {
+        hash = hashBytes(bodies.x.data(), count * sizeof(float), hash);
+        hash = hashBytes(bodies.y.data(), count * sizeof(float), hash);
+        hash = hashBytes(bodies.vx.data(), count * sizeof(float), hash);
+        hash = hashBytes(bodies.vy.data(), count * sizeof(float), hash);
+    }
+    return hash;
+}
+
+std::vector<uint8_t> ProjectileSimulation::sessionHeader() const {
+    // What the log cannot replay by itself: the step rate and the terrain
+    std::vector<uint8_t> header;
+    ByteWriter writer(header);
+    writer.putVarint(PHYSICS_RATE);
+    writer.putVarint(terrainPreset);
+    writer.putVarint(terrainSamples);
+    writer.putString(heightmapPath);
+    return header;
+}
+
+void ProjectileSimulation::startRecording() {
+    // Opening the log and writing the first keyframe touch physics state,
+    // so the physics thread sits this out
+    physicsThread.stop();
+    sessionError.clear();
+    try {
+        recorder.open(sessionPath, sessionHeader());
+        encodeKeyframe(logBytes);
+        recorder.keyframe(physicsStep, logBytes);
+    } catch (const std::exception& e) {
+        sessionError = e.what();
+        recorder.close();
+    }
+    publishSnapshot(0.0f);
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
+}
+
+void ProjectileSimulation::stopRecording() {
+    physicsThread.stop();
+    recorder.close();
+    if (recorder.hasFailed()) {
+        sessionError = recorder.getError();
+    }
+    publishSnapshot(0.0f);
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
+}
+
+void ProjectileSimulation::startPlayback() {
+    physicsThread.stop();
+    recorder.close();
+    sessionError.clear();
+    // The terrain the session was recorded on replaces this one, and comes
+    // back if the session cannot be played
+    int previousPreset = terrainPreset;
+    int previousSamples = terrainSamples;
+    std::string previousHeightmap = heightmapPath;
+    bool terrainReplaced = false;
+    try {
+        player.open(sessionPath);
+        ByteReader header(player.getHeader().data(), player.getHeader().size());
+        if (header.getVarint() != static_cast<uint64_t>(PHYSICS_RATE)) {
+            throw std::runtime_error("Session was recorded at a different physics rate");
+        }
+        uint64_t preset = header.getVarint();
+        uint64_t samples = header.getVarint();
+        if (preset >= TerrainPresetCount || samples < 2 || samples > MAX_TERRAIN_SAMPLES) {
+            throw std::runtime_error("Session has an invalid terrain");
+        }
+        std::string path = header.getString();
+        terrainReplaced = true;
+        terrainPreset = static_cast<int>(preset);
+        terrainSamples = static_cast<int>(samples);
+        snprintf(heightmapPath, sizeof(heightmapPath), "%s", path.c_str());
+        buildTerrain();
+        buildObstacles();
+
+        replaying = true;
+        replayPaused = false;
+        replayStep = 0;
+        mismatchStep = 0;
+        seekReplay(player.getFirstStep());
+    } catch (const std::exception& e) {
+        sessionError = e.what();
+        replaying = false;
+        player.close();
+        if (terrainReplaced) {
+            terrainPreset = previousPreset;
+            terrainSamples = previousSamples;
+            snprintf(heightmapPath, sizeof(heightmapPath), "%s", previousHeightmap.c_str());
+            buildTerrain();
+            buildObstacles();
+        }
+    }
+    publishSnapshot(0.0f);
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
+}
+
+void ProjectileSimulation::stopPlayback() {
+    // The live simulation carries on from wherever playback was
+    physicsThread.stop();
+    replaying = false;
+    player.close();
+    publishSnapshot(0.0f);
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
+}
+
+void ProjectileSimulation::advanceReplay() {
+    // One recorded step: its commands, the simulation, then its hash
+    unsigned long long step = replayStep + 1;
+    SessionReader::Record record;
+    SessionReader::Cursor next = replayCursor;
+    while (player.read(next, record) && record.step == step && record.type == SessionRecord::Command) {
+        applyCommand(decodeCommand(record));
+        replayCursor = next;
+    }
+    simulateStep();
+    next = replayCursor;
+    while (player.read(next, record) && record.step == step) {
+        if (record.type == SessionRecord::Hash && record.hash != stateHash() && mismatchStep == 0) {
+            mismatchStep = step;
+        }
+        replayCursor = next;
+    }
+    replayStep = step;
+    if (replayStep >= player.getLastStep()) replayPaused = true;
+}
+
+void ProjectileSimulation::seekReplay(unsigned long long step) {
+    step = std::max<unsigned long long>(player.getFirstStep(), std::min<unsigned long long>(step, player.getLastStep()));
+
+    // Forward within reach of the current state: just keep simulating.
+    // Otherwise restore the closest keyframe and simulate from there.
+    SessionReader::Cursor cursor = player.seek(step);
+    if (step < replayStep || cursor.step > replayStep || replayStep == 0) {
+        SessionReader::Record record;
+        player.read(cursor, record);
+        restoreKeyframe(record);
+        replayCursor = cursor;
+        replayStep = record.step;
+    }
+    bool paused = replayPaused;
+    while (replayStep < step) {
+        advanceReplay();
+    }
+    replayPaused = paused || replayStep >= player.getLastStep();
+}
+
+void ProjectileSimulation::startTrajectoryLog() {
+    physicsThread.stop();
+    trajectoryError.clear();
+    const char* terrainNames[] = { "flat", "hills", "trenches", "cliffs", "heightmap" };
+    time_t now = time(nullptr);
+    char started[32];
+    strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    TrajectoryMetadata metadata = {
+        { "simulation", "projectile" },
+        { "gravity", std::to_string(GRAVITY) },
+        { "physics_rate", std::to_string(PHYSICS_RATE) },
+        { "terrain", terrainNames[terrainPreset] },
+        { "ids", "shot number; swarm balls from 2147483648 up" },
+        { "started", started },
+    };
+    try {
+        trajectoryWriter.open(trajectoryPath, metadata);
+    } catch (const std::exception& e) {
+        trajectoryError = e.what();
+    }
+    publishSnapshot(0.0f);
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
+}
+
+void ProjectileSimulation::stopTrajectoryLog() {
+    physicsThread.stop();
+    trajectoryWriter.close();
+    if (trajectoryWriter.hasFailed()) {
+        trajectoryError = trajectoryWriter.getError();
+    }
+    publishSnapshot(0.0f);
+    physicsThread.start(PHYSICS_RATE, [this]() { stepPhysics(); });
+}
+
+void ProjectileSimulation::logTrajectories(bool flying) {
+    float time = static_cast<float>(physicsStep * PHYSICS_STEP);
+    if (flying) {
+        glm::vec2 velocity = projectile.arcVelocity - glm::vec2(0.0f, GRAVITY * projectile.arcTime);
+        trajectoryWriter.append(launchCount, time, projectile.position.x, projectile.position.y,
+                                velocity.x, velocity.y);
+    }
+    if (logSwarm && swarmRunning && bodies.size() > pegCount) {
+        trajectoryWriter.appendRange(SWARM_LOG_ID, bodies.size() - pegCount, time,
+                                     &bodies.x[pegCount], &bodies.y[pegCount],
+                                     &bodies.vx[pegCount], &bodies.vy[pegCount]);
+    }
+}
+
+void ProjectileSimulation::loadTrajectoryOverlay() {
+    trajectoryError.clear();
+    TrajectoryLog log;
+    try {
+        log.open(trajectoryPath);
+    } catch (const std::exception& e) {
+        trajectoryError = e.what();
+        return;
+    }
+
+    // Shots only (the swarm would be far too many lines). Each shot's rows
+    // are in time order, so a stable sort by id gives one polyline per shot.
+    struct ShotPoint {
+        uint32_t id;
+        glm::vec2 position;
+    };
+    std::vector<ShotPoint> points;
+    for (size_t b = 0; b < log.getBlockCount(); b++) {
+        TrajectoryLog::Block block = log.getBlock(b);
+        for (size_t i = 0; i < block.rows; i++) {
+            if (block.id[i] < SWARM_LOG_ID) {
+                points.push_back({ block.id[i], glm::vec2(block.x[i], block.y[i]) });
+            }
+        }
+    }
+    std::stable_sort(points.begin(), points.end(),
+                     [](const ShotPoint& a, const ShotPoint& b) { return a.id < b.id; });
+
+    overlayVertices.resize(points.size());
+    overlayFirst.clear();
+    overlayCount.clear();
+    for (size_t i = 0; i < points.size(); i++) {
+        overlayVertices[i] = points[i].position;
+        if (i == 0 || points[i].id != points[i - 1].id) {
+            overlayFirst.push_back(static_cast<GLint>(i));
+            overlayCount.push_back(0);
+        }
+        overlayCount.back()++;
+    }
+
+    overlayDirty = true;
+
+    char summary[160];
+    snprintf(summary, sizeof(summary), "%zu shots; %llu rows in %zu blocks, %.1f MB",
+             overlayFirst.size(), static_cast<unsigned long long>(log.getRowCount()), log.getBlockCount(),
+             log.getFileSize() / (1024.0 * 1024.0));
+    overlaySummary = summary;
+}
+
+void ProjectileSimulation::selectPredictionModel() {
+    predictionError.clear();
+    predictionTable = nullptr;
+    try {
+        predictionTable = &rangeTables.get(predictionModel);
+    } catch (const std::exception& e) {
+        predictionError = e.what();
+    }
+}
+
 void ProjectileSimulation::handleInput() {
     if (glfwGetKey(glfwGetCurrentContext(), GLFW_KEY_R) == GLFW_PRESS) {
-        resetSimulation();
+        sendCommand(Reset);
     }
 }
 
 ProjectileSimulation::~ProjectileSimulation() {
-    glDeleteVertexArrays(1, &cannonVAO);
-    glDeleteBuffers(1, &cannonVBO);
-    glDeleteVertexArrays(1, &targetVAO);
-    glDeleteBuffers(1, &targetVBO);
+    physicsThread.stop();
+    RenderBackend::deleteVertexArrays(1, &cannonVAO);
+    RenderBackend::deleteBuffers(1, &cannonVBO);
+    RenderBackend::deleteVertexArrays(1, &targetVAO);
+    RenderBackend::deleteBuffers(1, &targetVBO);
+    RenderBackend::deleteVertexArrays(1, &trajectoryVAO);
+    RenderBackend::deleteBuffers(1, &trajectoryVBO);
+    RenderBackend::deleteVertexArrays(1, &feedbackVAO);
+    RenderBackend::deleteVertexArrays(1, &terrainVAO);
+    RenderBackend::deleteBuffers(1, &terrainVBO);
+    RenderBackend::deleteVertexArrays(1, &impactVAO);
+    RenderBackend::deleteBuffers(1, &impactVBO);
+    RenderBackend::deleteVertexArrays(1, &bodyVAO);
+    RenderBackend::deleteBuffers(1, &bodyVBO);
+    RenderBackend::deleteVertexArrays(1, &obstacleVAO);
+    RenderBackend::deleteBuffers(1, &obstacleVBO);
+    RenderBackend::deleteVertexArrays(1, &overlayVAO);
+    RenderBackend::deleteBuffers(1, &overlayVBO);
+    if (trajectoryProgram) RenderBackend::deleteProgram(trajectoryProgram);
+    RenderBackend::deleteVertexArrays(ARC_BUCKETS, historyVAOs);
+    RenderBackend::deleteBuffers(1, &historyVBO);
+    RenderBackend::deleteVertexArrays(1, &liveArcVAO);
+    RenderBackend::deleteBuffers(1, &liveArcVBO);
+    if (analyticProgram) RenderBackend::deleteProgram(analyticProgram);
+    RenderBackend::deleteVertexArrays(1, &particleVAO);
+    RenderBackend::deleteBuffers(1, &particleVBO);
+    if (particleProgram) RenderBackend::deleteProgram(particleProgram);
 
         // Clean up base class resources
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    RenderBackend::deleteVertexArrays(1, &VAO);
+    RenderBackend::deleteBuffers(1, &VBO);
 }
\ No newline at end of file
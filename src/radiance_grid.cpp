@@ -0,0 +1,92 @@
+#include "radiance_grid.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+void RadianceGrid::resize(int width, int height, const Aabb2D& bounds, int workerCount) {
+    this->width = width;
+    this->height = height;
+    this->bounds = bounds;
+    cellSize = (bounds.max - bounds.min) / glm::vec2(width, height);
+    accumulated.assign(static_cast<size_t>(width) * height, 0.0f);
+    histograms.resize(std::max(workerCount, 1));
+    for (std::vector<float>& histogram : histograms) {
+        histogram.assign(accumulated.size(), 0.0f);
+    }
+}
+
+void RadianceGrid::clear() {
+    std::fill(accumulated.begin(), accumulated.end(), 0.0f);
+    for (std::vector<float>& histogram : histograms) {
+        std::fill(histogram.begin(), histogram.end(), 0.0f);
+    }
+}
+
+void RadianceGrid::splat(int worker, const glm::vec2& start, const glm::vec2& end, float intensity) {
+    // Clip to the grid (Liang-Barsky) so the walk below stays in range
+    glm::vec2 d = end - start;
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int axis = 0; axis < 2; axis++) {
+        if (fabsf(d[axis]) < 1e-12f) {
+            if (start[axis] < bounds.min[axis] || start[axis] > bounds.max[axis]) return;
+            continue;
+        }
+        float ta = (bounds.min[axis] - start[axis]) / d[axis];
+        float tb = (bounds.max[axis] - start[axis]) / d[axis];
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+    }
+    if (t0 >= t1) return;
+
+    // Walk the cells in grid units (Amanatides-Woo), crediting each with
+    // the world-space length of segment inside it
+    float length = glm::length(d);
+    glm::vec2 a = (start + d * t0 - bounds.min) / cellSize;
+    glm::vec2 b = (start + d * t1 - bounds.min) / cellSize;
+    glm::vec2 g = b - a;
+    int x = std::min(static_cast<int>(a.x), width - 1);
+    int y = std::min(static_cast<int>(a.y), height - 1);
+    int endX = std::min(static_cast<int>(b.x), width - 1);
+    int endY = std::min(static_cast<int>(b.y), height - 1);
+    int stepX = g.x > 0.0f ? 1 : -1;
+    int stepY = g.y > 0.0f ? 1 : -1;
+    float deltaX = g.x != 0.0f ? fabsf(1.0f / g.x) : 1e30f;
+    float deltaY = g.y != 0.0f ? fabsf(1.0f / g.y) : 1e30f;
+    float nextX = g.x != 0.0f ? ((stepX > 0 ? x + 1 - a.x : a.x - x) * deltaX) : 1e30f;
+    float nextY = g.y != 0.0f ? ((stepY > 0 ? y + 1 - a.y : a.y - y) * deltaY) : 1e30f;
+
+    // Parameters below run over the clipped part, 0..1
+    float energy = intensity * length * (t1 - t0);
+    std::vector<float>& histogram = histograms[worker];
+    float t = 0.0f;
+    int maxSteps = width + height + 2;
+    for (int step = 0; step < maxSteps; step++) {
+        bool last = x == endX && y == endY;
+        float tExit = last ? 1.0f : std::min(std::min(nextX, nextY), 1.0f);
+        histogram[y * width + x] += energy * (tExit - t);
+        if (last || tExit >= 1.0f) break;
+        t = tExit;
+        if (nextX < nextY) {
+            x += stepX;
+            nextX += deltaX;
+        } else {
+            y += stepY;
+            nextY += deltaY;
+        }
+        if (x < 0 || y < 0 || x >= width || y >= height) break;
+    }
+}
+
+void RadianceGrid::reduce() {
+    // Rows are disjoint, so threads can share the work without atomics
+    parallelFor(static_cast<size_t>(height), 16, [&](size_t row) {
+        float* target = &accumulated[row * width];
+        for (std::vector<float>& histogram : histograms) {
+            float* source = &histogram[row * width];
+            for (int x = 0; x < width; x++) {
+                target[x] += source[x];
+                source[x] = 0.0f;
+            }
+        }
+    });
+}
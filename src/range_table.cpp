@@ -0,0 +1,325 @@
+#include "range_table.h"
+#include "byte_stream.h"
+#include "job_system.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+const char TABLE_MAGIC[4] = { 'P', 'V', 'R', 'T' };
+constexpr uint32_t TABLE_VERSION = 1;
+constexpr size_t ROWS_PER_TASK = 8;     // a task writes these rows of every table
+
+FILE* createFile(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) throw std::runtime_error("Failed to create file: " + path);
+    return file;
+}
+
+void finishFile(FILE* file, const std::string& path) {
+    bool failed = ferror(file) != 0;
+    failed |= fclose(file) != 0;
+    if (failed) throw std::runtime_error("Failed to write file: " + path);
+}
+
+// Dark blue through green to yellow
+void heatColor(float t, uint8_t* rgb) {
+    static const float stops[5][3] = {
+        { 0.05f, 0.03f, 0.30f }, { 0.15f, 0.35f, 0.60f }, { 0.15f, 0.65f, 0.50f },
+        { 0.60f, 0.85f, 0.25f }, { 1.00f, 0.95f, 0.20f },
+    };
+    t = std::min(std::max(t, 0.0f), 1.0f) * 4.0f;
+    int i = std::min(static_cast<int>(t), 3);
+    float f = t - i;
+    for (int c = 0; c < 3; c++) {
+        rgb[c] = static_cast<uint8_t>(255.0f * (stops[i][c] + (stops[i + 1][c] - stops[i][c]) * f));
+    }
+}
+
+}
+
+void RangeTable::build(const BallisticsModel& tableModel, int angles, int speeds,
+                       float firstAngle, float lastAngle, float firstSpeed, float lastSpeed) {
+    if (angles < 2 || speeds < 2) throw std::runtime_error("A range table needs at least 2x2 shots");
+    model = tableModel;
+    angleCount = angles;
+    speedCount = speeds;
+    angleMin = firstAngle;
+    angleMax = lastAngle;
+    speedMin = firstSpeed;
+    speedMax = lastSpeed;
+
+    size_t cells = static_cast<size_t>(angleCount) * speedCount;
+    ranges.resize(cells);
+    apexes.resize(cells);
+    times.resize(cells);
+    auto fly = [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            float angle = angleAt(static_cast<int>(row));
+            size_t base = row * speedCount;
+            for (int column = 0; column < speedCount; column++) {
+                Flight flight = flyToGround(model, angle, speedAt(column));
+                if (!flight.landed) {
+                    flight.range = flight.apex = flight.time = NAN;
+                }
+                ranges[base + column] = flight.range;
+                apexes[base + column] = flight.apex;
+                times[base + column] = flight.time;
+            }
+        }
+    };
+    TaskGroup group;
+    JobSystem::get()->run(group, fly, 0, angleCount, ROWS_PER_TASK);
+    JobSystem::get()->wait(group);
+    countUnlanded();
+}
+
+void RangeTable::countUnlanded() {
+    unlanded = std::count_if(ranges.begin(), ranges.end(), [](float range) { return std::isnan(range); });
+}
+
+void RangeTable::save(const std::string& path) const {
+    std::vector<uint8_t> header;
+    ByteWriter writer(header);
+    writer.putBytes(TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    writer.putU32(TABLE_VERSION);
+    writer.putU32(static_cast<uint32_t>(angleCount));
+    writer.putU32(static_cast<uint32_t>(speedCount));
+    writer.putFloat(angleMin);
+    writer.putFloat(angleMax);
+    writer.putFloat(speedMin);
+    writer.putFloat(speedMax);
+    writer.putFloat(model.gravity);
+    writer.putFloat(model.drag);
+    writer.putFloat(model.wind);
+
+    FILE* file = createFile(path);
+    fwrite(header.data(), 1, header.size(), file);
+    for (const std::vector<float>* table : { &ranges, &apexes, &times }) {
+        fwrite(table->data(), sizeof(float), table->size(), file);
+    }
+    finishFile(file, path);
+}
+
+void RangeTable::load(const std::string& path) {
+    MappedFile file;
+    file.open(path);
+    ByteReader reader(file.data(), file.size());
+    if (file.size() < sizeof(TABLE_MAGIC) || memcmp(reader.getBytes(sizeof(TABLE_MAGIC)), TABLE_MAGIC, sizeof(TABLE_MAGIC)) != 0) {
+        throw std::runtime_error("Not a range table: " + path);
+    }
+    if (reader.getU32() != TABLE_VERSION) throw std::runtime_error("Unsupported range table version: " + path);
+    uint32_t angles = reader.getU32(), speeds = reader.getU32();
+    if (angles < 2 || speeds < 2) throw std::runtime_error("Malformed range table: " + path);
+
+    angleCount = static_cast<int>(angles);
+    speedCount = static_cast<int>(speeds);
+    angleMin = reader.getFloat();
+    angleMax = reader.getFloat();
+    speedMin = reader.getFloat();
+    speedMax = reader.getFloat();
+    model.gravity = reader.getFloat();
+    model.drag = reader.getFloat();
+    model.wind = reader.getFloat();
+
+    size_t cells = static_cast<size_t>(angles) * speeds;
+    if (reader.remaining() / 3 / sizeof(float) < cells) throw std::runtime_error("Truncated range table: " + path);
+    for (std::vector<float>* table : { &ranges, &apexes, &times }) {
+        table->resize(cells);
+        memcpy(table->data(), reader.getBytes(cells * sizeof(float)), cells * sizeof(float));
+    }
+    countUnlanded();
+}
+
+void RangeTable::writeCsv(const std::string& path) const {
+    // Each task formats its band of rows, and the bands go out in order
+    size_t taskCount = (angleCount + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    std::vector<std::string> text(taskCount);
+    auto format = [&](size_t begin, size_t end) {
+        char line[128];
+        for (size_t task = begin; task < end; task++) {
+            size_t lastRow = std::min<size_t>(angleCount, (task + 1) * ROWS_PER_TASK);
+            for (size_t row = task * ROWS_PER_TASK; row < lastRow; row++) {
+                for (int column = 0; column < speedCount; column++) {
+                    size_t cell = row * speedCount + column;
+                    int length = snprintf(line, sizeof(line), "%g,%g,%g,%g,%g\n",
+                                          angleAt(static_cast<int>(row)), speedAt(column),
+                                          ranges[cell], apexes[cell], times[cell]);
+                    text[task].append(line, std::min<size_t>(std::max(length, 0), sizeof(line) - 1));
+                }
+            }
+        }
+    };
+    TaskGroup group;
+    JobSystem::get()->run(group, format, 0, taskCount, 1);
+    JobSystem::get()->wait(group);
+
+    FILE* file = createFile(path);
+    fputs("angle,speed,range,apex,flight_time\n", file);
+    for (std::string& band : text) {
+        fwrite(band.data(), 1, band.size(), file);
+        std::string().swap(band);
+    }
+    finishFile(file, path);
+}
+
+void RangeTable::writeHeatmap(const std::string& path) const {
+    float longest = 1e-6f;
+    for (float range : ranges) longest = std::max(longest, range);
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(angleCount) * speedCount * 3);
+    auto shade = [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            const float* row = &ranges[(angleCount - 1 - y) * static_cast<size_t>(speedCount)];
+            uint8_t* out = &pixels[y * speedCount * 3];
+            // Shots that never landed show as the shortest range
+            for (int x = 0; x < speedCount; x++) heatColor(std::isnan(row[x]) ? 0.0f : row[x] / longest, out + 3 * x);
+        }
+    };
+    TaskGroup group;
+    JobSystem::get()->run(group, shade, 0, angleCount, ROWS_PER_TASK);
+    JobSystem::get()->wait(group);
+
+    FILE* file = createFile(path);
+    fprintf(file, "P6\n%d %d\n255\n", speedCount, angleCount);
+    fwrite(pixels.data(), 1, pixels.size(), file);
+    finishFile(file, path);
+}
+
+Flight RangeTable::sample(float angle, float speed, Interpolation interpolation) const {
+    // Grid coordinates, clamped so the base cell always has a neighbour
+    float u = (angle - angleMin) / (angleMax - angleMin) * (angleCount - 1);
+    float v = (speed - speedMin) / (speedMax - speedMin) * (speedCount - 1);
+    u = std::min(std::max(u, 0.0f), static_cast<float>(angleCount - 1));
+    v = std::min(std::max(v, 0.0f), static_cast<float>(speedCount - 1));
+    int row = std::min(static_cast<int>(u), angleCount - 2);
+    int column = std::min(static_cast<int>(v), speedCount - 2);
+    float tu = u - row, tv = v - column;
+
+    int rows[4], columns[4];
+    float rowWeights[4], columnWeights[4];
+    int taps;
+    if (interpolation == Bilinear) {
+        taps = 2;
+        rows[0] = row;
+        rows[1] = row + 1;
+        columns[0] = column;
+        columns[1] = column + 1;
+        rowWeights[0] = 1.0f - tu;
+        rowWeights[1] = tu;
+        columnWeights[0] = 1.0f - tv;
+        columnWeights[1] = tv;
+    } else {
+        taps = 4;
+        auto catmullRom = [](float t, float* w) {
+            w[0] = 0.5f * ((-t + 2.0f) * t - 1.0f) * t;
+            w[1] = 0.5f * ((3.0f * t - 5.0f) * t * t + 2.0f);
+            w[2] = 0.5f * ((-3.0f * t + 4.0f) * t + 1.0f) * t;
+            w[3] = 0.5f * (t - 1.0f) * t * t;
+        };
+        // Past an edge the grid is extended linearly (f[-1] = 2 f[0] - f[1]),
+        // which folds the outer tap's weight onto the two edge samples
+        auto taps4 = [&catmullRom](float t, int first, int count, int* index, float* w) {
+            catmullRom(t, w);
+            for (int i = 0; i < 4; i++) index[i] = first - 1 + i;
+            if (index[0] < 0) {
+                index[0] = first + 1;
+                w[1] += 2.0f * w[0];
+                w[0] = -w[0];
+            }
+            if (index[3] > count - 1) {
+                index[3] = first;
+                w[2] += 2.0f * w[3];
+                w[3] = -w[3];
+            }
+        };
+        taps4(tu, row, angleCount, rows, rowWeights);
+        taps4(tv, column, speedCount, columns, columnWeights);
+    }
+
+    Flight flight;
+    for (int i = 0; i < taps; i++) {
+        size_t base = static_cast<size_t>(rows[i]) * speedCount;
+        for (int j = 0; j < taps; j++) {
+            float weight = rowWeights[i] * columnWeights[j];
+            size_t cell = base + columns[j];
+            flight.range += weight * ranges[cell];
+            flight.apex += weight * apexes[cell];
+            flight.time += weight * times[cell];
+        }
+    }
+    flight.landed = !std::isnan(flight.range);
+    return flight;
+}
+
+std::string RangeTableCache::pathFor(const BallisticsModel& model) const {
+    uint32_t bits[3];
+    memcpy(&bits[0], &model.gravity, 4);
+    memcpy(&bits[1], &model.drag, 4);
+    memcpy(&bits[2], &model.wind, 4);
+    char name[80];
+    snprintf(name, sizeof(name), "range_%08x_%08x_%08x_%d.pvrt", bits[0], bits[1], bits[2], resolution);
+    return directory + "/" + name;
+}
+
+const RangeTable& RangeTableCache::get(const BallisticsModel& model) {
+    for (const std::unique_ptr<RangeTable>& table : tables) {
+        const BallisticsModel& other = table->getModel();
+        if (other.gravity == model.gravity && other.drag == model.drag && other.wind == model.wind) {
+            return *table;
+        }
+    }
+
+    std::unique_ptr<RangeTable> table(new RangeTable());
+    std::string path = pathFor(model);
+    try {
+        table->load(path);
+    } catch (const std::runtime_error&) {
+        // Missing or unreadable: fly it now. Failing to save only costs
+        // the same rebuild next run, so that is not an error.
+        // A table with shots that never landed is not worth keeping.
+        table->build(model, resolution, resolution);
+        try {
+            if (table->getUnlandedCount() == 0) table->save(path);
+        } catch (const std::runtime_error&) {
+        }
+    }
+    tables.push_back(std::move(table));
+    return *tables.back();
+}
+
+int runRangeTable(const RangeTableJob& job) {
+    typedef std::chrono::steady_clock Clock;
+    auto seconds = [](Clock::time_point from) {
+        return std::chrono::duration<double>(Clock::now() - from).count();
+    };
+
+    try {
+        Clock::time_point start = Clock::now();
+        RangeTable table;
+        table.build(job.model, job.angleCount, job.speedCount);
+        std::cerr << "Flew " << job.angleCount << "x" << job.speedCount << " shots on "
+                  << JobSystem::get()->getThreadCount() << " threads in " << seconds(start) << " s" << std::endl;
+        if (table.getUnlandedCount()) {
+            std::cerr << table.getUnlandedCount() << " shots had not landed after the step cap; "
+                      << "they are NaN in the tables" << std::endl;
+        }
+
+        start = Clock::now();
+        table.save(job.path);
+        if (!job.csvPath.empty()) table.writeCsv(job.csvPath);
+        if (!job.heatmapPath.empty()) table.writeHeatmap(job.heatmapPath);
+        std::cerr << "Wrote tables in " << seconds(start) << " s" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Range table failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,94 @@
+#include "ray_tree.h"
+#include <cmath>
+
+void fresnelReflectance(float n1, float n2, float cosI, float cosT, float& rs, float& rp) {
+    float s = (n1 * cosI - n2 * cosT) / (n1 * cosI + n2 * cosT);
+    float p = (n1 * cosT - n2 * cosI) / (n1 * cosT + n2 * cosI);
+    rs = s * s;
+    rp = p * p;
+}
+
+namespace {
+// Depth-first so the recursion never goes deeper than maxDepth
+size_t traceNode(const OpticalScene& scene, int nodeIndex, const FresnelSettings& settings,
+                 RayNodePool& pool) {
+    size_t tests = 0;
+    RayTreeNode& node = pool[nodeIndex];
+    OpticalHit hit;
+    if (!scene.intersect(node.origin, node.direction, OpticalScene::ESCAPE_DISTANCE, hit, &tests)) {
+        node.length = OpticalScene::ESCAPE_DISTANCE;
+        return tests;
+    }
+    node.length = hit.t;
+    if (node.depth >= settings.maxDepth) return tests;
+
+    // Copy what we need before allocating children
+    glm::vec2 direction = node.direction;
+    float intensityS = node.intensityS;
+    float intensityP = node.intensityP;
+    int depth = node.depth;
+
+    const OpticalPrimitive& prim = scene.getPrimitives()[hit.primitive];
+    glm::vec2 normal = hit.normal;
+    float fromIndex = scene.getMaterials()[prim.frontMaterial].index;
+    float toIndex = scene.getMaterials()[prim.backMaterial].index;
+    if (glm::dot(direction, normal) > 0.0f) {
+        normal = -normal;
+        std::swap(fromIndex, toIndex);
+    }
+
+    float eta = fromIndex / toIndex;
+    float cosI = -glm::dot(direction, normal);
+    float sinT2 = eta * eta * (1.0f - cosI * cosI);
+    float rs = 1.0f, rp = 1.0f;  // total internal reflection unless proven otherwise
+    glm::vec2 transmitted(0.0f);
+    if (sinT2 <= 1.0f) {
+        float cosT = sqrtf(1.0f - sinT2);
+        fresnelReflectance(fromIndex, toIndex, cosI, cosT, rs, rp);
+        transmitted = glm::normalize(eta * direction + (eta * cosI - cosT) * normal);
+    }
+    glm::vec2 reflected = glm::normalize(direction + 2.0f * cosI * normal);
+
+    struct Child {
+        glm::vec2 direction;
+        float intensityS, intensityP;
+    } children[2] = {
+        { transmitted, intensityS * (1.0f - rs), intensityP * (1.0f - rp) },
+        { reflected, intensityS * rs, intensityP * rp }
+    };
+
+    for (const Child& child : children) {
+        if (child.intensityS + child.intensityP < settings.intensityCutoff) continue;
+        int childIndex = pool.allocate();
+        if (childIndex < 0) return tests;
+
+        RayTreeNode& childNode = pool[childIndex];
+        childNode.origin = hit.point;
+        childNode.direction = child.direction;
+        childNode.length = 0.0f;
+        childNode.intensityS = child.intensityS;
+        childNode.intensityP = child.intensityP;
+        childNode.parent = nodeIndex;
+        childNode.depth = depth + 1;
+        tests += traceNode(scene, childIndex, settings, pool);
+    }
+    return tests;
+}
+}
+
+size_t traceFresnelTree(const OpticalScene& scene, const glm::vec2& origin,
+                        const glm::vec2& direction, float intensityS, float intensityP,
+                        const FresnelSettings& settings, RayNodePool& pool) {
+    int root = pool.allocate();
+    if (root < 0) return 0;
+
+    RayTreeNode& node = pool[root];
+    node.origin = origin;
+    node.direction = glm::normalize(direction);
+    node.length = 0.0f;
+    node.intensityS = intensityS;
+    node.intensityP = intensityP;
+    node.parent = -1;
+    node.depth = 0;
+    return traceNode(scene, root, settings, pool);
+}
@@ -2,81 +2,389 @@
 
 #include "refraction_simulation.h"
 #include "shader_utils.h"
+#include "render_backend.h"
+#include "parallel.h"
+#include "frame_arena.h"
+#include "alloc_tracker.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include "imgui/include/imgui.h"
+#include <algorithm>
+#include <cstddef>
 
 constexpr auto VERTEX_SHADER_PATH = "../shaders/refraction.vert";
 constexpr auto FRAGMENT_SHADER_PATH = "../shaders/refraction.frag";
+constexpr auto CAUSTIC_VERTEX_SHADER_PATH = "../shaders/caustic.vert";
+constexpr auto CAUSTIC_FRAGMENT_SHADER_PATH = "../shaders/caustic.frag";
+constexpr auto RAY_RECORD_SHADER_PATH = "../shaders/ray_records.vert";
+
+// World-space view of the scene; the caustic grid covers exactly this
+constexpr float VIEW_LEFT = -15.0f, VIEW_RIGHT = 15.0f, VIEW_BOTTOM = -5.0f, VIEW_TOP = 25.0f;
 
 void RefractionSimulation:: init(){
     // setup shaders
     shaderProgram = ShaderUtils::make_shader(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+    rayProgram = ShaderUtils::make_shader(RAY_RECORD_SHADER_PATH, FRAGMENT_SHADER_PATH);
 
     // config opengl buffers
     setupBuffers();  // for base class VAO, VBO
+    setupRayBuffers();
+    if (gpuTracer.init()) {
+        rendererName = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    }
     setupInterfaceBuffers(); // for interface VAO,VBO
+    setupCausticBuffers();
 
     // initialize
     resetSimulation();
 }
 
-void RefractionSimulation:: setupInterfaceBuffers(){
-        interfacePoints = {
-        glm::vec2(-10.0f, 0.0f),
-        glm::vec2(10.0f, 0.0f)
+void RefractionSimulation::setupRayBuffers() {
+    // Ray records are instance data; the vertices come from gl_VertexID
+    rayRecordVBO = RenderBackend::createBuffer();
+    for (GLuint* vao : { &rayRecordVAO, &refractedRecordVAO }) {
+        *vao = RenderBackend::createVertexArray();
+        RenderBackend::bindVertexArray(*vao);
+        for (GLuint attribute = 0; attribute < 4; attribute++) {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 1);
+        }
+    }
+    pointRayRecords(rayRecordVAO, 0);
+    pointRayRecords(refractedRecordVAO, 0);
+
+    // Gradient-index paths carry (x, y, intensity) per vertex
+    RenderBackend::bindVertexArray(VAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    RenderBackend::bindVertexArray(0);
+
+    // Spectral rays add an RGB tint per vertex: (x, y, intensity, r, g, b)
+    spectralVAO = RenderBackend::createVertexArray();
+    spectralVBO = RenderBackend::createBuffer();
+    RenderBackend::bindVertexArray(spectralVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, spectralVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    RenderBackend::bindVertexArray(0);
+}
+
+void RefractionSimulation::pointRayRecords(GLuint vertexArray, size_t first) {
+    // GL 3.3 has no base instance, so the pointers start at the first record
+    RenderBackend::bindVertexArray(vertexArray);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, rayRecordVBO);
+    const char* base = reinterpret_cast<const char*>(first * sizeof(RayRecord));
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(RayRecord), base + offsetof(RayRecord, originX));
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(RayRecord), base + offsetof(RayRecord, directionX));
+    glVertexAttribPointer(2, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(RayRecord), base + offsetof(RayRecord, length));
+    glVertexAttribPointer(3, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(RayRecord), base + offsetof(RayRecord, intensity));
+}
+
+void RefractionSimulation::updateMaterials() {
+    // Dispersive presets drive the scalar index too, so the sliders and the
+    // critical angle follow the chosen material at the reference wavelength
+    OpticalMaterial& medium1 = scene.getMaterial(outsideMaterial);
+    medium1.dispersion = dispersionPreset(static_cast<DispersionPreset>(medium1Preset), n1);
+    medium1.index = medium1.dispersion.indexAt(WAVELENGTH_REFERENCE);
+    n1 = medium1.index;
+
+    OpticalMaterial& medium2 = scene.getMaterial(glassMaterial);
+    medium2.dispersion = dispersionPreset(static_cast<DispersionPreset>(medium2Preset), n2);
+    medium2.index = medium2.dispersion.indexAt(WAVELENGTH_REFERENCE);
+    n2 = medium2.index;
+}
+
+void RefractionSimulation::setupCausticBuffers() {
+    causticProgram = ShaderUtils::make_shader(CAUSTIC_VERTEX_SHADER_PATH, CAUSTIC_FRAGMENT_SHADER_PATH);
+
+    Aabb2D bounds;
+    bounds.grow(glm::vec2(VIEW_LEFT, VIEW_BOTTOM));
+    bounds.grow(glm::vec2(VIEW_RIGHT, VIEW_TOP));
+    int workerCount = jobSystem().getThreadCount();
+    radiance.resize(CAUSTIC_RESOLUTION, CAUSTIC_RESOLUTION, bounds, workerCount);
+    causticWorkers.resize(workerCount);
+    for (int w = 0; w < workerCount; w++) {
+        causticWorkers[w].random.seed(w + 1);
+    }
+
+    // One quad over the view, (x, y, u, v) per corner
+    float quad[] = {
+        VIEW_LEFT,  VIEW_BOTTOM, 0.0f, 0.0f,
+        VIEW_RIGHT, VIEW_BOTTOM, 1.0f, 0.0f,
+        VIEW_LEFT,  VIEW_TOP,    0.0f, 1.0f,
+        VIEW_RIGHT, VIEW_TOP,    1.0f, 1.0f,
     };
+    causticVAO = RenderBackend::createVertexArray();
+    causticVBO = RenderBackend::createBuffer();
+    RenderBackend::bufferData(causticVBO, sizeof(quad), quad, GL_STATIC_DRAW);
+    RenderBackend::vertexAttribute(causticVAO, 0, causticVBO, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    RenderBackend::vertexAttribute(causticVAO, 1, causticVBO, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                                   2 * sizeof(float));
 
-        glGenVertexArrays(1, &interfaceVAO);
-    glGenBuffers(1, &interfaceVBO);
+    // Row 0 of the grid is the bottom of the view, as texture rows are
+    glGenTextures(1, &causticTexture);
+    glBindTexture(GL_TEXTURE_2D, causticTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, CAUSTIC_RESOLUTION, CAUSTIC_RESOLUTION, 0,
+                 GL_RED, GL_FLOAT, radiance.getAccumulated().data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void RefractionSimulation::resetCaustics() {
+    radiance.clear();
+    causticRays = 0;
+}
+
+void RefractionSimulation::accumulateCaustics() {
+    // Every worker traces its share of the batch at random points across
+    // the beam and splats the segments into its own histogram
+    float angleRadians = glm::radians(incidentAngle);
+    glm::vec2 direction(sin(angleRadians), -cos(angleRadians));
+    glm::vec2 across(-direction.y, direction.x);
+    float sFraction = sPolarizedFraction();
+    size_t batch = std::min<size_t>(causticRaysPerFrame, causticRayTarget - causticRays);
+    size_t workerCount = causticWorkers.size();
+
+    // Trace on every worker, then merge the histograms as the group's
+    // continuation, which itself fans the rows out over the pool
+    auto trace = [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; w++) {
+            CausticWorker& worker = causticWorkers[w];
+            std::uniform_real_distribution<float> offset(-0.5f * beamWidth, 0.5f * beamWidth);
+            for (size_t i = batch * w / workerCount; i < batch * (w + 1) / workerCount; i++) {
+                glm::vec2 origin = sourcePosition + across * offset(worker.random);
+                if (indexField) {
+                    traceGrinRay(*indexField, origin, direction, grinSettings, worker.path);
+                    for (size_t p = 1; p < worker.path.points.size(); p++) {
+                        radiance.splat(w, worker.path.points[p - 1], worker.path.points[p], 1.0f);
+                    }
+                    continue;
+                }
+                worker.pool.reset();
+                traceFresnelTree(scene, origin, direction, sFraction, 1.0f - sFraction, fresnel, worker.pool);
+                for (size_t n = 0; n < worker.pool.size(); n++) {
+                    const RayTreeNode& node = worker.pool[static_cast<int>(n)];
+                    radiance.splat(w, node.origin, node.origin + node.direction * node.length,
+                                   node.intensity());
+                }
+            }
+        }
+    };
+    auto reduce = [&]() { radiance.reduce(); };
+    TaskGroup group;
+    jobSystem().run(group, trace, 0, workerCount, 1);
+    jobSystem().then(group, reduce);
+    jobSystem().wait(group);
+    causticRays += batch;
+
+    glBindTexture(GL_TEXTURE_2D, causticTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, radiance.getWidth(), radiance.getHeight(),
+                    GL_RED, GL_FLOAT, radiance.getAccumulated().data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void RefractionSimulation:: setupInterfaceBuffers(){
+        interfaceVAO = RenderBackend::createVertexArray();
+    interfaceVBO = RenderBackend::createBuffer();
     
-    glBindVertexArray(interfaceVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, interfaceVBO);
-    glBufferData(GL_ARRAY_BUFFER, interfacePoints.size() * sizeof(glm::vec2),
-                interfacePoints.data(), GL_STATIC_DRAW);
+    RenderBackend::bindVertexArray(interfaceVAO);
+    RenderBackend::bindBuffer(GL_ARRAY_BUFFER, interfaceVBO);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
     glEnableVertexAttribArray(0);
+
+    loadPreset(scenePreset);
+}
+
+void RefractionSimulation::loadPreset(int preset) {
+    scenePreset = preset;
+    scene.clear();
+    indexField.reset();
+    interfacePoints.clear();
+    outsideMaterial = scene.addMaterial("Medium 1", n1);
+    glassMaterial = scene.addMaterial("Medium 2", n2);
+
+    switch (preset) {
+        case FlatInterface:
+            // The classic single boundary at y = 0, medium 1 above
+            scene.addSegment(glm::vec2(10.0f, 0.0f), glm::vec2(-10.0f, 0.0f),
+                             outsideMaterial, glassMaterial);
+            sourcePosition = glm::vec2(0.0f, 5.0f);
+            incidentAngle = 45.0f;
+            rayCount = 1;
+            beamWidth = 2.0f;
+            break;
+        case ConvexLens:
+            scene.addBiconvexLens(glm::vec2(0.0f, 10.0f), 8.0f, 2.0f, glassMaterial, outsideMaterial);
+            sourcePosition = glm::vec2(-12.0f, 10.0f);
+            incidentAngle = 90.0f;
+            rayCount = 15;
+            beamWidth = 6.0f;
+            break;
+        case Prism:
+            scene.addPrism(glm::vec2(0.0f, 10.0f), 6.0f, 0.0f, glassMaterial, outsideMaterial);
+            sourcePosition = glm::vec2(-12.0f, 11.5f);
+            incidentAngle = 80.0f;
+            rayCount = 5;
+            beamWidth = 0.5f;
+            break;
+        case GlassSlab:
+            scene.addSlab(glm::vec2(0.0f, 8.0f), glm::vec2(14.0f, 3.0f), glassMaterial, outsideMaterial);
+            sourcePosition = glm::vec2(-8.0f, 16.0f);
+            incidentAngle = 40.0f;
+            rayCount = 1;
+            beamWidth = 2.0f;
+            break;
+        case PrismField:
+            // Thousands of small prisms to exercise the BVH
+            for (int row = 0; row < 40; row++) {
+                for (int col = 0; col < 60; col++) {
+                    glm::vec2 center(-12.0f + col * 0.4f, 2.0f + row * 0.5f);
+                    scene.addPrism(center, 0.3f, 0.3f * (row + col), glassMaterial, outsideMaterial);
+                }
+            }
+            sourcePosition = glm::vec2(-14.0f, 12.0f);
+            incidentAngle = 80.0f;
+            rayCount = 2048;
+            beamWidth = 16.0f;
+            break;
+        case Mirage: {
+            // Exaggerated: real road mirages differ by ~3e-4 in index
+            indexField.reset(new MirageField(1.0f, 1.03f, 1.0f));
+            grinSettings.bounds.min = glm::vec2(-15.0f, 0.0f);
+            grinSettings.bounds.max = glm::vec2(15.0f, 25.0f);
+            interfacePoints.push_back(glm::vec2(-15.0f, 0.0f));
+            interfacePoints.push_back(glm::vec2(15.0f, 0.0f));
+            sourcePosition = glm::vec2(-14.0f, 5.0f);
+            incidentAngle = 83.0f;
+            rayCount = 200;
+            beamWidth = 6.0f;
+            break;
+        }
+        case GradedFiber: {
+            const float axisY = 10.0f, coreRadius = 1.5f;
+            indexField.reset(new GradedFiberField(axisY, coreRadius, 1.5f, 0.1f));
+            grinSettings.bounds.min = glm::vec2(-15.0f, -5.0f);
+            grinSettings.bounds.max = glm::vec2(15.0f, 25.0f);
+            for (float side = -1.0f; side <= 1.0f; side += 2.0f) {
+                interfacePoints.push_back(glm::vec2(-15.0f, axisY + side * coreRadius));
+                interfacePoints.push_back(glm::vec2(15.0f, axisY + side * coreRadius));
+            }
+            sourcePosition = glm::vec2(-14.0f, axisY);
+            incidentAngle = 80.0f;
+            rayCount = 100;
+            beamWidth = 2.5f;
+            break;
+        }
+        case LuneburgLens: {
+            // n = sqrt(2 - (r/R)^2) brings a parallel beam to a focus on the
+            // far rim; sampled onto a grid to exercise the bilinear field
+            const glm::vec2 center(0.0f, 10.0f);
+            const float radius = 5.0f;
+            Aabb2D gridBounds;
+            gridBounds.grow(center - glm::vec2(radius + 1.0f));
+            gridBounds.grow(center + glm::vec2(radius + 1.0f));
+            GridIndexField* grid = new GridIndexField(gridBounds, 129, 129, 1.0f);
+            for (int y = 0; y < grid->getHeight(); y++) {
+                for (int x = 0; x < grid->getWidth(); x++) {
+                    float r = glm::length(grid->nodePosition(x, y) - center) / radius;
+                    grid->at(x, y) = r < 1.0f ? sqrtf(2.0f - r * r) : 1.0f;
+                }
+            }
+            indexField.reset(grid);
+            grinSettings.bounds.min = glm::vec2(-15.0f, -5.0f);
+            grinSettings.bounds.max = glm::vec2(15.0f, 25.0f);
+            scene.addArc(center, radius, 0.0f, glm::radians(360.0f), outsideMaterial, outsideMaterial);
+            sourcePosition = glm::vec2(-14.0f, 10.0f);
+            incidentAngle = 90.0f;
+            rayCount = 41;
+            beamWidth = 9.0f;
+            break;
+        }
+        default:
+            break;
+    }
+    scene.build();
+    gpuTracer.uploadScene(scene, 32);
+
+    // Scene outline only changes with the preset
+    scene.tessellate(interfacePoints, 32);
+    RenderBackend::bufferData(interfaceVBO, interfacePoints.size() * sizeof(glm::vec2),
+                              interfacePoints.data(), GL_STATIC_DRAW);
+
+    updateRays();
 }
 
 void RefractionSimulation::calculateRefraction() {
-            refractedRays.clear();
+            rayPool.reset();
+    spectralPool.reset();
     refractionAngle = 0.0f;  
     reflectionAngle = 0.0f; 
-    
+    hitIncidentAngle = 0.0f;
+    rayTests = 0;
+
+    updateMaterials();
+    if (indexField) {
+        traceGradientIndex();
+        return;
+    }
+
+    double traceStart = glfwGetTime();
+    tracedOnGpu = gpuTracing && gpuTracer.isAvailable() && !spectralMode;
+    if (tracedOnGpu) {
+        static_assert(sizeof(LightRay) == 5 * sizeof(float), "GPU tracer reads rays as 5 floats");
+        gpuTracer.trace(scene, reinterpret_cast<const float*>(incidentRays.data()),
+                        incidentRays.size(), fresnel, sPolarizedFraction());
+    }
     for (const auto& incident : incidentRays) {
- 
-    // Calculate where incident ray intersects with interface (y = 0)
-        // Using parametric line equation: origin + t * direction = intersection
-        // We know intersection.y = 0, so:
-        // origin.y + t * direction.y = 0
-        // t = -origin.y / direction.y
-    
-        float t = -incident.origin.y / incident.direction.y;
-        glm::vec2 intersectionPoint = incident.origin + t * incident.direction;
-        
-        float theta1 = glm::radians(incidentAngle);
-        float sinTheta2 = (n1 / n2) * sin(theta1);
-        
-        if (abs(sinTheta2) > 1.0f) {
-            // Total internal reflection
-            LightRay reflected;
-            reflected.origin = intersectionPoint;
-            reflected.direction = glm::reflect(incident.direction, glm::vec2(0.0f, 1.0f));
-            reflected.intensity = incident.intensity;
-            refractedRays.push_back(reflected);
-            reflectionAngle = 180.0f - incidentAngle;  // Store reflection angle
-            refractionAngle = -1.0f;  // Indicate total internal reflection
-        } else {
-            // Regular refraction
-            float theta2 = asin(sinTheta2);
-            LightRay refracted;
-            refracted.origin = intersectionPoint;
-            refracted.direction = glm::vec2(sin(theta2), -cos(theta2));
-            refracted.intensity = incident.intensity * 0.8f;
-            refractedRays.push_back(refracted);
-            refractionAngle = glm::degrees(theta2);  // Store refraction angle
-            reflectionAngle = -1.0f;  // Indicate no reflection
+        if (tracedOnGpu) break;
+        float intensityS = incident.intensity * sPolarizedFraction();
+        float intensityP = incident.intensity - intensityS;
+        if (spectralMode) {
+            rayTests += traceSpectralBeam(scene, incident.origin, incident.direction, intensityS, intensityP,
+                                          wavelengthCount, fresnel, spectralPool);
+            continue;
         }
-    
+        rayTests += traceFresnelTree(scene, incident.origin, incident.direction,
+                                     intensityS, intensityP, fresnel, rayPool);
+    }
+    traceMilliseconds = static_cast<float>((glfwGetTime() - traceStart) * 1000.0);
+
+    // Report the angles for the first ray at the first surface it meets
+    if (incidentRays.empty()) return;
+    const LightRay& first = incidentRays.front();
+    OpticalHit hit;
+    if (!scene.intersect(first.origin, first.direction, OpticalScene::ESCAPE_DISTANCE, hit)) {
+        refractionAngle = -1.0f;
+        return;
+    }
+
+    const OpticalPrimitive& prim = scene.getPrimitives()[hit.primitive];
+    float fromIndex = scene.getMaterials()[prim.frontMaterial].index;
+    float toIndex = scene.getMaterials()[prim.backMaterial].index;
+    float cosI = -glm::dot(first.direction, hit.normal);
+    if (cosI < 0.0f) {
+        cosI = -cosI;
+        std::swap(fromIndex, toIndex);
+    }
+    float theta1 = acos(glm::clamp(cosI, 0.0f, 1.0f));
+    hitIncidentAngle = glm::degrees(theta1);
+
+    float sinTheta2 = (fromIndex / toIndex) * sin(theta1);
+    if (abs(sinTheta2) > 1.0f) {
+        reflectionAngle = 180.0f - hitIncidentAngle;  // Store reflection angle
+        refractionAngle = -1.0f;  // Indicate total internal reflection
+    } else {
+        refractionAngle = glm::degrees(asin(sinTheta2));  // Store refraction angle
+        reflectionAngle = -1.0f;  // Indicate no reflection
     }
 }
        
@@ -84,90 +392,328 @@ void RefractionSimulation::calculateRefraction() {
 
 
 
-void RefractionSimulation::render(float deltaTime) {
-    if (simulationRunning) {
+float RefractionSimulation::sPolarizedFraction() const {
+    if (polarization == SPolarized) return 1.0f;
+    if (polarization == PPolarized) return 0.0f;
+    return 0.5f;
+}
+
+void RefractionSimulation::runBenchmark() {
+    // Same rays through each tracer. Segment counts differ (the GPU only
+    // follows one branch, packets trace 8 wavelengths), so compare rates.
+    const int RUNS = 5;
+    updateMaterials();
+
+    double start = glfwGetTime();
+    for (int run = 0; run < RUNS; run++) {
+        rayPool.reset();
+        for (const auto& incident : incidentRays) {
+            float intensityS = incident.intensity * sPolarizedFraction();
+            traceFresnelTree(scene, incident.origin, incident.direction, intensityS,
+                             incident.intensity - intensityS, fresnel, rayPool);
+        }
+    }
+    benchmark.treeMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0 / RUNS);
+    benchmark.treeSegments = rayPool.size();
+
+    // One SIMD packet of SPECTRAL_LANES wavelengths per ray
+    start = glfwGetTime();
+    for (int run = 0; run < RUNS; run++) {
+        spectralPool.reset();
+        for (const auto& incident : incidentRays) {
+            float intensityS = incident.intensity * sPolarizedFraction();
+            traceSpectralBeam(scene, incident.origin, incident.direction, intensityS,
+                              incident.intensity - intensityS, SPECTRAL_LANES, fresnel, spectralPool);
+        }
+    }
+    benchmark.packetMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0 / RUNS);
+    benchmark.packetSegments = spectralPool.size();
+
+    // trace() waits for the result, so wall time covers the whole round trip
+    benchmark.gpuMilliseconds = 0.0f;
+    benchmark.gpuSegments = 0;
+    if (gpuTracer.isAvailable()) {
+        glFinish();
+        start = glfwGetTime();
+        for (int run = 0; run < RUNS; run++) {
+            gpuTracer.trace(scene, reinterpret_cast<const float*>(incidentRays.data()),
+                            incidentRays.size(), fresnel, sPolarizedFraction());
+        }
+        benchmark.gpuMilliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0 / RUNS);
+        benchmark.gpuSegments = gpuTracer.getVertexCount() / 2;
+    }
+    benchmark.valid = true;
+
+    // Put back whatever the current mode draws
+    traceDirty = true;
+}
+
+void RefractionSimulation::traceGradientIndex() {
+    double traceStart = glfwGetTime();
+    grinSettings.maxLength = OpticalScene::ESCAPE_DISTANCE;
+    grinPaths.resize(incidentRays.size());
+    parallelFor(incidentRays.size(), 8, [&](size_t i) {
+        traceGrinRay(*indexField, incidentRays[i].origin, incidentRays[i].direction,
+                     grinSettings, grinPaths[i]);
+    });
+    traceMilliseconds = static_cast<float>((glfwGetTime() - traceStart) * 1000.0);
+
+    grinAcceptedSteps = 0;
+    grinRejectedSteps = 0;
+    for (const GrinPath& path : grinPaths) {
+        grinAcceptedSteps += path.acceptedSteps;
+        grinRejectedSteps += path.rejectedSteps;
+    }
+    hitIncidentAngle = 0.0f;
+    refractionAngle = -1.0f;
+}
+
+void RefractionSimulation::updateVertices() {
+    // Segments leaving the source first, then everything that was refracted
+    // or reflected. Everything here is uploaded straight away, so it is
+    // built in the frame arena.
+    auto unorm16 = [](float value) {
+        return static_cast<uint16_t>(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+    };
+    auto snorm16 = [](float value) {
+        return static_cast<int16_t>(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f + (value < 0.0f ? -0.5f : 0.5f));
+    };
+    FrameVector<RayRecord> rayRecords(rayPool.size());
+    size_t next = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < rayPool.size(); i++) {
+            const RayTreeNode& node = rayPool[static_cast<int>(i)];
+            if ((node.depth == 0) != (pass == 0)) continue;
+            RayRecord& record = rayRecords[next++];
+            record.originX = node.origin.x;
+            record.originY = node.origin.y;
+            record.directionX = snorm16(node.direction.x);
+            record.directionY = snorm16(node.direction.y);
+            record.length = unorm16(node.length / OpticalScene::ESCAPE_DISTANCE);
+            record.intensity = unorm16(node.intensity());
+        }
+        if (pass == 0) incidentRecordCount = next;
+    }
+
+    FrameVector<float> rayVertices;
+    if (indexField) {
+        size_t pathPoints = 0;
+        for (const GrinPath& path : grinPaths) pathPoints += path.points.size();
+        rayVertices.reserve(pathPoints * 6);
+        for (const GrinPath& path : grinPaths) {
+            for (size_t i = 1; i < path.points.size(); i++) {
+                const glm::vec2 ends[2] = { path.points[i - 1], path.points[i] };
+                for (const glm::vec2& point : ends) {
+                    rayVertices.push_back(point.x);
+                    rayVertices.push_back(point.y);
+                    rayVertices.push_back(1.0f);
+                }
+            }
+        }
+    }
+    rayVertexCount = rayVertices.size() / 3;
+
+    // Spectral segments: one line per wavelength sample. Each lane is tinted
+    // with its share of the white point and drawn additively, so lanes that
+    // travel together add back up to white.
+    FrameVector<float> spectralVertices;
+    if (spectralMode) {
+        float sampleCount = static_cast<float>(
+            (wavelengthCount + SPECTRAL_LANES - 1) / SPECTRAL_LANES * SPECTRAL_LANES);
+        spectralVertices.reserve(spectralPool.size() * 12);
+        for (size_t i = 0; i < spectralPool.size(); i++) {
+            const SpectralSegment& segment = spectralPool[static_cast<int>(i)];
+            glm::vec3 tint = wavelengthToRgb(segment.wavelength) / sampleCount;
+            float intensity = segment.intensity * sampleCount;
+            const glm::vec2 points[2] = { segment.start, segment.end };
+            for (const glm::vec2& point : points) {
+                spectralVertices.push_back(point.x);
+                spectralVertices.push_back(point.y);
+                spectralVertices.push_back(intensity);
+                spectralVertices.push_back(tint.r);
+                spectralVertices.push_back(tint.g);
+                spectralVertices.push_back(tint.b);
+            }
+        }
+    }
+
+    rayRecordCount = rayRecords.size();
+    spectralVertexCount = spectralVertices.size() / 6;
+    RenderBackend::bufferData(rayRecordVBO, rayRecords.size() * sizeof(RayRecord), rayRecords.data(), GL_DYNAMIC_DRAW);
+    pointRayRecords(refractedRecordVAO, incidentRecordCount);
+    RenderBackend::bufferData(VBO, rayVertices.size() * sizeof(float),
+                              rayVertices.data(), GL_DYNAMIC_DRAW);
+    RenderBackend::bufferData(spectralVBO, spectralVertices.size() * sizeof(float),
+                              spectralVertices.data(), GL_DYNAMIC_DRAW);
+}
+
+void RefractionSimulation::update(float /*deltaTime*/) {
+    // The UI asks for these; both touch GL, so they run here
+    if (pendingPreset >= 0) {
+        loadPreset(pendingPreset);
+        pendingPreset = -1;
+    }
+    if (benchmarkRequested) {
+        runBenchmark();
+        benchmarkRequested = false;
+    }
+
+    // Only re-trace when a parameter changed, and only rebuild vertices
+    // after a trace; an unchanged scene is just redrawn from the VBOs
+    if (traceDirty) {
         calculateRefraction();
+        traceDirty = false;
+        vertexDirty = true;
+        resetCaustics();
     }
-    
-    // Update vertex data for all rays
-    std::vector<float> vertices;
-    
-    // Add incident rays
-    for (const auto& ray : incidentRays) {
-        // Calculate intersection point with interface (y = 0)
-        float t = -ray.origin.y / ray.direction.y;
-        glm::vec2 intersectionPoint = ray.origin + t * ray.direction;
-        
-        // Add ray starting point
-        vertices.push_back(ray.origin.x);
-        vertices.push_back(ray.origin.y);
-        // Add intersection point as endpoint
-        vertices.push_back(intersectionPoint.x);
-        vertices.push_back(intersectionPoint.y);
+    if (vertexDirty) {
+        updateVertices();
+        vertexDirty = false;
     }
-    
-    // Add refracted rays
-    for (const auto& ray : refractedRays) {
-        vertices.push_back(ray.origin.x);
-        vertices.push_back(ray.origin.y);
-        // Use longer length for refracted ray to ensure it's visible
-        glm::vec2 endpoint = ray.origin + ray.direction * 10.0f;
-        vertices.push_back(endpoint.x);
-        vertices.push_back(endpoint.y);
+    if (showCaustics && causticRays < static_cast<size_t>(causticRayTarget)) {
+        accumulateCaustics();
     }
-    
-    // Rest of the render function remains the same...
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(shaderProgram);
-    
-    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLint colorLoc = glGetUniformLocation(shaderProgram, "color");
-    
-    glm::mat4 projection = glm::ortho(-15.0f, 15.0f, -5.0f, 25.0f, -1.0f, 1.0f);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &glm::mat4(1.0f)[0][0]);
-    
-    // Render interface line
-    glUniform3f(colorLoc, 1.0f, 1.0f, 1.0f);
-    glBindVertexArray(interfaceVAO);
-    glDrawArrays(GL_LINES, 0, 2);
-    
-    // Update and render rays
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-                vertices.data(), GL_DYNAMIC_DRAW);
-    
-    glBindVertexArray(VAO);
-    
-    // Draw incident rays (yellow)
-    glUniform3f(colorLoc, 1.0f, 1.0f, 0.0f);
-    glDrawArrays(GL_LINES, 0, incidentRays.size() * 2);
-    
-    // Draw refracted rays (cyan)
-    glUniform3f(colorLoc, 0.0f, 1.0f, 1.0f);
-    glDrawArrays(GL_LINES, incidentRays.size() * 2, refractedRays.size() * 2);
-    
+}
+
+void RefractionSimulation::render(CommandList& commands) {
+    // Room for every draw below, so recording them allocates nothing
+    commands.reserve(8, { causticProgram, shaderProgram, rayProgram });
+    {
+        AllocTracker::HotRegion hot;
+
+        commands.clearColor(glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+        glm::mat4 projection = glm::ortho(VIEW_LEFT, VIEW_RIGHT, VIEW_BOTTOM, VIEW_TOP, -1.0f, 1.0f);
+
+        // Caustics underneath everything else. A grid sum of N * cell^2 / beamWidth
+        // is what an unfocused beam leaves, so scale that to 1.
+        if (showCaustics && causticRays > 0) {
+            glm::vec2 cell = radiance.getCellSize();
+            float scale = causticExposure * std::max(beamWidth, cell.x) / (causticRays * cell.x * cell.y);
+            commands.setLayer(CausticLayer);
+            commands.useProgram(causticProgram);
+            commands.uniform("projection", projection);
+            commands.uniform("scale", scale);
+            commands.uniform("radiance", 0);
+            commands.bindTexture(causticTexture);
+            commands.bindVertexArray(causticVAO);
+            commands.drawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            commands.bindTexture(0);
+        }
+
+        commands.setLayer(LineLayer);
+        commands.useProgram(shaderProgram);
+        commands.uniform("projection", projection);
+        commands.uniform("model", glm::mat4(1.0f));
+
+        // Render scene interfaces (no intensity or tint attributes, so pin them to full)
+        commands.uniform("color", glm::vec3(1.0f, 1.0f, 1.0f));
+        commands.constantAttribute(1, glm::vec4(1.0f));
+        commands.constantAttribute(2, glm::vec4(1.0f));
+        commands.bindVertexArray(interfaceVAO);
+        commands.drawArrays(GL_LINES, 0, interfacePoints.size());
+
+        // Render rays: incident (yellow) and refracted or reflected (cyan)
+        // records, expanded by rayProgram
+        commands.useProgram(rayProgram);
+        commands.uniform("projection", projection);
+        commands.uniform("viewBounds", glm::vec4(VIEW_LEFT, VIEW_BOTTOM, VIEW_RIGHT, VIEW_TOP));
+        commands.uniform("maxLength", OpticalScene::ESCAPE_DISTANCE);
+        commands.uniform("lineWidth", rayWidth);
+        commands.uniform("viewportSize", glm::vec2(commands.getViewportWidth(), commands.getViewportHeight()));
+        GLenum rayMode = rayWidth > 0.0f ? GL_TRIANGLE_STRIP : GL_LINES;
+        GLsizei rayVerticesPerRecord = rayWidth > 0.0f ? 4 : 2;
+        commands.uniform("color", glm::vec3(1.0f, 1.0f, 0.0f));
+        commands.bindVertexArray(rayRecordVAO);
+        commands.drawArraysInstanced(rayMode, 0, rayVerticesPerRecord, static_cast<GLsizei>(incidentRecordCount));
+        if (rayRecordCount > incidentRecordCount) {
+            commands.uniform("color", glm::vec3(0.0f, 1.0f, 1.0f));
+            commands.bindVertexArray(refractedRecordVAO);
+            commands.drawArraysInstanced(rayMode, 0, rayVerticesPerRecord,
+                                         static_cast<GLsizei>(rayRecordCount - incidentRecordCount));
+        }
+
+        // Gradient-index paths (cyan)
+        commands.useProgram(shaderProgram);
+        commands.bindVertexArray(VAO);
+        commands.uniform("color", glm::vec3(0.0f, 1.0f, 1.0f));
+        commands.drawArrays(GL_LINES, 0, rayVertexCount);
+
+        if (tracedOnGpu) {
+            commands.bindVertexArray(gpuTracer.getVertexArray());
+            commands.drawArrays(GL_LINES, 0, gpuTracer.getVertexCount());
+        }
+
+        if (spectralMode) {
+            commands.setLayer(SpectralLayer);
+            commands.setBlend(CommandList::BlendAdditive);
+            commands.bindVertexArray(spectralVAO);
+            commands.uniform("color", glm::vec3(1.0f, 1.0f, 1.0f));
+            commands.drawArrays(GL_LINES, 0, spectralVertexCount);
+            commands.setBlend(CommandList::BlendAlpha);
+        }
+    }
+
     // ImGui controls
     ImGui::Begin("Refraction Controls");
     
     ImGui::TextColored(ImVec4(1,1,0,1), "SIMULATION PARAMETERS");
     ImGui::Separator();
+
+    const char* presetNames[PresetCount] = {
+        "Flat Interface", "Convex Lens", "Prism", "Glass Slab", "Prism Field",
+        "Mirage", "Graded-Index Fiber", "Luneburg Lens"
+    };
+    int preset = scenePreset;
+    if (ImGui::Combo("Scene", &preset, presetNames, PresetCount)) {
+        pendingPreset = preset;
+    }
     
     if (ImGui::SliderFloat("Incident Angle", &incidentAngle, 0.0f, 90.0f)) {
         updateRays();
     }
+    if (ImGui::SliderInt("Ray Count", &rayCount, 1, 4096)) {
+        updateRays();
+    }
+    if (ImGui::SliderFloat("Beam Width", &beamWidth, 0.0f, 20.0f)) {
+        updateRays();
+    }
+    traceDirty |= ImGui::SliderInt("Max Depth", &fresnel.maxDepth, 1, 24);
+    traceDirty |= ImGui::SliderFloat("Intensity Cutoff", &fresnel.intensityCutoff, 0.0001f, 0.2f, "%.4f",
+                       ImGuiSliderFlags_Logarithmic);
+    const char* polarizationNames[] = { "Unpolarized", "s-polarized", "p-polarized" };
+    traceDirty |= ImGui::Combo("Polarization", &polarization, polarizationNames, 3);
     
-    ImGui::SliderFloat("n1 (Medium 1)", &n1, 1.0f, 2.0f);
-    ImGui::SliderFloat("n2 (Medium 2)", &n2, 1.0f, 2.0f);
+    // Material presets; the constant-index sliders only apply to "Custom"
+    const char* materialNames[static_cast<int>(DispersionPreset::Count)];
+    for (int i = 0; i < static_cast<int>(DispersionPreset::Count); i++) {
+        materialNames[i] = dispersionPresetName(static_cast<DispersionPreset>(i));
+    }
+    traceDirty |= ImGui::Combo("Medium 1", &medium1Preset, materialNames, static_cast<int>(DispersionPreset::Count));
+    if (medium1Preset == static_cast<int>(DispersionPreset::Custom)) {
+        traceDirty |= ImGui::SliderFloat("n1 (Medium 1)", &n1, 1.0f, 2.0f);
+    } else {
+        ImGui::Text("n1 = %.4f at %.1f nm", n1, WAVELENGTH_REFERENCE);
+    }
+    traceDirty |= ImGui::Combo("Medium 2", &medium2Preset, materialNames, static_cast<int>(DispersionPreset::Count));
+    if (medium2Preset == static_cast<int>(DispersionPreset::Custom)) {
+        traceDirty |= ImGui::SliderFloat("n2 (Medium 2)", &n2, 1.0f, 2.0f);
+    } else {
+        ImGui::Text("n2 = %.4f at %.1f nm", n2, WAVELENGTH_REFERENCE);
+    }
 
-    ImGui::TextColored(ImVec4(1,1,0,1),"Angle of incidence: %1f", incidentAngle);
+    traceDirty |= ImGui::Checkbox("Spectral Dispersion", &spectralMode);
+    if (spectralMode) {
+        traceDirty |= ImGui::SliderInt("Wavelength Samples", &wavelengthCount, SPECTRAL_LANES, 128);
+        ImGui::Text("Traced as %d packets of %d wavelengths",
+                    (wavelengthCount + SPECTRAL_LANES - 1) / SPECTRAL_LANES, SPECTRAL_LANES);
+    }
+
+    ImGui::TextColored(ImVec4(1,1,0,1),"Angle of incidence: %1f", hitIncidentAngle);
     
       if (refractionAngle >= 0) {
         ImGui::TextColored(ImVec4(0.0f, 1.0f, 1.0f, 1.0f), "Angle of refraction: %.1f°", refractionAngle);
     } else {
-        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Total Internal Reflection: %.1f°", incidentAngle);
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Total Internal Reflection: %.1f°", hitIncidentAngle);
     }
     
     if (ImGui::Button("Reset Simulation")) {
@@ -179,6 +725,67 @@ void RefractionSimulation::render(float deltaTime) {
         criticalAngle = calculateCriticalAngle();
         ImGui::Text("Critical Angle: %.2f degrees", criticalAngle);
     }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::TextColored(ImVec4(1,1,0,1), "TRACING STATISTICS");
+    ImGui::Text("Primitives: %zu (BVH nodes: %zu)", scene.primitiveCount(), scene.bvhNodeCount());
+    ImGui::Text("Ray tree nodes: %zu / %zu (peak %zu)", rayPool.size(), rayPool.capacity(),
+                rayPool.getHighWaterMark());
+    if (spectralMode) {
+        ImGui::Text("Spectral segments: %zu / %zu", spectralPool.size(), spectralPool.capacity());
+    }
+    if (rayPool.wasExhausted() || spectralPool.wasExhausted()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Ray pool full, trees were truncated");
+    }
+    ImGui::Text("Ray/primitive tests: %zu", rayTests);
+    ImGui::SliderFloat("Ray Width (px)", &rayWidth, 0.0f, 6.0f, rayWidth > 0.0f ? "%.1f" : "hairline");
+    ImGui::Text("Ray upload: %.1f KB as records (%.1f KB as %s vertices)",
+                rayRecordCount * sizeof(RayRecord) / 1024.0,
+                rayRecordCount * (rayWidth > 0.0f ? 4 : 2) * 3 * sizeof(float) / 1024.0,
+                rayWidth > 0.0f ? "quad" : "line");
+    if (gpuTracer.isAvailable()) {
+        traceDirty |= ImGui::Checkbox("GPU Tracing (transform feedback)", &gpuTracing);
+    } else {
+        ImGui::TextDisabled("GPU tracing unavailable");
+    }
+    if (ImGui::Button("Benchmark CPU vs GPU")) {
+        benchmarkRequested = true;
+    }
+    if (benchmark.valid) {
+        auto rate = [](size_t segments, float milliseconds) {
+            return milliseconds > 0.0f ? segments / milliseconds : 0.0f;
+        };
+        ImGui::Text("Renderer: %s", rendererName.c_str());
+        ImGui::Text("CPU ray trees:  %7.2f ms, %6zu segments (%.0f/ms)", benchmark.treeMilliseconds,
+                    benchmark.treeSegments, rate(benchmark.treeSegments, benchmark.treeMilliseconds));
+        ImGui::Text("CPU packets:    %7.2f ms, %6zu segments (%.0f/ms)", benchmark.packetMilliseconds,
+                    benchmark.packetSegments, rate(benchmark.packetSegments, benchmark.packetMilliseconds));
+        if (gpuTracer.isAvailable()) {
+            ImGui::Text("GPU feedback:   %7.2f ms, %6zu segments (%.0f/ms)", benchmark.gpuMilliseconds,
+                        benchmark.gpuSegments, rate(benchmark.gpuSegments, benchmark.gpuMilliseconds));
+        }
+    }
+    ImGui::Separator();
+    if (ImGui::Checkbox("Caustics", &showCaustics)) {
+        resetCaustics();
+    }
+    if (showCaustics) {
+        ImGui::SliderInt("Rays per Frame", &causticRaysPerFrame, 1000, 200000);
+        if (ImGui::SliderInt("Ray Target", &causticRayTarget, 100000, 20000000)) {
+            resetCaustics();
+        }
+        ImGui::SliderFloat("Exposure", &causticExposure, 0.05f, 20.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        ImGui::ProgressBar(static_cast<float>(causticRays) / causticRayTarget, ImVec2(-1.0f, 0.0f));
+        ImGui::Text("Caustic rays: %zu (%d workers)", causticRays, radiance.getWorkerCount());
+    }
+    ImGui::Separator();
+    if (indexField) {
+        traceDirty |= ImGui::SliderFloat("Step Tolerance", &grinSettings.tolerance, 1e-6f, 1e-2f, "%.1e",
+                           ImGuiSliderFlags_Logarithmic);
+        ImGui::Text("Integration steps: %d (%d rejected)", grinAcceptedSteps, grinRejectedSteps);
+    }
+    ImGui::Text("Trace time: %.2f ms", traceMilliseconds);
     
     ImGui::End();
 }
@@ -190,17 +797,10 @@ float RefractionSimulation::calculateCriticalAngle() {
 
 void RefractionSimulation::resetSimulation() {
     incidentRays.clear();
-    refractedRays.clear();
-    
-    // Create initial incident ray
-    LightRay initialRay;
-    initialRay.origin = glm::vec2(0.0f, 5.0f);
-    initialRay.direction = glm::vec2(sin(glm::radians(incidentAngle)), 
-                                   -cos(glm::radians(incidentAngle)));
-    initialRay.intensity = 1.0f;
-    incidentRays.push_back(initialRay);
+    rayPool.reset();
     
-    simulationRunning = true;
+    // Create initial incident rays
+    updateRays();
 }
 
 void RefractionSimulation::handleInput() {
@@ -210,30 +810,45 @@ void RefractionSimulation::handleInput() {
 }
 
 RefractionSimulation::~RefractionSimulation() {
-    glDeleteVertexArrays(1, &interfaceVAO);
-    glDeleteBuffers(1, &interfaceVBO);
+    RenderBackend::deleteVertexArrays(1, &interfaceVAO);
+    RenderBackend::deleteBuffers(1, &interfaceVBO);
+    RenderBackend::deleteVertexArrays(1, &spectralVAO);
+    RenderBackend::deleteBuffers(1, &spectralVBO);
+    RenderBackend::deleteVertexArrays(1, &causticVAO);
+    RenderBackend::deleteBuffers(1, &causticVBO);
+    glDeleteTextures(1, &causticTexture);
+    RenderBackend::deleteProgram(causticProgram);
+
+    RenderBackend::deleteVertexArrays(1, &rayRecordVAO);
+    RenderBackend::deleteVertexArrays(1, &refractedRecordVAO);
+    RenderBackend::deleteBuffers(1, &rayRecordVBO);
+    RenderBackend::deleteProgram(rayProgram);
 
           // Clean up base class resources
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    RenderBackend::deleteVertexArrays(1, &VAO);
+    RenderBackend::deleteBuffers(1, &VBO);
 }
 void RefractionSimulation::updateRays() {
     // Clear existing rays
     incidentRays.clear();
-    refractedRays.clear();
-    
-    // Create new incident ray with updated angle
-    LightRay newRay;
-    newRay.origin = glm::vec2(0.0f, 5.0f);  // Same origin point as in resetSimulation
+    rayPool.reset();
+    spectralPool.reset();
     
     // Convert angle to radians and calculate direction vector
     float angleRadians = glm::radians(incidentAngle);
-    newRay.direction = glm::vec2(sin(angleRadians), -cos(angleRadians));
-    newRay.intensity = 1.0f;
+    glm::vec2 direction(sin(angleRadians), -cos(angleRadians));
+    glm::vec2 across(-direction.y, direction.x);
     
-    // Add the new ray to incident rays vector
-    incidentRays.push_back(newRay);
+    // Spread the beam evenly across its width, centred on the source point
+    for (int i = 0; i < rayCount; i++) {
+        float offset = rayCount > 1 ? (static_cast<float>(i) / (rayCount - 1) - 0.5f) * beamWidth : 0.0f;
+        LightRay newRay;
+        newRay.origin = sourcePosition + across * offset;
+        newRay.direction = direction;
+        newRay.intensity = 1.0f;
+        incidentRays.push_back(newRay);
+    }
     
-    // Recalculate refraction for the updated incident ray
-    calculateRefraction();
-}
\ No newline at end of file
+    // Re-trace the updated incident rays on the next frame
+    traceDirty = true;
+}
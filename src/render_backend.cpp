@@ -0,0 +1,218 @@
+#include "render_backend.h"
+#include "gl_counters.h"
+#include <cstring>
+
+namespace {
+
+// Direct state access entry points; glad here is generated for 3.3 only
+typedef void (APIENTRYP CreateObjectsProc)(GLsizei count, GLuint* names);
+typedef void (APIENTRYP NamedBufferDataProc)(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+typedef void (APIENTRYP NamedBufferSubDataProc)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+typedef void (APIENTRYP VertexArrayVertexBufferProc)(GLuint vertexArray, GLuint binding, GLuint buffer,
+                                                     GLintptr offset, GLsizei stride);
+typedef void (APIENTRYP VertexArrayAttribFormatProc)(GLuint vertexArray, GLuint index, GLint size, GLenum type,
+                                                     GLboolean normalized, GLuint relativeOffset);
+typedef void (APIENTRYP VertexArrayAttribIFormatProc)(GLuint vertexArray, GLuint index, GLint size, GLenum type,
+                                                      GLuint relativeOffset);
+typedef void (APIENTRYP VertexArrayPairProc)(GLuint vertexArray, GLuint index, GLuint value);
+typedef void (APIENTRYP VertexArrayIndexProc)(GLuint vertexArray, GLuint index);
+
+struct DirectStateAccess {
+    CreateObjectsProc createBuffers;
+    CreateObjectsProc createVertexArrays;
+    NamedBufferDataProc namedBufferData;
+    NamedBufferSubDataProc namedBufferSubData;
+    VertexArrayVertexBufferProc vertexArrayVertexBuffer;
+    VertexArrayAttribFormatProc vertexArrayAttribFormat;
+    VertexArrayAttribIFormatProc vertexArrayAttribIFormat;
+    VertexArrayPairProc vertexArrayAttribBinding;
+    VertexArrayIndexProc enableVertexArrayAttrib;
+    VertexArrayIndexProc vertexArrayElementBuffer;
+} dsa;
+bool dsaAvailable = false;
+
+constexpr GLuint UNKNOWN = ~0u;
+GLuint boundProgram = UNKNOWN;
+GLuint boundVertexArray = UNKNOWN;
+GLuint boundArrayBuffer = UNKNOWN;
+
+bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+// Vertex array bindings take the real stride; 0 is not "tightly packed"
+GLsizei packedStride(GLint size, GLenum type) {
+    GLsizei component = type == GL_BYTE || type == GL_UNSIGNED_BYTE ? 1
+                      : type == GL_SHORT || type == GL_UNSIGNED_SHORT || type == GL_HALF_FLOAT ? 2 : 4;
+    return size * component;
+}
+
+}
+
+void RenderBackend::init(GLADloadproc loader) {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    dsaAvailable = false;
+    if (major > 4 || (major == 4 && minor >= 5) || hasExtension("GL_ARB_direct_state_access")) {
+        dsa.createBuffers = reinterpret_cast<CreateObjectsProc>(loader("glCreateBuffers"));
+        dsa.createVertexArrays = reinterpret_cast<CreateObjectsProc>(loader("glCreateVertexArrays"));
+        dsa.namedBufferData = reinterpret_cast<NamedBufferDataProc>(loader("glNamedBufferData"));
+        dsa.namedBufferSubData = reinterpret_cast<NamedBufferSubDataProc>(loader("glNamedBufferSubData"));
+        dsa.vertexArrayVertexBuffer = reinterpret_cast<VertexArrayVertexBufferProc>(loader("glVertexArrayVertexBuffer"));
+        dsa.vertexArrayAttribFormat = reinterpret_cast<VertexArrayAttribFormatProc>(loader("glVertexArrayAttribFormat"));
+        dsa.vertexArrayAttribIFormat =
+            reinterpret_cast<VertexArrayAttribIFormatProc>(loader("glVertexArrayAttribIFormat"));
+        dsa.vertexArrayAttribBinding = reinterpret_cast<VertexArrayPairProc>(loader("glVertexArrayAttribBinding"));
+        dsa.enableVertexArrayAttrib = reinterpret_cast<VertexArrayIndexProc>(loader("glEnableVertexArrayAttrib"));
+        dsa.vertexArrayElementBuffer = reinterpret_cast<VertexArrayIndexProc>(loader("glVertexArrayElementBuffer"));
+        // All or nothing
+        dsaAvailable = dsa.createBuffers && dsa.createVertexArrays && dsa.namedBufferData &&
+                       dsa.namedBufferSubData && dsa.vertexArrayVertexBuffer && dsa.vertexArrayAttribFormat &&
+                       dsa.vertexArrayAttribIFormat && dsa.vertexArrayAttribBinding &&
+                       dsa.enableVertexArrayAttrib && dsa.vertexArrayElementBuffer;
+    }
+    invalidate();
+}
+
+bool RenderBackend::hasDirectStateAccess() { return dsaAvailable; }
+
+void RenderBackend::invalidate() {
+    boundProgram = boundVertexArray = boundArrayBuffer = UNKNOWN;
+}
+
+void RenderBackend::useProgram(GLuint program) {
+    if (program == boundProgram) return;
+    boundProgram = program;
+    glUseProgram(program);
+}
+
+void RenderBackend::bindVertexArray(GLuint vertexArray) {
+    if (vertexArray == boundVertexArray) return;
+    boundVertexArray = vertexArray;
+    glBindVertexArray(vertexArray);
+}
+
+void RenderBackend::bindBuffer(GLenum target, GLuint buffer) {
+    // Other targets are rare, or (the element buffer) part of the vertex
+    // array's state, so only the array buffer is cached
+    if (target == GL_ARRAY_BUFFER) {
+        if (buffer == boundArrayBuffer) return;
+        boundArrayBuffer = buffer;
+    }
+    glBindBuffer(target, buffer);
+}
+
+GLuint RenderBackend::createBuffer() {
+    GLuint buffer = 0;
+    if (dsaAvailable) {
+        dsa.createBuffers(1, &buffer);
+    } else {
+        glGenBuffers(1, &buffer);
+        bindBuffer(GL_ARRAY_BUFFER, buffer);
+    }
+    return buffer;
+}
+
+GLuint RenderBackend::createVertexArray() {
+    GLuint vertexArray = 0;
+    if (dsaAvailable) {
+        dsa.createVertexArrays(1, &vertexArray);
+    } else {
+        glGenVertexArrays(1, &vertexArray);
+    }
+    return vertexArray;
+}
+
+// A deleted name can come back from glGen*/glCreate*, so it must not stay
+// cached as bound. GL itself unbinds deleted vertex arrays and buffers.
+void RenderBackend::deleteProgram(GLuint program) {
+    if (program == boundProgram) boundProgram = UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void RenderBackend::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (vertexArrays[i] == boundVertexArray) boundVertexArray = 0;
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void RenderBackend::deleteBuffers(GLsizei count, const GLuint* buffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (buffers[i] == boundArrayBuffer) boundArrayBuffer = 0;
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void RenderBackend::bufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage) {
+    if (dsaAvailable) {
+        GlCounters::recordUpload(data ? size : 0);
+        dsa.namedBufferData(buffer, size, data, usage);
+        return;
+    }
+    bindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+}
+
+void RenderBackend::bufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data) {
+    if (dsaAvailable) {
+        GlCounters::recordUpload(size);
+        dsa.namedBufferSubData(buffer, offset, size, data);
+        return;
+    }
+    bindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+}
+
+// With DSA each attribute gets the binding point of its own index, which
+// holds the buffer, offset and stride
+void RenderBackend::vertexAttribute(GLuint vertexArray, GLuint index, GLuint buffer, GLint size, GLenum type,
+                                    GLboolean normalized, GLsizei stride, size_t offset) {
+    if (dsaAvailable) {
+        GlCounters::recordStateChanges(4);
+        dsa.vertexArrayVertexBuffer(vertexArray, index, buffer, static_cast<GLintptr>(offset),
+                                    stride ? stride : packedStride(size, type));
+        dsa.vertexArrayAttribFormat(vertexArray, index, size, type, normalized, 0);
+        dsa.vertexArrayAttribBinding(vertexArray, index, index);
+        dsa.enableVertexArrayAttrib(vertexArray, index);
+        return;
+    }
+    bindVertexArray(vertexArray);
+    bindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<const void*>(offset));
+    glEnableVertexAttribArray(index);
+}
+
+void RenderBackend::vertexAttributeInteger(GLuint vertexArray, GLuint index, GLuint buffer, GLint size,
+                                           GLenum type, GLsizei stride, size_t offset) {
+    if (dsaAvailable) {
+        GlCounters::recordStateChanges(4);
+        dsa.vertexArrayVertexBuffer(vertexArray, index, buffer, static_cast<GLintptr>(offset),
+                                    stride ? stride : packedStride(size, type));
+        dsa.vertexArrayAttribIFormat(vertexArray, index, size, type, 0);
+        dsa.vertexArrayAttribBinding(vertexArray, index, index);
+        dsa.enableVertexArrayAttrib(vertexArray, index);
+        return;
+    }
+    bindVertexArray(vertexArray);
+    bindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribIPointer(index, size, type, stride, reinterpret_cast<const void*>(offset));
+    glEnableVertexAttribArray(index);
+}
+
+void RenderBackend::elementBuffer(GLuint vertexArray, GLuint buffer) {
+    if (dsaAvailable) {
+        GlCounters::recordStateChanges(1);
+        dsa.vertexArrayElementBuffer(vertexArray, buffer);
+        return;
+    }
+    bindVertexArray(vertexArray);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+}
@@ -0,0 +1,324 @@
+#include "render_queue.h"
+#include "render_backend.h"
+#include "alloc_tracker.h"
+#include <algorithm>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+constexpr size_t CommandList::NO_PROGRAM;
+constexpr size_t CommandList::RESERVED_VALUES;
+constexpr size_t CommandList::RESERVED_FLOATS;
+
+// Names are compared by content: identical literals are not always merged
+// into one string, depending on the compiler and build
+static bool sameName(const char* a, const char* b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+size_t CommandList::sizeOf(Kind kind) {
+    switch (kind) {
+        case Vec2: return 2;
+        case Vec3: return 3;
+        case Vec4: case Attribute: return 4;
+        case Mat4: return 16;
+        default: return 1;
+    }
+}
+
+void CommandList::reset(int width, int height) {
+    viewportWidth = width;
+    viewportHeight = height;
+    hasClear = false;
+    current = State();
+    currentProgram = NO_PROGRAM;
+    for (ProgramValues& program : programs) {
+        program.values.clear();
+        program.data.clear();
+    }
+    attributes.values.clear();
+    attributes.data.clear();
+    draws.clear();
+    values.clear();
+    data.clear();
+}
+
+void CommandList::clearColor(const glm::vec4& color) {
+    hasClear = true;
+    clearValue = color;
+}
+
+void CommandList::reserve(size_t drawCount, std::initializer_list<GLuint> programList) {
+    draws.reserve(drawCount);
+    values.reserve(drawCount * RESERVED_VALUES);
+    data.reserve(drawCount * RESERVED_FLOATS);
+    attributes.values.reserve(RESERVED_VALUES);
+    attributes.data.reserve(RESERVED_FLOATS);
+    for (GLuint program : programList) programIndex(program);
+}
+
+size_t CommandList::programIndex(GLuint program) {
+    for (size_t i = 0; i < programs.size(); i++) {
+        if (programs[i].program == program) return i;
+    }
+    ProgramValues added;
+    added.program = program;
+    added.values.reserve(RESERVED_VALUES);
+    added.data.reserve(RESERVED_FLOATS);
+    programs.push_back(std::move(added));
+    return programs.size() - 1;
+}
+
+void CommandList::useProgram(GLuint program) {
+    current.program = program;
+    currentProgram = programIndex(program);
+}
+
+void CommandList::set(const char* name, GLuint index, Kind kind, const float* value) {
+    if (kind != Attribute && currentProgram == NO_PROGRAM) return;
+    ProgramValues& owner = kind == Attribute ? attributes : programs[currentProgram];
+    size_t size = sizeOf(kind);
+    for (Value& existing : owner.values) {
+        if (sameName(existing.name, name) && existing.index == index && existing.kind == kind) {
+            std::copy(value, value + size, owner.data.begin() + existing.offset);
+            return;
+        }
+    }
+    owner.values.push_back({ name, index, kind, static_cast<uint32_t>(owner.data.size()) });
+    owner.data.insert(owner.data.end(), value, value + size);
+}
+
+void CommandList::uniform(const char* name, int x) {
+    // Kept bit for bit in the float data
+    float bits;
+    memcpy(&bits, &x, sizeof(bits));
+    set(name, 0, Int, &bits);
+}
+
+void CommandList::uniform(const char* name, float x) { set(name, 0, Float, &x); }
+void CommandList::uniform(const char* name, const glm::vec2& v) { set(name, 0, Vec2, glm::value_ptr(v)); }
+void CommandList::uniform(const char* name, const glm::vec3& v) { set(name, 0, Vec3, glm::value_ptr(v)); }
+void CommandList::uniform(const char* name, const glm::vec4& v) { set(name, 0, Vec4, glm::value_ptr(v)); }
+void CommandList::uniform(const char* name, const glm::mat4& m) { set(name, 0, Mat4, glm::value_ptr(m)); }
+
+void CommandList::constantAttribute(GLuint index, const glm::vec4& v) {
+    set(nullptr, index, Attribute, glm::value_ptr(v));
+}
+
+void CommandList::drawArrays(GLenum mode, GLint first, GLsizei count) {
+    record(mode, first, count, 0);
+}
+
+void CommandList::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    record(mode, first, count, instances);
+}
+
+void CommandList::record(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    if (count <= 0 || instances < 0) return;
+    Draw draw;
+    // Names past 16 bits only sort less tightly; equality checks use the
+    // whole names
+    draw.key = static_cast<uint64_t>(current.layer) << 56 |
+               static_cast<uint64_t>(current.program & 0xFFFF) << 40 |
+               static_cast<uint64_t>(current.vertexArray & 0xFFFF) << 24 |
+               (draws.size() & 0xFFFFFF);
+    draw.state = current;
+    draw.mode = mode;
+    draw.first = first;
+    draw.count = count;
+    draw.instances = instances;
+    draw.firstValue = static_cast<uint32_t>(values.size());
+
+    // The draw's own copy of its program's uniforms and the attributes
+    const ProgramValues* sources[2] = { currentProgram == NO_PROGRAM ? nullptr : &programs[currentProgram],
+                                        &attributes };
+    for (const ProgramValues* source : sources) {
+        if (!source) continue;
+        for (const Value& value : source->values) {
+            values.push_back({ value.name, value.index, value.kind, static_cast<uint32_t>(data.size()) });
+            const float* from = source->data.data() + value.offset;
+            data.insert(data.end(), from, from + sizeOf(value.kind));
+        }
+    }
+    draw.valueCount = static_cast<uint32_t>(values.size()) - draw.firstValue;
+    draws.push_back(draw);
+}
+
+namespace {
+
+// Modes where two ranges drawn back to back are the same as one range, as
+// long as each range is whole primitives; 0 for the others
+GLsizei verticesPerPrimitive(GLenum mode) {
+    switch (mode) {
+        case GL_POINTS: return 1;
+        case GL_LINES: return 2;
+        case GL_TRIANGLES: return 3;
+        default: return 0;
+    }
+}
+
+}
+
+GLint RenderQueue::location(GLuint program, const char* name) {
+    for (const Location& cached : locations) {
+        if (cached.program == program && cached.name == name) return cached.location;
+    }
+    GLint found = glGetUniformLocation(program, name);
+    locations.push_back({ program, name, found });
+    return found;
+}
+
+bool RenderQueue::mergeable(const CommandList& list, const CommandList::Draw& a, const CommandList::Draw& b) {
+    const CommandList::State& x = a.state;
+    const CommandList::State& y = b.state;
+    if (a.instances || b.instances || a.mode != b.mode || a.valueCount != b.valueCount) return false;
+    if (x.layer != y.layer || x.blend != y.blend || x.program != y.program || x.vertexArray != y.vertexArray ||
+        x.texture != y.texture || x.pointSize != y.pointSize) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.valueCount; i++) {
+        const CommandList::Value& u = list.values[a.firstValue + i];
+        const CommandList::Value& v = list.values[b.firstValue + i];
+        if (!sameName(u.name, v.name) || u.index != v.index || u.kind != v.kind ||
+            memcmp(&list.data[u.offset], &list.data[v.offset], CommandList::sizeOf(u.kind) * sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RenderQueue::apply(const CommandList& list, const CommandList::Draw& draw,
+                        const CommandList::Draw* previous) {
+    const CommandList::State& state = draw.state;
+    RenderBackend::useProgram(state.program);
+    RenderBackend::bindVertexArray(state.vertexArray);
+    if (state.texture != applied.texture) {
+        glBindTexture(GL_TEXTURE_2D, state.texture);
+        applied.texture = state.texture;
+    }
+    if (state.blend != applied.blend) {
+        glBlendFunc(GL_SRC_ALPHA, state.blend == CommandList::BlendAdditive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+        applied.blend = state.blend;
+    }
+    if (state.pointSize != applied.pointSize) {
+        if (state.pointSize > 0.0f) {
+            if (applied.pointSize == 0.0f) glDisable(GL_PROGRAM_POINT_SIZE);
+            glPointSize(state.pointSize);
+        } else {
+            glPointSize(1.0f);
+            glEnable(GL_PROGRAM_POINT_SIZE);
+        }
+        applied.pointSize = state.pointSize;
+    }
+
+    // The previous draw left all of its uniforms set, so with the same
+    // program only the ones that differ need setting
+    bool sameProgram = previous && previous->state.program == state.program;
+    for (uint32_t i = 0; i < draw.valueCount; i++) {
+        const CommandList::Value& value = list.values[draw.firstValue + i];
+        const float* data = &list.data[value.offset];
+        if (value.kind == CommandList::Attribute) {
+            // Never skipped: drawing from an enabled array leaves it undefined
+            glVertexAttrib4fv(value.index, data);
+            continue;
+        }
+        if (sameProgram) {
+            bool unchanged = false;
+            for (uint32_t j = 0; j < previous->valueCount && !unchanged; j++) {
+                const CommandList::Value& before = list.values[previous->firstValue + j];
+                unchanged = sameName(before.name, value.name) && before.kind == value.kind &&
+                            memcmp(&list.data[before.offset], data,
+                                   CommandList::sizeOf(value.kind) * sizeof(float)) == 0;
+            }
+            if (unchanged) continue;
+        }
+        GLint at = location(state.program, value.name);
+        if (at < 0) continue;
+        switch (value.kind) {
+            case CommandList::Int: {
+                GLint x;
+                memcpy(&x, data, sizeof(x));
+                glUniform1i(at, x);
+                break;
+            }
+            case CommandList::Float: glUniform1f(at, data[0]); break;
+            case CommandList::Vec2: glUniform2f(at, data[0], data[1]); break;
+            case CommandList::Vec3: glUniform3f(at, data[0], data[1], data[2]); break;
+            case CommandList::Vec4: glUniform4f(at, data[0], data[1], data[2], data[3]); break;
+            case CommandList::Mat4: glUniformMatrix4fv(at, 1, GL_FALSE, data); break;
+            default: break;
+        }
+    }
+}
+
+void RenderQueue::restoreDefaults() {
+    CommandList::State defaults;
+    if (applied.texture != defaults.texture) glBindTexture(GL_TEXTURE_2D, defaults.texture);
+    if (applied.blend != defaults.blend) glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (applied.pointSize != defaults.pointSize) {
+        glPointSize(1.0f);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+    }
+    applied = defaults;
+}
+
+void RenderQueue::submit(const CommandList& list) {
+    // Scratch for the biggest list so far, and room for a location per new
+    // value at most; past this the submit must not allocate
+    size_t count = list.draws.size();
+    order.resize(count);
+    firsts.reserve(count);
+    counts.reserve(count);
+    if (locations.capacity() - locations.size() < list.values.size()) {
+        locations.reserve(locations.size() + list.values.size());
+    }
+    AllocTracker::HotRegion hot;
+
+    stats = Stats();
+    stats.commands = count;
+    if (list.hasClear) {
+        glClearColor(list.clearValue.r, list.clearValue.g, list.clearValue.b, list.clearValue.a);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    // The keys end in the recording order, so sorting them is stable
+    for (size_t i = 0; i < count; i++) order[i] = static_cast<uint32_t>(i);
+    std::sort(order.begin(), order.end(),
+              [&list](uint32_t a, uint32_t b) { return list.draws[a].key < list.draws[b].key; });
+
+    const CommandList::Draw* previous = nullptr;
+    for (size_t i = 0; i < count;) {
+        const CommandList::Draw& draw = list.draws[order[i]];
+        size_t end = i + 1;
+        while (end < count && mergeable(list, draw, list.draws[order[end]])) end++;
+
+        apply(list, draw, previous);
+        if (draw.instances > 0) {
+            glDrawArraysInstanced(draw.mode, draw.first, draw.count, draw.instances);
+        } else if (end - i == 1) {
+            glDrawArrays(draw.mode, draw.first, draw.count);
+        } else {
+            firsts.clear();
+            counts.clear();
+            GLsizei perPrimitive = verticesPerPrimitive(draw.mode);
+            bool contiguous = perPrimitive > 0;
+            GLint next = draw.first;
+            for (size_t j = i; j < end; j++) {
+                const CommandList::Draw& part = list.draws[order[j]];
+                contiguous = contiguous && part.first == next && part.count % perPrimitive == 0;
+                next = part.first + part.count;
+                firsts.push_back(part.first);
+                counts.push_back(part.count);
+            }
+            if (contiguous) {
+                glDrawArrays(draw.mode, draw.first, next - draw.first);
+            } else {
+                glMultiDrawArrays(draw.mode, firsts.data(), counts.data(), static_cast<GLsizei>(end - i));
+            }
+            stats.merged += end - i - 1;
+        }
+        stats.calls++;
+        previous = &draw;
+        i = end;
+    }
+    restoreDefaults();
+}
@@ -0,0 +1,218 @@
+#include "scenario.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// More runs than this from one line is almost certainly a mistyped step
+constexpr double MAX_RUNS_PER_LINE = 1 << 24;
+
+struct Key {
+    const char* name;
+    Scenario::Kind kind;
+    float Scenario::* field;
+};
+
+const Key KEYS[] = {
+    { "angle", Scenario::Projectile, &Scenario::angle },
+    { "speed", Scenario::Projectile, &Scenario::speed },
+    { "target", Scenario::Projectile, &Scenario::target },
+    { "gravity", Scenario::Projectile, &Scenario::gravity },
+    { "drag", Scenario::Projectile, &Scenario::drag },
+    { "wind", Scenario::Projectile, &Scenario::wind },
+    { "angle", Scenario::Refraction, &Scenario::angle },
+    { "n1", Scenario::Refraction, &Scenario::n1 },
+    { "n2", Scenario::Refraction, &Scenario::n2 },
+};
+
+struct Sweep {
+    float Scenario::* field;
+    float first, step;
+    size_t count;
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isTokenEnd(const char* p, const char* end) { return p == end || isSpace(*p) || *p == '#'; }
+
+bool matches(const char* begin, const char* end, const char* word) {
+    size_t length = strlen(word);
+    return static_cast<size_t>(end - begin) == length && memcmp(begin, word, length) == 0;
+}
+
+// Decimal with optional sign, fraction and exponent. Not strtof: the mapped
+// text has no terminating null, and this does not depend on the locale.
+// Values too large for a float are rejected like any other non-number.
+bool parseNumber(const char*& p, const char* end, float& value) {
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    double mantissa = 0.0;
+    int scale = 0;
+    bool digits = false;
+    for (; p < end && isDigit(*p); p++, digits = true) mantissa = mantissa * 10.0 + (*p - '0');
+    if (p < end && *p == '.') {
+        for (p++; p < end && isDigit(*p); p++, digits = true) {
+            mantissa = mantissa * 10.0 + (*p - '0');
+            scale--;
+        }
+    }
+    if (!digits) {
+        p = start;
+        return false;
+    }
+
+    if (p + 1 < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (*q == '-' || *q == '+') negativeExponent = *q++ == '-';
+        if (q < end && isDigit(*q)) {
+            int exponent = 0;
+            for (; q < end && isDigit(*q); q++) exponent = std::min(exponent * 10 + (*q - '0'), 1000);
+            scale += negativeExponent ? -exponent : exponent;
+            p = q;
+        }
+    }
+
+    double result = scale ? mantissa * pow(10.0, scale) : mantissa;
+    if (!(result <= FLT_MAX)) {
+        p = start;
+        return false;
+    }
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
+
+class LineParser {
+public:
+    LineParser(const std::string& source, int line) : source(source), line(line) {}
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error(source + ":" + std::to_string(line) + ": " + message);
+    }
+
+    // Appends the runs of one line (none for blank and comment lines)
+    void parse(const char* p, const char* end, std::vector<Scenario>& out) {
+        while (p < end && isSpace(*p)) p++;
+        if (p == end || *p == '#') return;
+
+        const char* word = p;
+        while (!isTokenEnd(p, end)) p++;
+        Scenario base;
+        base.line = line;
+        if (matches(word, p, "projectile")) {
+            base.kind = Scenario::Projectile;
+        } else if (matches(word, p, "refraction")) {
+            base.kind = Scenario::Refraction;
+        } else {
+            fail("unknown simulation '" + std::string(word, p) + "'");
+        }
+
+        std::vector<Sweep> sweeps;
+        while (true) {
+            while (p < end && isSpace(*p)) p++;
+            if (p == end || *p == '#') break;
+
+            const char* key = p;
+            while (p < end && *p != '=' && !isTokenEnd(p, end)) p++;
+            if (p == end || *p != '=') fail("expected key=value, got '" + std::string(key, p) + "'");
+            const char* keyEnd = p++;
+
+            if (base.kind == Scenario::Refraction && matches(key, keyEnd, "polarization")) {
+                const char* value = p;
+                while (!isTokenEnd(p, end)) p++;
+                if (matches(value, p, "u") || matches(value, p, "unpolarized")) {
+                    base.polarization = Scenario::Unpolarized;
+                } else if (matches(value, p, "s")) {
+                    base.polarization = Scenario::SPolarized;
+                } else if (matches(value, p, "p")) {
+                    base.polarization = Scenario::PPolarized;
+                } else {
+                    fail("polarization must be u, s or p");
+                }
+                continue;
+            }
+
+            float Scenario::* field = nullptr;
+            for (const Key& candidate : KEYS) {
+                if (candidate.kind == base.kind && matches(key, keyEnd, candidate.name)) {
+                    field = candidate.field;
+                }
+            }
+            if (!field) fail("unknown key '" + std::string(key, keyEnd) + "'");
+
+            // A later value for the same key replaces the earlier one
+            sweeps.erase(std::remove_if(sweeps.begin(), sweeps.end(),
+                                        [&](const Sweep& sweep) { return sweep.field == field; }),
+                         sweeps.end());
+            float first = 0.0f, last = 0.0f, step = 1.0f;
+            if (!parseNumber(p, end, first)) fail("expected a finite number for '" + std::string(key, keyEnd) + "'");
+            if (p < end && *p == ':') {
+                p++;
+                if (!parseNumber(p, end, last)) fail("expected first:last[:step] with finite numbers");
+                if (p < end && *p == ':') {
+                    p++;
+                    if (!parseNumber(p, end, step)) fail("expected first:last[:step] with finite numbers");
+                }
+                if (!(step > 0.0f) || !(last >= first)) fail("a sweep needs first <= last and step > 0");
+                // The small allowance keeps last in the sweep despite rounding.
+                // Written so that anything not a sane count fails before the
+                // conversion to size_t.
+                double count = floor((static_cast<double>(last) - first) / step + 1e-4) + 1.0;
+                if (!(count >= 1.0 && count <= MAX_RUNS_PER_LINE)) fail("sweep has too many steps");
+                sweeps.push_back({ field, first, step, static_cast<size_t>(count) });
+            }
+            if (!isTokenEnd(p, end)) fail("unexpected '" + std::string(1, *p) + "' in value");
+            base.*field = first;
+        }
+
+        double runs = 1.0;
+        for (const Sweep& sweep : sweeps) runs *= sweep.count;
+        if (runs > MAX_RUNS_PER_LINE) fail("sweeps expand to too many runs");
+
+        // Odometer over the sweeps, last one fastest
+        std::vector<size_t> index(sweeps.size(), 0);
+        out.reserve(out.size() + static_cast<size_t>(runs));
+        for (size_t run = 0; run < static_cast<size_t>(runs); run++) {
+            Scenario scenario = base;
+            for (size_t s = 0; s < sweeps.size(); s++) {
+                scenario.*sweeps[s].field = sweeps[s].first + sweeps[s].step * index[s];
+            }
+            out.push_back(scenario);
+            for (size_t s = sweeps.size(); s-- > 0;) {
+                if (++index[s] < sweeps[s].count) break;
+                index[s] = 0;
+            }
+        }
+    }
+
+private:
+    const std::string& source;
+    int line;
+};
+
+}
+
+std::vector<Scenario> parseScenarios(const char* text, size_t length, const std::string& source) {
+    std::vector<Scenario> scenarios;
+    const char* end = text + length;
+    int line = 1;
+    for (const char* p = text; p < end; line++) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+        LineParser(source, line).parse(p, lineEnd, scenarios);
+        p = lineEnd + 1;
+    }
+    return scenarios;
+}
+
+std::vector<Scenario> loadScenarios(const std::string& path) {
+    MappedFile file;
+    file.open(path);
+    return parseScenarios(reinterpret_cast<const char*>(file.data()), file.size(), path);
+}
@@ -0,0 +1,181 @@
+#include "session_log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+static const char SESSION_MAGIC[4] = { 'P', 'V', 'S', 'L' };
+static constexpr uint32_t SESSION_VERSION = 1;
+
+void SessionWriter::open(const std::string& path, const std::vector<uint8_t>& header) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Failed to create session log: " + path);
+    }
+    this->path = path;
+    failed = false;
+    error.clear();
+    buffer.clear();
+    bytesWritten = 0;
+    lastStep = lastKeyframeStep = 0;
+
+    ByteWriter out(buffer);
+    out.putBytes(SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    out.putVarint(SESSION_VERSION);
+    out.putVarint(header.size());
+    out.putBytes(header.data(), header.size());
+}
+
+void SessionWriter::close() {
+    if (!file) return;
+    flush();
+    // Buffered data reaches the disk here, so this can fail too
+    if (ferror(file) != 0) fail();
+    if (fclose(file) != 0) fail();
+    file = nullptr;
+    buffer.clear();
+}
+
+void SessionWriter::beginRecord(SessionRecord type, uint64_t step) {
+    ByteWriter out(buffer);
+    out.putByte(static_cast<uint8_t>(type));
+    out.putVarint(type == SessionRecord::Keyframe ? step : step - lastStep);
+    lastStep = step;
+}
+
+void SessionWriter::endRecord() {
+    // Appends are batched; the file only sees large writes
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void SessionWriter::flush() {
+    // After a failed write the records are dropped, so the buffer stays small
+    if (!failed && !buffer.empty()) {
+        if (fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size()) {
+            bytesWritten += buffer.size();
+        } else {
+            fail();
+        }
+    }
+    buffer.clear();
+}
+
+void SessionWriter::fail() {
+    if (failed) return;
+    error = "Failed to write session log: " + path + " (" + std::strerror(errno) + ")";
+    failed = true;
+}
+
+void SessionWriter::command(uint64_t step, const std::vector<uint8_t>& payload) {
+    beginRecord(SessionRecord::Command, step);
+    ByteWriter out(buffer);
+    out.putVarint(payload.size());
+    out.putBytes(payload.data(), payload.size());
+    endRecord();
+}
+
+void SessionWriter::hash(uint64_t step, uint64_t value) {
+    beginRecord(SessionRecord::Hash, step);
+    ByteWriter(buffer).putU64(value);
+    endRecord();
+}
+
+void SessionWriter::keyframe(uint64_t step, const std::vector<uint8_t>& payload) {
+    beginRecord(SessionRecord::Keyframe, step);
+    ByteWriter out(buffer);
+    out.putVarint(payload.size());
+    out.putBytes(payload.data(), payload.size());
+    lastKeyframeStep = step;
+    endRecord();
+}
+
+void SessionReader::open(const std::string& path) {
+    close();
+    file.open(path);
+
+    size_t offset = 0;
+    try {
+        ByteReader in(file.data(), file.size());
+        if (std::memcmp(in.getBytes(sizeof(SESSION_MAGIC)), SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+            throw std::runtime_error("Not a session log: " + path);
+        }
+        if (in.getVarint() != SESSION_VERSION) {
+            throw std::runtime_error("Unsupported session log version: " + path);
+        }
+        size_t headerSize = static_cast<size_t>(in.getVarint());
+        const uint8_t* headerBytes = in.getBytes(headerSize);
+        header.assign(headerBytes, headerBytes + headerSize);
+        offset = static_cast<size_t>(in.position() - file.data());
+    } catch (const std::runtime_error&) {
+        close();
+        throw;
+    }
+
+    // One pass to find the keyframes and where the complete records end
+    uint64_t step = 0;
+    Record record;
+    for (size_t start = offset; parse(offset, step, record, file.size()); start = offset) {
+        if (record.type == SessionRecord::Keyframe) {
+            keyframes.push_back({ step, start });
+        }
+        recordsEnd = offset;
+        lastStep = step;
+    }
+    if (keyframes.empty()) {
+        close();
+        throw std::runtime_error("Session log has no keyframe: " + path);
+    }
+}
+
+void SessionReader::close() {
+    file.close();
+    header.clear();
+    keyframes.clear();
+    recordsEnd = 0;
+    lastStep = 0;
+}
+
+SessionReader::Cursor SessionReader::seek(uint64_t step) const {
+    auto after = std::upper_bound(keyframes.begin(), keyframes.end(), step,
+                                  [](uint64_t value, const KeyframeEntry& entry) { return value < entry.step; });
+    const KeyframeEntry& entry = after == keyframes.begin() ? keyframes.front() : *(after - 1);
+    Cursor cursor;
+    cursor.offset = entry.offset;
+    cursor.step = entry.step;
+    return cursor;
+}
+
+bool SessionReader::read(Cursor& cursor, Record& record) const {
+    return parse(cursor.offset, cursor.step, record, recordsEnd);
+}
+
+bool SessionReader::parse(size_t& offset, uint64_t& step, Record& record, size_t end) const {
+    if (offset >= end) return false;
+    try {
+        ByteReader in(file.data() + offset, end - offset);
+        record.type = static_cast<SessionRecord>(in.getByte());
+        uint64_t stepField = in.getVarint();
+        record.data = nullptr;
+        record.size = 0;
+        record.hash = 0;
+        switch (record.type) {
+            case SessionRecord::Command:
+            case SessionRecord::Keyframe:
+                record.size = static_cast<size_t>(in.getVarint());
+                record.data = in.getBytes(record.size);
+                break;
+            case SessionRecord::Hash:
+                record.hash = in.getU64();
+                break;
+            default:
+                return false;
+        }
+        record.step = record.type == SessionRecord::Keyframe ? stepField : step + stepField;
+        step = record.step;
+        offset = static_cast<size_t>(in.position() - file.data());
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;     // cut off mid-record
+    }
+}
@@ -1,4 +1,6 @@
 #include "shader_utils.h"
+#include "alloc_tracker.h"
+#include "render_backend.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -11,6 +13,7 @@ namespace ShaderUtils {
 unsigned int make_shader(const std::string& vertex_filepath,
                         const std::string& fragment_filepath) 
 {
+    AllocTracker::Scope allocScope(AllocTracker::Shaders);
     std::vector<unsigned int> modules;
     modules.reserve(2);  // Pre-allocate for 2 shaders
 
@@ -38,7 +41,10 @@ unsigned int make_shader(const std::string& vertex_filepath,
         char errorLog[1024];
         glGetProgramInfoLog(shader, 1024, nullptr, errorLog);
         std::cerr << "Shader linking failed:\n" << errorLog << '\n';
-        glDeleteProgram(shader);
+        for (unsigned int shaderModule : modules) {
+            glDeleteShader(shaderModule);
+        }
+        RenderBackend::deleteProgram(shader);
         return 0;  // Return 0 to indicate failure
     }
 
@@ -51,9 +57,65 @@ unsigned int make_shader(const std::string& vertex_filepath,
     return shader;
 }
 
+unsigned int make_feedback_shader(const std::string& vertex_filepath,
+                                  const std::string& geometry_filepath,
+                                  const std::vector<std::string>& varyings)
+{
+    AllocTracker::Scope allocScope(AllocTracker::Shaders);
+    std::vector<unsigned int> modules;
+    modules.reserve(2);
+
+    try {
+        modules.push_back(make_module(vertex_filepath, GL_VERTEX_SHADER));
+        if (!geometry_filepath.empty()) {
+            modules.push_back(make_module(geometry_filepath, GL_GEOMETRY_SHADER));
+        }
+    } catch (const std::exception& e) {
+        for (auto module : modules) {
+            glDeleteShader(module);
+        }
+        throw;
+    }
+
+    unsigned int shader = glCreateProgram();
+    for (unsigned int shaderModule : modules) {
+        glAttachShader(shader, shaderModule);
+    }
+
+    // Captured outputs have to be named before linking
+    std::vector<const char*> names;
+    for (const std::string& varying : varyings) {
+        names.push_back(varying.c_str());
+    }
+    glTransformFeedbackVaryings(shader, static_cast<GLsizei>(names.size()), names.data(),
+                                GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(shader);
+
+    int success;
+    glGetProgramiv(shader, GL_LINK_STATUS, &success);
+    if (!success) {
+        char errorLog[1024];
+        glGetProgramInfoLog(shader, 1024, nullptr, errorLog);
+        std::cerr << "Feedback shader linking failed:\n" << errorLog << '\n';
+        for (unsigned int shaderModule : modules) {
+            glDeleteShader(shaderModule);
+        }
+        RenderBackend::deleteProgram(shader);
+        return 0;
+    }
+
+    for (unsigned int shaderModule : modules) {
+        glDetachShader(shader, shaderModule);
+        glDeleteShader(shaderModule);
+    }
+
+    return shader;
+}
+
 unsigned int make_module(const std::string& filepath,
                         unsigned int module_type) 
 {
+    AllocTracker::Scope allocScope(AllocTracker::Shaders);
     std::ifstream file(filepath);
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open shader file: " + filepath);
@@ -1,19 +1,13 @@
 #include "simulation_base.h"
+#include "render_backend.h"
 
 void SimulationBase::setupBuffers() {
-    // Generate and bind VAO/VBO
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    
-    
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    // Created as objects up front, so the backend can edit them by name
+    VAO = RenderBackend::createVertexArray();
+    VBO = RenderBackend::createBuffer();
     
     // Configure vertex attributes
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    RenderBackend::vertexAttribute(VAO, 0, VBO, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
     
-    // Unbind for safety
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+    // No unbinding: the backend only binds when something else is needed
+}
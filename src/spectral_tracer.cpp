@@ -0,0 +1,236 @@
+#include "spectral_tracer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr int L = SPECTRAL_LANES;
+
+// Structure-of-arrays ray packet, one wavelength per lane
+struct SpectralPacket {
+    alignas(32) float originX[L];
+    alignas(32) float originY[L];
+    alignas(32) float directionX[L];
+    alignas(32) float directionY[L];
+    alignas(32) float intensityS[L];
+    alignas(32) float intensityP[L];
+    alignas(32) float wavelength[L];
+    unsigned activeMask;
+    int depth;
+};
+
+struct PacketContext {
+    const OpticalScene& scene;
+    const FresnelSettings& settings;
+    float laneCutoff;
+    const float* laneIndices;  // [material * L + lane]
+    SpectralSegmentPool& pool;
+};
+
+bool emitSegment(SpectralSegmentPool& pool, const glm::vec2& start, const glm::vec2& end,
+                 float wavelength, float intensity, int depth) {
+    int index = pool.allocate();
+    if (index < 0) return false;
+    SpectralSegment& segment = pool[index];
+    segment.start = start;
+    segment.end = end;
+    segment.wavelength = wavelength;
+    segment.intensity = intensity;
+    segment.depth = depth;
+    return true;
+}
+
+size_t tracePacket(const PacketContext& context, const SpectralPacket& packet) {
+    const OpticalScene& scene = context.scene;
+    const std::vector<OpticalPrimitive>& primitives = scene.getPrimitives();
+    size_t tests = 0;
+
+    alignas(32) float tMax[L];
+    int hitPrimitive[L];
+    for (int l = 0; l < L; l++) {
+        tMax[l] = OpticalScene::ESCAPE_DISTANCE;
+        hitPrimitive[l] = -1;
+    }
+
+    scene.getBvh().intersectPacket<L>(
+        packet.originX, packet.originY, packet.directionX, packet.directionY,
+        tMax, packet.activeMask, [&](int primIndex, float* laneMax) {
+            tests++;
+            const OpticalPrimitive& prim = primitives[primIndex];
+            if (prim.type == OpticalPrimitive::Segment) {
+                // Same algebra as OpticalScene::intersectPrimitive, written as
+                // selects so the lane loop vectorises
+                float edgeX = prim.p1.x - prim.p0.x;
+                float edgeY = prim.p1.y - prim.p0.y;
+                for (int l = 0; l < L; l++) {
+                    float denom = packet.directionX[l] * edgeY - packet.directionY[l] * edgeX;
+                    float toStartX = prim.p0.x - packet.originX[l];
+                    float toStartY = prim.p0.y - packet.originY[l];
+                    float inv = 1.0f / denom;
+                    float t = (toStartX * edgeY - toStartY * edgeX) * inv;
+                    float s = (toStartX * packet.directionY[l] - toStartY * packet.directionX[l]) * inv;
+                    bool hit = (t > OpticalScene::RAY_EPSILON) & (t < laneMax[l]) &
+                               (s >= 0.0f) & (s <= 1.0f);
+                    laneMax[l] = hit ? t : laneMax[l];
+                    hitPrimitive[l] = hit ? primIndex : hitPrimitive[l];
+                }
+                return;
+            }
+            for (int l = 0; l < L; l++) {
+                if (!((packet.activeMask >> l) & 1u)) continue;
+                OpticalHit hit;
+                glm::vec2 origin(packet.originX[l], packet.originY[l]);
+                glm::vec2 direction(packet.directionX[l], packet.directionY[l]);
+                if (scene.intersectPrimitive(primIndex, origin, direction, laneMax[l], hit)) {
+                    laneMax[l] = hit.t;
+                    hitPrimitive[l] = primIndex;
+                }
+            }
+        });
+
+    // Gather the surface each lane hit, then shade all lanes together.
+    // Lane l keeps its wavelength for the whole tree, so indices come
+    // straight from the per-packet table.
+    alignas(32) float endX[L], endY[L], normalX[L], normalY[L], fromIndex[L], toIndex[L];
+    unsigned shadeMask = 0;
+    for (int l = 0; l < L; l++) {
+        endX[l] = packet.originX[l] + packet.directionX[l] * tMax[l];
+        endY[l] = packet.originY[l] + packet.directionY[l] * tMax[l];
+        normalX[l] = 0.0f;
+        normalY[l] = 1.0f;
+        fromIndex[l] = toIndex[l] = 1.0f;
+        if (!((packet.activeMask >> l) & 1u)) continue;
+
+        float laneIntensity = packet.intensityS[l] + packet.intensityP[l];
+        if (!emitSegment(context.pool, glm::vec2(packet.originX[l], packet.originY[l]),
+                         glm::vec2(endX[l], endY[l]), packet.wavelength[l], laneIntensity,
+                         packet.depth)) {
+            return tests;
+        }
+        if (hitPrimitive[l] < 0 || packet.depth >= context.settings.maxDepth) continue;
+
+        const OpticalPrimitive& prim = primitives[hitPrimitive[l]];
+        glm::vec2 normal = prim.type == OpticalPrimitive::Segment
+            ? glm::normalize(glm::vec2(prim.p1.y - prim.p0.y, prim.p0.x - prim.p1.x))
+            : (glm::vec2(endX[l], endY[l]) - prim.center) / prim.radius;
+        normalX[l] = normal.x;
+        normalY[l] = normal.y;
+        fromIndex[l] = context.laneIndices[prim.frontMaterial * L + l];
+        toIndex[l] = context.laneIndices[prim.backMaterial * L + l];
+        shadeMask |= 1u << l;
+    }
+
+    SpectralPacket transmitted, reflected;
+    transmitted.depth = reflected.depth = packet.depth + 1;
+    alignas(32) float transmittedPower[L], reflectedPower[L];
+    for (int l = 0; l < L; l++) {
+        float dx = packet.directionX[l];
+        float dy = packet.directionY[l];
+
+        // Face the normal against the ray and swap media when leaving.
+        // Everything below is straight-line selects; CMakeLists.txt builds this
+        // file with -fno-trapping-math so GCC is allowed to if-convert them.
+        bool leaving = dx * normalX[l] + dy * normalY[l] > 0.0f;
+        float nx = leaving ? -normalX[l] : normalX[l];
+        float ny = leaving ? -normalY[l] : normalY[l];
+        float nFrom = leaving ? toIndex[l] : fromIndex[l];
+        float nTo = leaving ? fromIndex[l] : toIndex[l];
+
+        float eta = nFrom / nTo;
+        float cosI = -(dx * nx + dy * ny);
+        float sinT2 = eta * eta * (1.0f - cosI * cosI);
+        float cosT = sqrtf(std::max(0.0f, 1.0f - sinT2));
+
+        // No select needed for total internal reflection: with cosT clamped
+        // to zero both reflectances come out as exactly 1
+        float sNum = nFrom * cosI - nTo * cosT;
+        float sDen = nFrom * cosI + nTo * cosT;
+        float pNum = nFrom * cosT - nTo * cosI;
+        float pDen = nFrom * cosT + nTo * cosI;
+        float rs = (sNum * sNum) / std::max(sDen * sDen, 1e-12f);
+        float rp = (pNum * pNum) / std::max(pDen * pDen, 1e-12f);
+
+        float tx = eta * dx + (eta * cosI - cosT) * nx;
+        float ty = eta * dy + (eta * cosI - cosT) * ny;
+        float tInv = 1.0f / sqrtf(std::max(tx * tx + ty * ty, 1e-12f));
+        float rx = dx + 2.0f * cosI * nx;
+        float ry = dy + 2.0f * cosI * ny;
+        float rInv = 1.0f / sqrtf(std::max(rx * rx + ry * ry, 1e-12f));
+
+        float is = packet.intensityS[l];
+        float ip = packet.intensityP[l];
+        transmitted.originX[l] = endX[l];
+        transmitted.originY[l] = endY[l];
+        transmitted.directionX[l] = tx * tInv;
+        transmitted.directionY[l] = ty * tInv;
+        transmitted.intensityS[l] = is * (1.0f - rs);
+        transmitted.intensityP[l] = ip * (1.0f - rp);
+        transmitted.wavelength[l] = packet.wavelength[l];
+        reflected.originX[l] = endX[l];
+        reflected.originY[l] = endY[l];
+        reflected.directionX[l] = rx * rInv;
+        reflected.directionY[l] = ry * rInv;
+        reflected.intensityS[l] = is * rs;
+        reflected.intensityP[l] = ip * rp;
+        reflected.wavelength[l] = packet.wavelength[l];
+        transmittedPower[l] = is * (1.0f - rs) + ip * (1.0f - rp);
+        reflectedPower[l] = is * rs + ip * rp;
+    }
+
+    transmitted.activeMask = reflected.activeMask = 0;
+    for (int l = 0; l < L; l++) {
+        if (!((shadeMask >> l) & 1u)) continue;
+        // Total internal reflection leaves exactly zero transmitted power
+        if (transmittedPower[l] > 0.0f && transmittedPower[l] >= context.laneCutoff) {
+            transmitted.activeMask |= 1u << l;
+        }
+        if (reflectedPower[l] > 0.0f && reflectedPower[l] >= context.laneCutoff) {
+            reflected.activeMask |= 1u << l;
+        }
+    }
+
+    // Inactive lanes carry finite leftovers, which is all the vector loops need
+    if (transmitted.activeMask) tests += tracePacket(context, transmitted);
+    if (reflected.activeMask) tests += tracePacket(context, reflected);
+    return tests;
+}
+}
+
+size_t traceSpectralBeam(const OpticalScene& scene, const glm::vec2& origin,
+                         const glm::vec2& direction, float intensityS, float intensityP, int wavelengthCount,
+                         const FresnelSettings& settings, SpectralSegmentPool& pool) {
+    int packetCount = (wavelengthCount + L - 1) / L;
+    int sampleCount = packetCount * L;
+    float laneS = intensityS / sampleCount, laneP = intensityP / sampleCount;
+    float laneIntensity = laneS + laneP;
+    // Reused across calls so steady-state tracing does not allocate
+    static thread_local std::vector<float> laneIndices;
+    const std::vector<OpticalMaterial>& materials = scene.getMaterials();
+    laneIndices.resize(materials.size() * L);
+    PacketContext context = { scene, settings, settings.intensityCutoff * laneIntensity,
+                              laneIndices.data(), pool };
+
+    glm::vec2 unitDirection = glm::normalize(direction);
+    size_t tests = 0;
+    for (int p = 0; p < packetCount; p++) {
+        SpectralPacket packet;
+        packet.activeMask = (1u << L) - 1u;
+        packet.depth = 0;
+        for (int l = 0; l < L; l++) {
+            // Stratified samples across the visible range
+            int sample = p * L + l;
+            packet.originX[l] = origin.x;
+            packet.originY[l] = origin.y;
+            packet.directionX[l] = unitDirection.x;
+            packet.directionY[l] = unitDirection.y;
+            packet.intensityS[l] = laneS;
+            packet.intensityP[l] = laneP;
+            packet.wavelength[l] = WAVELENGTH_MIN +
+                (WAVELENGTH_MAX - WAVELENGTH_MIN) * (sample + 0.5f) / sampleCount;
+            for (size_t m = 0; m < materials.size(); m++) {
+                laneIndices[m * L + l] = materials[m].dispersion.indexAt(packet.wavelength[l]);
+            }
+        }
+        tests += tracePacket(context, packet);
+    }
+    return tests;
+}
@@ -0,0 +1,288 @@
+#include "trajectory_log.h"
+#include "byte_stream.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+
+static const char LOG_MAGIC[4] = { 'P', 'V', 'T', 'L' };
+static const char BLOCK_MAGIC[4] = { 'B', 'L', 'K', '0' };
+static const char FOOTER_MAGIC[4] = { 'P', 'V', 'T', 'E' };
+static constexpr uint32_t LOG_VERSION = 1;
+static constexpr size_t COLUMN_COUNT = 6;   // id, time, x, y, vx, vy; all 4 bytes wide
+
+void TrajectoryWriter::open(const std::string& path, const TrajectoryMetadata& metadata) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Failed to create trajectory log: " + path);
+    }
+    this->path = path;
+    failed = false;
+    error.clear();
+
+    std::vector<uint8_t> header;
+    ByteWriter out(header);
+    out.putBytes(LOG_MAGIC, sizeof(LOG_MAGIC));
+    out.putU32(LOG_VERSION);
+    out.putU32(static_cast<uint32_t>(metadata.size()));
+    for (const auto& entry : metadata) {
+        out.putU32(static_cast<uint32_t>(entry.first.size()));
+        out.putBytes(entry.first.data(), entry.first.size());
+        out.putU32(static_cast<uint32_t>(entry.second.size()));
+        out.putBytes(entry.second.data(), entry.second.size());
+    }
+    header.resize((header.size() + 7) & ~size_t(7), 0);
+    if (fwrite(header.data(), 1, header.size(), file) != header.size()) {
+        fclose(file);
+        file = nullptr;
+        throw std::runtime_error("Failed to write trajectory log: " + path);
+    }
+    bytesWritten = header.size();
+    rows = 0;
+    blockOffsets.clear();
+
+    // Every block the log will ever use is allocated here
+    auto makeBlock = []() {
+        std::unique_ptr<Block> block(new Block);
+        for (std::vector<float>* column : { &block->time, &block->x, &block->y, &block->vx, &block->vy }) {
+            column->resize(BLOCK_ROWS);
+        }
+        block->id.resize(BLOCK_ROWS);
+        return block;
+    };
+    current = makeBlock();
+    for (int i = 1; i < BLOCK_POOL; i++) freeBlocks.push_back(makeBlock());
+
+    closing = false;
+    writer = std::thread(&TrajectoryWriter::writeBlocks, this);
+}
+
+void TrajectoryWriter::close() {
+    if (!file) return;
+    if (current && current->rows) submit();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        closing = true;
+    }
+    blockFilled.notify_one();
+    writer.join();
+
+    // No footer after a failed write: a reader walks whatever blocks made it
+    if (!failed) {
+        std::vector<uint8_t> footer;
+        ByteWriter out(footer);
+        for (uint64_t offset : blockOffsets) out.putU64(offset);
+        out.putU64(blockOffsets.size());
+        out.putBytes(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+        if (fwrite(footer.data(), 1, footer.size(), file) != footer.size()) fail();
+    }
+    // Buffered data reaches the disk here, so this can fail too
+    if (fclose(file) != 0) fail();
+    file = nullptr;
+
+    current.reset();
+    freeBlocks.clear();
+    fullBlocks.clear();
+}
+
+void TrajectoryWriter::append(uint32_t id, float time, float x, float y, float vx, float vy) {
+    Block& block = *current;
+    size_t row = block.rows++;
+    block.id[row] = id;
+    block.time[row] = time;
+    block.x[row] = x;
+    block.y[row] = y;
+    block.vx[row] = vx;
+    block.vy[row] = vy;
+    rows++;
+    if (block.rows == BLOCK_ROWS) submit();
+}
+
+void TrajectoryWriter::appendRange(uint32_t firstId, size_t count, float time,
+                                   const float* x, const float* y, const float* vx, const float* vy) {
+    // Column-wise copies into the block, split wherever a block fills up
+    size_t done = 0;
+    while (done < count) {
+        Block& block = *current;
+        size_t row = block.rows;
+        size_t n = std::min(count - done, BLOCK_ROWS - row);
+        for (size_t i = 0; i < n; i++) block.id[row + i] = static_cast<uint32_t>(firstId + done + i);
+        std::fill(block.time.begin() + row, block.time.begin() + row + n, time);
+        std::copy(x + done, x + done + n, block.x.begin() + row);
+        std::copy(y + done, y + done + n, block.y.begin() + row);
+        std::copy(vx + done, vx + done + n, block.vx.begin() + row);
+        std::copy(vy + done, vy + done + n, block.vy.begin() + row);
+        block.rows += n;
+        done += n;
+        if (block.rows == BLOCK_ROWS) submit();
+    }
+    rows += count;
+}
+
+void TrajectoryWriter::submit() {
+    // Hand the block over and take an empty one, waiting only if the
+    // writer has fallen a whole pool behind
+    std::unique_lock<std::mutex> guard(lock);
+    fullBlocks.push_back(std::move(current));
+    blockFilled.notify_one();
+    blockFreed.wait(guard, [&]() { return !freeBlocks.empty(); });
+    current = std::move(freeBlocks.back());
+    freeBlocks.pop_back();
+    current->rows = 0;
+}
+
+void TrajectoryWriter::writeBlocks() {
+    uint64_t offset = bytesWritten;
+    for (;;) {
+        std::unique_ptr<Block> block;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            blockFilled.wait(guard, [&]() { return !fullBlocks.empty() || closing; });
+            if (fullBlocks.empty()) return;
+            block = std::move(fullBlocks.front());
+            fullBlocks.erase(fullBlocks.begin());
+        }
+
+        // After a failed write the blocks are only recycled, so the
+        // simulation is never left waiting for a free one
+        if (!failed) {
+            uint32_t count = static_cast<uint32_t>(block->rows);
+            bool written = fwrite(BLOCK_MAGIC, 1, sizeof(BLOCK_MAGIC), file) == sizeof(BLOCK_MAGIC) &&
+                           fwrite(&count, sizeof(count), 1, file) == 1 &&
+                           fwrite(block->id.data(), sizeof(uint32_t), count, file) == count;
+            for (const std::vector<float>* column : { &block->time, &block->x, &block->y, &block->vx, &block->vy }) {
+                written = written && fwrite(column->data(), sizeof(float), count, file) == count;
+            }
+            if (written) {
+                blockOffsets.push_back(offset);
+                offset += 8 + COLUMN_COUNT * 4 * static_cast<uint64_t>(count);
+                bytesWritten = offset;
+            } else {
+                fail();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            freeBlocks.push_back(std::move(block));
+        }
+        blockFreed.notify_one();
+    }
+}
+
+void TrajectoryWriter::fail() {
+    if (failed) return;
+    error = "Failed to write trajectory log: " + path + " (" + std::strerror(errno) + ")";
+    failed = true;
+}
+
+void TrajectoryLog::open(const std::string& path) {
+    close();
+    file.open(path);
+    const uint8_t* data = file.data();
+    size_t size = file.size();
+    try {
+        ByteReader in(data, size);
+        if (std::memcmp(in.getBytes(sizeof(LOG_MAGIC)), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+            throw std::runtime_error("Not a trajectory log: " + path);
+        }
+        if (in.getU32() != LOG_VERSION) {
+            throw std::runtime_error("Unsupported trajectory log version: " + path);
+        }
+        uint32_t entries = in.getU32();
+        for (uint32_t i = 0; i < entries; i++) {
+            uint32_t keySize = in.getU32();
+            const uint8_t* key = in.getBytes(keySize);
+            uint32_t valueSize = in.getU32();
+            const uint8_t* value = in.getBytes(valueSize);
+            metadata.emplace_back(std::string(reinterpret_cast<const char*>(key), keySize),
+                                  std::string(reinterpret_cast<const char*>(value), valueSize));
+        }
+        size_t firstBlock = (static_cast<size_t>(in.position() - data) + 7) & ~size_t(7);
+
+        // Footer if the log was closed properly, else walk the blocks
+        bool indexed = false;
+        if (size >= firstBlock + 12 && std::memcmp(data + size - 4, FOOTER_MAGIC, 4) == 0) {
+            uint64_t count;
+            std::memcpy(&count, data + size - 12, sizeof(count));
+            if (count <= (size - firstBlock - 12) / 8) {
+                const uint8_t* offsets = data + size - 12 - count * 8;
+                for (uint64_t i = 0; i < count; i++) {
+                    uint64_t offset;
+                    std::memcpy(&offset, offsets + i * 8, sizeof(offset));
+                    // getBlock hands the columns out as float arrays in place
+                    if (offset % alignof(float) != 0) {
+                        throw std::runtime_error("Corrupt trajectory log: " + path);
+                    }
+                    blockOffsets.push_back(static_cast<size_t>(offset));
+                }
+                indexed = true;
+            }
+        }
+        if (!indexed) {
+            size_t offset = firstBlock;
+            while (offset + 8 <= size && std::memcmp(data + offset, BLOCK_MAGIC, 4) == 0) {
+                uint32_t count;
+                std::memcpy(&count, data + offset + 4, sizeof(count));
+                uint64_t length = 8 + COLUMN_COUNT * 4 * static_cast<uint64_t>(count);
+                if (length > size - offset) break;     // cut off mid-block
+                blockOffsets.push_back(offset);
+                offset += static_cast<size_t>(length);
+            }
+        }
+        for (size_t offset : blockOffsets) {
+            uint32_t count;
+            // The offsets come from the file, so compare against what is
+            // left rather than add to them
+            if (offset > size || size - offset < 8 || std::memcmp(data + offset, BLOCK_MAGIC, 4) != 0) {
+                throw std::runtime_error("Corrupt trajectory log: " + path);
+            }
+            std::memcpy(&count, data + offset + 4, sizeof(count));
+            if (COLUMN_COUNT * 4 * static_cast<uint64_t>(count) > size - offset - 8) {
+                throw std::runtime_error("Corrupt trajectory log: " + path);
+            }
+            rows += count;
+        }
+    } catch (const std::runtime_error&) {
+        close();
+        throw;
+    }
+}
+
+void TrajectoryLog::close() {
+    file.close();
+    metadata.clear();
+    blockOffsets.clear();
+    rows = 0;
+}
+
+std::string TrajectoryLog::getValue(const std::string& key) const {
+    for (const auto& entry : metadata) {
+        if (entry.first == key) return entry.second;
+    }
+    return std::string();
+}
+
+TrajectoryLog::Block TrajectoryLog::getBlock(size_t index) const {
+    // Blocks start 4-byte aligned in a page-aligned mapping, so the
+    // columns can be handed out as arrays in place
+    const uint8_t* start = file.data() + blockOffsets[index];
+    Block block;
+    uint32_t count;
+    std::memcpy(&count, start + 4, sizeof(count));
+    block.rows = count;
+    const uint8_t* column = start + 8;
+    block.id = reinterpret_cast<const uint32_t*>(column);
+    const float* columns[5];
+    for (int c = 0; c < 5; c++) {
+        columns[c] = reinterpret_cast<const float*>(column + (c + 1) * 4 * static_cast<size_t>(count));
+    }
+    block.time = columns[0];
+    block.x = columns[1];
+    block.y = columns[2];
+    block.vx = columns[3];
+    block.vy = columns[4];
+    return block;
+}
@@ -1,5 +1,5 @@
 #include "triangle_mesh.h"
-#include <OpenGL/gl.h>
+#include "render_backend.h"
 
 TriangleMesh::TriangleMesh() {
   // to draw quad using two traingles, we gonna reuse two points of the traingle
@@ -13,43 +13,38 @@ TriangleMesh::TriangleMesh() {
   // the Vertex Array Object combined/recordes VBO with attribute pointers
   // and when to draw, we can just bind VAO which will give VBO and its
   // attribute pointers.
-  glGenVertexArrays(1, &VAO);
-  glBindVertexArray(VAO);
+  VAO = RenderBackend::createVertexArray();
   VBOs.resize(2);
-  glGenBuffers(2, VBOs.data());
+  VBOs[0] = RenderBackend::createBuffer();
+  VBOs[1] = RenderBackend::createBuffer();
 
-  // binding VBO to GL_ARRAY_BUFFER, now we work with GL_ARRAY_BUFFER instead of
-  // VBO
+  // the backend edits the buffers and the VAO by name, without binding
+  // them when the context allows it
 
   // position
-  glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-  glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float),
-               positions.data(), GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 12, (void *)0);
-  glEnableVertexAttribArray(0);
+  RenderBackend::bufferData(VBOs[0], positions.size() * sizeof(float),
+                            positions.data(), GL_STATIC_DRAW);
+  RenderBackend::vertexAttribute(VAO, 0, VBOs[0], 3, GL_FLOAT, GL_FALSE, 12, 0);
 
   // color
-  glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-  glBufferData(GL_ARRAY_BUFFER, colorIndices.size() * sizeof(int),
-               colorIndices.data(), GL_STATIC_DRAW);
-
-  glVertexAttribIPointer(1, 1, GL_INT, 4, (void *)0);
-  glEnableVertexAttribArray(1);
-
-  // element buffer
-  glGenBuffers(1, &EBO);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementIndices.size() * sizeof(int),
-               elementIndices.data(), GL_STATIC_DRAW);
+  RenderBackend::bufferData(VBOs[1], colorIndices.size() * sizeof(int),
+                            colorIndices.data(), GL_STATIC_DRAW);
+  RenderBackend::vertexAttributeInteger(VAO, 1, VBOs[1], 1, GL_INT, 4, 0);
+
+  // element buffer, filled like any other buffer and then attached to the VAO
+  EBO = RenderBackend::createBuffer();
+  RenderBackend::bufferData(EBO, elementIndices.size() * sizeof(int),
+                            elementIndices.data(), GL_STATIC_DRAW);
+  RenderBackend::elementBuffer(VAO, EBO);
 }
 
 void TriangleMesh::draw() {
-  glBindVertexArray(VAO);
+  RenderBackend::bindVertexArray(VAO);
   glDrawElements(GL_TRIANGLES, vertex_count, GL_UNSIGNED_INT, 0);
 }
 
 TriangleMesh::~TriangleMesh() {
-  glDeleteVertexArrays(1, &VAO);
-  glDeleteBuffers(2, VBOs.data());
-  glDeleteBuffers(1, &EBO);
+  RenderBackend::deleteVertexArrays(1, &VAO);
+  RenderBackend::deleteBuffers(2, VBOs.data());
+  RenderBackend::deleteBuffers(1, &EBO);
 }